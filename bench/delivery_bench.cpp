@@ -0,0 +1,132 @@
+// Delivery latency benchmark: connect-per-message vs pooled connections.
+//
+// Starts a local TcpServer acting as a subscriber and delivers the same
+// serialized message N times, first the old way (connect, send, disconnect
+// for every message) and then through SubscriberConnectionPool.
+//
+// Usage: ./bench_delivery [messages] [port]
+
+#include "core/SubscriberConnectionPool.h"
+#include "Network.h"
+#include "Serialization.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+using Clock = std::chrono::steady_clock;
+
+struct LatencyStats {
+    double avgUs;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    double msgsPerSec;
+};
+
+static LatencyStats computeStats(std::vector<double>& samplesUs, double totalSeconds) {
+    std::sort(samplesUs.begin(), samplesUs.end());
+
+    LatencyStats stats;
+    double sum = 0;
+    for (double s : samplesUs) {
+        sum += s;
+    }
+    stats.avgUs = sum / samplesUs.size();
+    stats.p50Us = samplesUs[samplesUs.size() / 2];
+    stats.p99Us = samplesUs[(samplesUs.size() * 99) / 100];
+    stats.maxUs = samplesUs.back();
+    stats.msgsPerSec = samplesUs.size() / totalSeconds;
+    return stats;
+}
+
+static void printStats(const std::string& name, const LatencyStats& stats) {
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << stats.avgUs
+              << std::setw(10) << stats.p50Us
+              << std::setw(10) << stats.p99Us
+              << std::setw(12) << stats.maxUs
+              << std::setw(14) << stats.msgsPerSec << std::endl;
+}
+
+// Deliver `count` frames with `deliver` and wait until the sink has seen them all
+static LatencyStats runCase(int count, TcpServer& sink, const std::function<bool()>& deliver) {
+    std::vector<double> samples;
+    samples.reserve(count);
+
+    auto start = Clock::now();
+    for (int i = 0; i < count; i++) {
+        auto t0 = Clock::now();
+        if (!deliver()) {
+            std::cerr << "delivery failed at message " << i << std::endl;
+        }
+        auto t1 = Clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+
+    int received = 0;
+    auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (received < count && Clock::now() < deadline) {
+        if (!sink.receiveMessage().empty()) {
+            received++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (received < count) {
+        std::cerr << "sink received only " << received << " of " << count << " frames" << std::endl;
+    }
+    return computeStats(samples, seconds);
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 2000;
+    int port = argc > 2 ? std::stoi(argv[2]) : 4290;
+
+    TcpServer sink;
+    if (!sink.start(port)) {
+        std::cerr << "Failed to start sink on port " << port << std::endl;
+        return 1;
+    }
+
+    Message msg("Analog/MER/220", MessageType::ANALOG, TopicType::MER, 220.5f);
+    strncpy(msg.publisher_host, "localhost", Message::MAX_HOST_LEN - 1);
+    msg.publisher_port = 4101;
+    std::vector<uint8_t> frame = Serialization::serialize(msg);
+
+    std::cout << "Delivering " << count << " messages of " << frame.size()
+              << " bytes to localhost:" << port << std::endl << std::endl;
+    std::cout << std::left << std::setw(22) << "mode" << std::right
+              << std::setw(10) << "avg(us)"
+              << std::setw(10) << "p50(us)"
+              << std::setw(10) << "p99(us)"
+              << std::setw(12) << "max(us)"
+              << std::setw(14) << "msgs/s" << std::endl;
+
+    LatencyStats perMessage = runCase(count, sink, [&]() {
+        TcpClient client;
+        if (!client.connect("localhost", port)) {
+            return false;
+        }
+        bool ok = client.sendMessage(frame);
+        client.disconnect();
+        return ok;
+    });
+    printStats("connect-per-message", perMessage);
+
+    SubscriberConnectionPool pool;
+    LatencyStats pooled = runCase(count, sink, [&]() {
+        return pool.send(port, frame);
+    });
+    printStats("pooled", pooled);
+
+    std::cout << std::endl << "Average delivery latency speedup: " << std::setprecision(1)
+              << perMessage.avgUs / pooled.avgUs << "x" << std::endl;
+
+    pool.clear();
+    sink.stop();
+    return 0;
+}
@@ -0,0 +1,271 @@
+// End-to-end latency benchmark: publish -> engine -> subscriber.
+//
+// Runs a PubSubEngine, M publishers and up to 16 subscriber sinks in one
+// process over loopback, so every hop shares one steady clock. Each message
+// carries its scheduled send time in nanoseconds in the 8-byte timestamp
+// field (which every wire format passes through untouched), and each sink
+// records arrival minus that stamp in an HdrHistogram. Stamping the
+// scheduled time rather than the actual send time keeps publisher backlog
+// in the numbers (no coordinated omission).
+//
+// One case per (fan-out, rate) pair: the first `fan-out` sinks subscribe
+// to a fresh topic, the publishers share the target rate, and after the
+// run the bench waits for the last deliveries before reading the sinks.
+// Engine console output is discarded while the bench runs.
+//
+// Usage: ./bench_e2e [seconds per case] [publishers] [shards]
+
+#include "core/PubSubEngine.h"
+#include "core/Publisher.h"
+#include "core/LoadGenerator.h"
+#include "DataStructures/HdrHistogram.h"
+#include "Network.h"
+#include "Serialization.h"
+#include "utils/Logger.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+using Clock = std::chrono::steady_clock;
+
+static const int FAN_OUTS[] = {1, 4, 16};
+static const double RATES[] = {1000, 10000, 50000};
+static const int MAX_FAN_OUT = 16;
+
+static uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Subscriber endpoint that timestamps frames on its I/O thread
+struct Sink {
+    int port;
+    TcpServer server;
+    std::mutex mutex;
+    HdrHistogram latency;
+    std::atomic<uint64_t> received{0};
+
+    explicit Sink(int sinkPort) : port(sinkPort) {
+        server.setIoThreads(1);
+        server.setFrameSink([this](int, SOCKET, std::vector<uint8_t>&& frame) {
+            uint64_t arrived = nowNs();
+            long stamp;
+            if (!Serialization::peekTimestamp(frame.data(), frame.size(), stamp)) {
+                return true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                latency.record(arrived > (uint64_t)stamp ? arrived - (uint64_t)stamp : 0);
+            }
+            received.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        latency.reset();
+        received = 0;
+    }
+};
+
+struct CaseResult {
+    uint64_t sent = 0;
+    uint64_t delivered = 0;
+    double publishSec = 0;
+    double deliverSec = 0;
+    HdrHistogram latency;
+};
+
+static std::vector<uint8_t> makeSubscribe(int port, const std::string& topic) {
+    std::vector<uint8_t> frame;
+    frame.push_back(1); // SUBSCRIBE command
+    frame.push_back((port >> 24) & 0xFF);
+    frame.push_back((port >> 16) & 0xFF);
+    frame.push_back((port >> 8) & 0xFF);
+    frame.push_back(port & 0xFF);
+    frame.push_back((uint8_t)topic.length());
+    frame.insert(frame.end(), topic.begin(), topic.end());
+    return frame;
+}
+
+// One publisher's share of the rate until `end`: its message i is due at
+// start + (i * publishers + index) / rate
+static void publishPaced(Publisher& publisher, uint32_t topicId, const std::string& topic, int index,
+                         int publishers, double rate, Clock::time_point start, Clock::time_point end,
+                         uint64_t& sent) {
+    Message msg(topic.c_str(), MessageType::ANALOG, TopicType::MER, 220.0f);
+    strncpy(msg.publisher_host, "localhost", Message::MAX_HOST_LEN - 1);
+
+    std::chrono::duration<double> interval(publishers / rate);
+    auto first = start + std::chrono::duration_cast<Clock::duration>(interval * ((double)index / publishers));
+    for (uint64_t i = 0;; i++) {
+        auto scheduled = first + std::chrono::duration_cast<Clock::duration>(interval * (double)i);
+        if (scheduled >= end) {
+            break;
+        }
+        LoadGenerator::waitUntil(scheduled);
+
+        msg.timestamp = (std::time_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            scheduled.time_since_epoch()).count();
+        msg.data.analogValue = (float)(i % 1000);
+        publisher.publish(topicId, msg);
+        sent++;
+    }
+}
+
+static CaseResult runCase(int caseIndex, int fanOut, double rate, int seconds,
+                          std::vector<std::unique_ptr<Publisher>>& publishers,
+                          std::vector<std::unique_ptr<Sink>>& sinks, TcpClient& control) {
+    std::string topic = "Bench/E2E/" + std::to_string(caseIndex);
+    for (int s = 0; s < fanOut; s++) {
+        control.sendMessage(makeSubscribe(sinks[s]->port, topic));
+    }
+    std::vector<uint32_t> ids;
+    for (auto& publisher : publishers) {
+        ids.push_back(publisher->registerTopic(topic.c_str()));
+    }
+
+    // Warm-up message so connections to the sinks exist before measuring
+    Message warmup(topic.c_str(), MessageType::ANALOG, TopicType::MER, 0.0f, (std::time_t)nowNs());
+    strncpy(warmup.publisher_host, "localhost", Message::MAX_HOST_LEN - 1);
+    publishers[0]->publish(ids[0], warmup);
+    auto warmDeadline = Clock::now() + std::chrono::seconds(2);
+    for (int s = 0; s < fanOut; s++) {
+        while (sinks[s]->received == 0 && Clock::now() < warmDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    for (auto& sink : sinks) {
+        sink->reset();
+    }
+
+    CaseResult result;
+    std::vector<uint64_t> sent(publishers.size(), 0);
+    std::vector<std::thread> threads;
+    auto start = Clock::now() + std::chrono::milliseconds(50);
+    auto end = start + std::chrono::seconds(seconds);
+    for (size_t p = 0; p < publishers.size(); p++) {
+        threads.emplace_back(publishPaced, std::ref(*publishers[p]), ids[p], std::cref(topic), (int)p,
+                             (int)publishers.size(), rate, start, end, std::ref(sent[p]));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    result.publishSec = std::chrono::duration<double>(Clock::now() - start).count();
+    for (uint64_t n : sent) {
+        result.sent += n;
+    }
+
+    // Wait for the tail; give up once nothing has arrived for a second
+    uint64_t expected = result.sent * (uint64_t)fanOut;
+    uint64_t lastSeen = 0;
+    auto lastProgress = Clock::now();
+    for (;;) {
+        uint64_t seen = 0;
+        for (int s = 0; s < fanOut; s++) {
+            seen += sinks[s]->received;
+        }
+        if (seen >= expected) {
+            break;
+        }
+        if (seen != lastSeen) {
+            lastSeen = seen;
+            lastProgress = Clock::now();
+        } else if (Clock::now() - lastProgress > std::chrono::seconds(1)) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    result.deliverSec = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (int s = 0; s < fanOut; s++) {
+        std::lock_guard<std::mutex> lock(sinks[s]->mutex);
+        result.latency.merge(sinks[s]->latency);
+        result.delivered += sinks[s]->received;
+    }
+    return result;
+}
+
+static void printRow(std::ostream& out, int fanOut, double rate, const CaseResult& r) {
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    uint64_t expected = r.sent * (uint64_t)fanOut;
+    out << std::right << std::fixed << std::setprecision(0)
+        << std::setw(7) << fanOut
+        << std::setw(10) << rate
+        << std::setw(12) << (r.publishSec > 0 ? r.sent / r.publishSec : 0)
+        << std::setw(13) << (r.deliverSec > 0 ? r.delivered / r.deliverSec : 0)
+        << std::setw(9) << (expected > r.delivered ? expected - r.delivered : 0)
+        << std::setprecision(1)
+        << std::setw(11) << us(r.latency.percentile(50))
+        << std::setw(11) << us(r.latency.percentile(99))
+        << std::setw(11) << us(r.latency.percentile(99.9))
+        << std::setw(12) << us(r.latency.getMax()) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int seconds = argc > 1 ? std::max(std::stoi(argv[1]), 1) : 2;
+    int publisherCount = argc > 2 ? std::max(std::stoi(argv[2]), 1) : 2;
+    int shards = argc > 3 ? std::stoi(argv[3]) : 0;
+
+    // The engine logs every message at DEBUG; keep that off the measured path
+    Logger::setLevel(LogLevel::WARN);
+
+    PubSubEngine engine(0, shards);
+    engine.start();
+
+    std::vector<std::unique_ptr<Sink>> sinks;
+    for (int i = 0; i < MAX_FAN_OUT; i++) {
+        sinks.emplace_back(new Sink(PortPool::getNextSubscriberPort()));
+        if (!sinks.back()->server.start(sinks.back()->port)) {
+            std::cerr << "Failed to start sink on port " << sinks.back()->port << std::endl;
+            return 1;
+        }
+    }
+
+    TcpClient control;
+    if (!control.connect("localhost", PortPool::getEnginePort())) {
+        std::cerr << "Failed to connect to the engine on port " << PortPool::getEnginePort() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Publisher>> publishers;
+    for (int i = 0; i < publisherCount; i++) {
+        publishers.emplace_back(new Publisher(i + 1, "localhost", PortPool::getEnginePort()));
+        publishers.back()->setVerbose(false);
+        if (!publishers.back()->open()) {
+            std::cerr << "Publisher " << (i + 1) << " failed to connect" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "End-to-end latency: " << publisherCount << " publisher(s), " << seconds << " s per case, "
+        << (shards > 0 ? std::to_string(shards) + " shard(s)" : std::string("unsharded")) << std::endl << std::endl;
+    std::cout << std::setw(7) << "fanout" << std::setw(10) << "rate" << std::setw(12) << "pub msg/s"
+        << std::setw(13) << "dlv msg/s" << std::setw(9) << "lost"
+        << std::setw(11) << "p50(us)" << std::setw(11) << "p99(us)"
+        << std::setw(11) << "p99.9(us)" << std::setw(12) << "max(us)" << std::endl;
+
+    int caseIndex = 0;
+    for (int fanOut : FAN_OUTS) {
+        for (double rate : RATES) {
+            CaseResult result = runCase(caseIndex++, fanOut, rate, seconds, publishers, sinks, control);
+            printRow(std::cout, fanOut, rate, result);
+        }
+    }
+
+    for (auto& publisher : publishers) {
+        publisher->stop();
+    }
+    control.disconnect();
+    engine.stop();
+    for (auto& sink : sinks) {
+        sink->server.stop();
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Microbenchmarks for the per-message primitives, with JSON output.
+//
+// Each case runs its operation in batches until the time budget is used,
+// repeats that a few times and reports the median and best ns/op. Results
+// go to stdout as one JSON document so runs from two releases can be
+// diffed by a script; progress goes to stderr.
+//
+// Cases: Serialization (v1 serialize/deserialize, v2 encode/MessageView),
+// CircularBuffer<Message> push/pop, LinkedList<SubscriberAddress>::contains
+// on subscriber lists of several sizes, TopicTable hit/miss lookups at
+// several load factors, MessageValidator::validate and
+// MessageFormatter::formatAsString.
+//
+// Usage: ./bench_micro [ms per repetition] [repetitions] > results.json
+
+#include "Serialization.h"
+#include "MessageView.h"
+#include "core/SubscriberAddress.h"
+#include "DataStructures/CircularBuffer.h"
+#include "DataStructures/LinkedList.h"
+#include "DataStructures/TopicTable.h"
+#include "utils/MessageValidator.h"
+#include "utils/MessageFormatter.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+// Results are folded into this so the compiler cannot drop the work
+static volatile uint64_t sink;
+
+struct Result {
+    std::string name;
+    std::string param;
+    uint64_t iterations;
+    double nsPerOp;       // Median over repetitions
+    double nsPerOpMin;    // Best repetition
+};
+
+static int budgetMs = 200;
+static int repetitions = 5;
+static std::vector<Result> results;
+
+// Run op(i) in batches for the time budget, `repetitions` times
+static void run(const std::string& name, const std::string& param, const std::function<uint64_t(uint64_t)>& op) {
+    std::cerr << "  " << name << (param.empty() ? "" : " [" + param + "]") << std::endl;
+
+    const uint64_t batch = 1024;
+    uint64_t i = 0;
+    uint64_t total = 0;
+    std::vector<double> samples;
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t done = 0;
+        uint64_t acc = 0;
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::milliseconds(budgetMs);
+        Clock::time_point now;
+        do {
+            for (uint64_t b = 0; b < batch; b++) {
+                acc += op(i++);
+            }
+            done += batch;
+            now = Clock::now();
+        } while (now < deadline);
+        sink = sink + acc;
+        samples.push_back(std::chrono::duration<double, std::nano>(now - start).count() / done);
+        total += done;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.param = param;
+    result.iterations = total;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.nsPerOpMin = samples.front();
+    results.push_back(result);
+}
+
+static Message makeMessage(int i) {
+    Message msg("Analog/MER/220", MessageType::ANALOG, TopicType::MER, 220.5f + (float)(i % 100));
+    strncpy(msg.publisher_host, "localhost", Message::MAX_HOST_LEN - 1);
+    msg.publisher_port = 4101;
+    return msg;
+}
+
+static std::string makeTopic(size_t i) {
+    static const char* prefixes[] = { "Analog/MER/", "Status/SWG/", "Status/CRB/" };
+    return std::string(prefixes[i % 3]) + std::to_string(i / 3);
+}
+
+static void benchSerialization() {
+    Message msg = makeMessage(0);
+    std::vector<uint8_t> v1 = Serialization::serialize(msg);
+    std::vector<uint8_t> v2 = Serialization::encode(msg);
+    std::vector<uint8_t> buffer(Serialization::encodedSize(msg));
+
+    run("serialization.serialize_v1", "", [&](uint64_t i) {
+        msg.data.analogValue = (float)(i & 1023);
+        return (uint64_t)Serialization::serialize(msg).size();
+    });
+    run("serialization.deserialize_v1", "", [&](uint64_t) {
+        return (uint64_t)Serialization::deserialize(v1.data(), v1.size()).publisher_port;
+    });
+    run("serialization.encode_v2", "", [&](uint64_t i) {
+        msg.data.analogValue = (float)(i & 1023);
+        return (uint64_t)Serialization::encode(msg, buffer.data(), buffer.size());
+    });
+    run("serialization.deserialize_v2", "", [&](uint64_t) {
+        return (uint64_t)Serialization::deserialize(v2.data(), v2.size()).publisher_port;
+    });
+    run("serialization.view_v2", "", [&](uint64_t) {
+        MessageView view(v2.data(), v2.size());
+        return (uint64_t)view.topic().size() + (uint64_t)view.timestamp();
+    });
+}
+
+static void benchCircularBuffer() {
+    CircularBuffer<Message> buffer(50);
+    Message msg = makeMessage(0);
+    Message out;
+
+    run("circular_buffer.push", "capacity=50", [&](uint64_t i) {
+        msg.publisher_port = (int)i;
+        buffer.push(msg);
+        return (uint64_t)buffer.size();
+    });
+    buffer.clear();
+    run("circular_buffer.push_pop", "capacity=50", [&](uint64_t i) {
+        msg.publisher_port = (int)i;
+        buffer.push(msg);
+        buffer.pop(out);
+        return (uint64_t)out.publisher_port;
+    });
+}
+
+static void benchSubscriberList() {
+    for (int size : { 1, 16, 256 }) {
+        LinkedList<SubscriberAddress> subscribers;
+        for (int p = 0; p < size; p++) {
+            subscribers.pushBack(SubscriberAddress(5100 + p));
+        }
+        // Half the probes are present (spread over the list), half are not
+        run("linked_list.contains", "subscribers=" + std::to_string(size), [&](uint64_t i) {
+            int port = (i & 1) ? 5100 + (int)((i >> 1) % size) : 9000;
+            return (uint64_t)subscribers.contains(SubscriberAddress(port));
+        });
+    }
+}
+
+static void benchTopicLookup() {
+    const size_t capacity = 1 << 16;
+    for (double load : { 0.25, 0.5, 0.75, 0.85 }) {
+        // Stay below the grow threshold so the table keeps this load factor
+        size_t count = std::min((size_t)(capacity * load), (size_t)(capacity * 0.85) - 1);
+        TopicTable<int> table(capacity);
+        std::vector<std::string> keys;
+        std::vector<std::string> missing;
+        for (size_t i = 0; i < count; i++) {
+            keys.push_back(makeTopic(i));
+            missing.push_back("Missing/" + makeTopic(i));
+            table.insert(keys.back().c_str(), (int)i);
+        }
+        while (table.isMigrating()) {
+            table.advanceMigration();
+        }
+
+        char loadParam[32];
+        snprintf(loadParam, sizeof(loadParam), "load=%.2f", (double)table.size() / table.capacity());
+        // Fixed stride over the keys instead of a shuffle: no extra loads per lookup
+        const size_t stride = 7919;
+        run("topic_table.find_hit", loadParam, [&](uint64_t i) {
+            int* v = table.find(keys[(i * stride) % count].c_str());
+            return (uint64_t)(v ? *v : 0);
+        });
+        run("topic_table.find_miss", loadParam, [&](uint64_t i) {
+            return (uint64_t)(table.find(missing[(i * stride) % count].c_str()) != nullptr);
+        });
+    }
+}
+
+static void benchValidationAndFormatting() {
+    Message analog = makeMessage(0);
+    Message status("Status/SWG/1", MessageType::STATUS, TopicType::SWG, 0.0f);
+    status.data.statusValue = StatusValue::SWG_OPEN;
+    std::string error;
+
+    run("message_validator.validate", "type=analog", [&](uint64_t i) {
+        analog.data.analogValue = (float)(i & 1023);
+        return (uint64_t)MessageValidator::validate(analog, error);
+    });
+    run("message_validator.validate", "type=status", [&](uint64_t) {
+        return (uint64_t)MessageValidator::validate(status, error);
+    });
+    run("message_formatter.format_as_string", "type=analog", [&](uint64_t i) {
+        analog.data.analogValue = (float)(i & 1023);
+        return (uint64_t)MessageFormatter::formatAsString(analog).size();
+    });
+    run("message_formatter.format_as_string", "type=status", [&](uint64_t) {
+        return (uint64_t)MessageFormatter::formatAsString(status).size();
+    });
+}
+
+static void printJson() {
+    std::cout << "{\n";
+    std::cout << "  \"suite\": \"pubsub-micro\",\n";
+#ifdef __VERSION__
+    std::cout << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+#endif
+#ifdef __OPTIMIZE__
+    std::cout << "  \"optimized\": true,\n";
+#else
+    std::cout << "  \"optimized\": false,\n";
+#endif
+    std::cout << "  \"ms_per_repetition\": " << budgetMs << ",\n";
+    std::cout << "  \"repetitions\": " << repetitions << ",\n";
+    std::cout << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::cout << "    {\"name\": \"" << r.name << "\", \"param\": \"" << r.param << "\""
+                  << ", \"iterations\": " << r.iterations
+                  << std::fixed << std::setprecision(2)
+                  << ", \"ns_per_op\": " << r.nsPerOp
+                  << ", \"ns_per_op_min\": " << r.nsPerOpMin
+                  << std::setprecision(0)
+                  << ", \"ops_per_sec\": " << (r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0) << "}"
+                  << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        budgetMs = std::max(std::stoi(argv[1]), 1);
+    }
+    if (argc > 2) {
+        repetitions = std::max(std::stoi(argv[2]), 1);
+    }
+
+    std::cerr << "Running microbenchmarks (" << repetitions << " x " << budgetMs << " ms each)" << std::endl;
+    benchSerialization();
+    benchCircularBuffer();
+    benchSubscriberList();
+    benchTopicLookup();
+    benchValidationAndFormatting();
+
+    printJson();
+    return 0;
+}
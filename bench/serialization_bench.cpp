@@ -0,0 +1,98 @@
+// Wire format benchmark: protocol version 1 vs version 2.
+//
+// Measures, per message, encoding (v1 serialize into a fresh vector vs v2
+// encode into a reused buffer), full decoding into a Message, and reading
+// the topic + value through a MessageView without copying. Also checks that
+// both versions decode to the same fields.
+//
+// Usage: ./bench_serialization [iterations]
+
+#include "Serialization.h"
+#include "MessageView.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static void printRow(const char* name, double ns) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10) << ns << " ns/msg" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 2000000;
+
+    Message msg("Analog/MER/220", MessageType::ANALOG, TopicType::MER, 220.5f);
+    strcpy(msg.publisher_host, "localhost");
+    msg.publisher_port = 4101;
+
+    std::vector<uint8_t> v1 = Serialization::serialize(msg);
+    std::vector<uint8_t> v2 = Serialization::encode(msg);
+
+    Message a = Serialization::deserialize(v1.data(), v1.size());
+    Message b = Serialization::deserialize(v2.data(), v2.size());
+    bool same = strcmp(a.topic, b.topic) == 0 && strcmp(a.publisher_host, b.publisher_host) == 0 &&
+                a.publisher_port == b.publisher_port && a.type == b.type && a.topicType == b.topicType &&
+                a.data.analogValue == b.data.analogValue && a.timestamp == b.timestamp;
+
+    std::cout << "Serialization benchmark (" << iterations << " iterations)" << std::endl;
+    std::cout << "  message size: v1 " << v1.size() << " B, v2 " << v2.size() << " B, decoded Message "
+              << sizeof(Message) << " B, round trip " << (same ? "OK" : "MISMATCH") << std::endl;
+
+    long checksum = 0;
+
+    auto start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        msg.timestamp = i;
+        std::vector<uint8_t> out = Serialization::serialize(msg);
+        checksum += out[out.size() - 1];
+    }
+    printRow("encode v1 (serialize)", nsSince(start) / iterations);
+
+    std::vector<uint8_t> buffer(Serialization::encodedSize(msg));
+    start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        msg.timestamp = i;
+        checksum += Serialization::encode(msg, buffer.data(), buffer.size());
+    }
+    printRow("encode v2 (into reused buffer)", nsSince(start) / iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        Message m = Serialization::deserialize(v1.data(), v1.size());
+        checksum += m.publisher_port;
+    }
+    printRow("decode v1 -> Message", nsSince(start) / iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        Message m = Serialization::deserialize(v2.data(), v2.size());
+        checksum += m.publisher_port;
+    }
+    printRow("decode v2 -> Message", nsSince(start) / iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        MessageView view(v1.data(), v1.size());
+        checksum += view.topic().size() + (long)view.analogValue();
+    }
+    printRow("MessageView v1 (topic + value)", nsSince(start) / iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; i++) {
+        MessageView view(v2.data(), v2.size());
+        checksum += view.topic().size() + (long)view.analogValue();
+    }
+    printRow("MessageView v2 (topic + value)", nsSince(start) / iterations);
+
+    std::cout << "  (checksum " << checksum << ")" << std::endl;
+    return same ? 0 : 1;
+}
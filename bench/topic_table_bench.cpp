@@ -0,0 +1,173 @@
+// Topic table benchmark at 1k, 100k and 1M topics.
+//
+// Measures insert cost (average and worst single insert, which shows that
+// incremental rehashing never stalls for a full resize), lookup hits and
+// lookup misses for TopicTable, the engine's topic -> entry table. Before
+// measuring, checks that every key stays findable through each step of an
+// incremental migration (exits with 1 if not).
+//
+// Usage: ./bench_topic_table [topicCount...]
+
+#include "DataStructures/TopicTable.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Topic names shaped like the engine's ("Analog/MER/220", "Status/SWG/1")
+static std::string makeTopic(size_t i) {
+    static const char* prefixes[] = { "Analog/MER/", "Status/SWG/", "Status/CRB/" };
+    return std::string(prefixes[i % 3]) + std::to_string(i / 3);
+}
+
+// Correctness check for incremental growth: after every insert and every
+// single migration step, each key inserted so far must still be found with
+// its value, re-inserting it must not add a copy, and no key may be counted
+// twice. O(n^2), so keep count small.
+static bool verifyMigration(size_t count) {
+    TopicTable<int> table;
+    std::vector<std::string> keys;
+    keys.reserve(count);
+
+    auto checkAll = [&](const char* when) {
+        if (table.size() != keys.size()) {
+            std::cerr << "verify: size " << table.size() << " != " << keys.size()
+                      << " (" << when << ")" << std::endl;
+            return false;
+        }
+        for (size_t j = 0; j < keys.size(); j++) {
+            int* v = table.find(keys[j].c_str());
+            if (v == nullptr || *v != (int)j) {
+                std::cerr << "verify: \"" << keys[j] << "\" lost after " << keys.size()
+                          << " inserts (" << when << ")" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(makeTopic(i));
+        bool inserted = false;
+        table.insert(keys[i].c_str(), (int)i, &inserted);
+        if (!inserted) {
+            std::cerr << "verify: \"" << keys[i] << "\" reported as present" << std::endl;
+            return false;
+        }
+        if (!checkAll("insert")) {
+            return false;
+        }
+
+        // Walk an in-progress migration one bucket at a time
+        while (table.isMigrating() && i % 7 == 0) {
+            table.advanceMigration(1);
+            if (!checkAll("migration step")) {
+                return false;
+            }
+        }
+
+        // Re-inserting an existing key must find it, not duplicate it
+        size_t probe = i / 2;
+        table.insert(keys[probe].c_str(), -1, &inserted);
+        if (inserted) {
+            std::cerr << "verify: \"" << keys[probe] << "\" inserted twice" << std::endl;
+            return false;
+        }
+    }
+    return checkAll("end");
+}
+
+static void runBenchmark(size_t count) {
+    std::vector<std::string> keys;
+    std::vector<std::string> missing;
+    keys.reserve(count);
+    missing.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(makeTopic(i));
+        missing.push_back("Missing/" + makeTopic(i));
+    }
+
+    TopicTable<int> table;
+
+    // Inserts, tracking the slowest single insert
+    double worstInsertNs = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        auto t0 = Clock::now();
+        table.insert(keys[i].c_str(), (int)i);
+        double ns = nsSince(t0);
+        if (ns > worstInsertNs) {
+            worstInsertNs = ns;
+        }
+    }
+    double insertNs = nsSince(start) / count;
+
+    // Lookups in random order
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    long checksum = 0;
+    start = Clock::now();
+    for (size_t i : order) {
+        int* v = table.find(keys[i].c_str());
+        checksum += v ? *v : 0;
+    }
+    double hitNs = nsSince(start) / count;
+
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t i : order) {
+        found += table.find(missing[i].c_str()) != nullptr;
+    }
+    double missNs = nsSince(start) / count;
+
+    std::cout << std::setw(10) << count
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << insertNs
+              << std::setw(16) << worstInsertNs / 1000.0
+              << std::setw(12) << hitNs
+              << std::setw(12) << missNs
+              << std::setw(12) << table.capacity()
+              << std::setprecision(2) << std::setw(8) << (double)table.size() / table.capacity()
+              << (checksum < 0 || found ? "  (check failed)" : "") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(std::stoul(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = { 1000, 100000, 1000000 };
+    }
+
+    if (!verifyMigration(3000)) {
+        std::cerr << "TopicTable lost keys during incremental migration" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "topics"
+              << std::setw(14) << "insert(ns)"
+              << std::setw(16) << "worst ins(us)"
+              << std::setw(12) << "hit(ns)"
+              << std::setw(12) << "miss(ns)"
+              << std::setw(12) << "capacity"
+              << std::setw(8) << "load" << std::endl;
+
+    for (size_t count : counts) {
+        runBenchmark(count);
+    }
+    return 0;
+}
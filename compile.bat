@@ -52,10 +52,58 @@ echo Compiling src/utils/MessageFormatter.cpp...
 g++ %CXXFLAGS% -c src/utils/MessageFormatter.cpp -o src/utils/MessageFormatter.o
 if errorlevel 1 goto :error
 
+echo Compiling src/core/SubscriberConnectionPool.cpp...
+g++ %CXXFLAGS% -c src/core/SubscriberConnectionPool.cpp -o src/core/SubscriberConnectionPool.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/DeliveryExecutor.cpp...
+g++ %CXXFLAGS% -c src/core/DeliveryExecutor.cpp -o src/core/DeliveryExecutor.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/EngineShard.cpp...
+g++ %CXXFLAGS% -c src/core/EngineShard.cpp -o src/core/EngineShard.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/TopicHistory.cpp...
+g++ %CXXFLAGS% -c src/core/TopicHistory.cpp -o src/core/TopicHistory.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/MessageLog.cpp...
+g++ %CXXFLAGS% -c src/core/MessageLog.cpp -o src/core/MessageLog.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/LogCompactor.cpp...
+g++ %CXXFLAGS% -c src/core/LogCompactor.cpp -o src/core/LogCompactor.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/TopicRegistry.cpp...
+g++ %CXXFLAGS% -c src/core/TopicRegistry.cpp -o src/core/TopicRegistry.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/PublishBatcher.cpp...
+g++ %CXXFLAGS% -c src/core/PublishBatcher.cpp -o src/core/PublishBatcher.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/PublishOutbox.cpp...
+g++ %CXXFLAGS% -c src/core/PublishOutbox.cpp -o src/core/PublishOutbox.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/LoadGenerator.cpp...
+g++ %CXXFLAGS% -c src/core/LoadGenerator.cpp -o src/core/LoadGenerator.o
+if errorlevel 1 goto :error
+
+echo Compiling src/core/EngineMetrics.cpp...
+g++ %CXXFLAGS% -c src/core/EngineMetrics.cpp -o src/core/EngineMetrics.o
+if errorlevel 1 goto :error
+
+echo Compiling src/utils/Logger.cpp...
+g++ %CXXFLAGS% -c src/utils/Logger.cpp -o src/utils/Logger.o
+if errorlevel 1 goto :error
+
 REM Link all object files
 echo.
 echo Linking...
-g++ %CXXFLAGS% -o pubsub.exe src/main.o src/Network.o src/core/Publisher.o src/core/Subscriber.o src/core/PubSubEngine.o src/utils/MessageValidator.o src/utils/CommandLineParser.o src/utils/NetworkUtils.o src/utils/MessageFormatter.o -lws2_32
+g++ %CXXFLAGS% -o pubsub.exe src/main.o src/Network.o src/core/Publisher.o src/core/Subscriber.o src/core/PubSubEngine.o src/utils/MessageValidator.o src/utils/CommandLineParser.o src/utils/NetworkUtils.o src/utils/MessageFormatter.o src/core/SubscriberConnectionPool.o src/core/DeliveryExecutor.o src/core/EngineShard.o src/core/TopicHistory.o src/core/MessageLog.o src/core/LogCompactor.o src/core/TopicRegistry.o src/core/PublishBatcher.o src/core/PublishOutbox.o src/core/LoadGenerator.o src/core/EngineMetrics.o src/utils/Logger.o -lws2_32
 if errorlevel 1 goto :error
 
 echo.
@@ -85,6 +85,26 @@ public:
         count = 0;
     }
     
+    // Change capacity, keeping the newest elements that still fit
+    void resize(int newCapacity) {
+        if (newCapacity < 1) {
+            newCapacity = 1;
+        }
+        
+        int keep = count < newCapacity ? count : newCapacity;
+        T* next = new T[newCapacity];
+        for (int i = 0; i < keep; i++) {
+            next[i] = buffer[(tail + count - keep + i) % capacity];
+        }
+        
+        delete[] buffer;
+        buffer = next;
+        capacity = newCapacity;
+        count = keep;
+        tail = 0;
+        head = keep % capacity;
+    }
+    
     // Get element at index (0 = oldest)
     bool getAt(int index, T& item) const {
         if (index < 0 || index >= count) {
@@ -0,0 +1,111 @@
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// High dynamic range histogram for latencies (HdrHistogram layout).
+//
+// Values below 2048 get one counter each. Above that, every power-of-two
+// range [2^k, 2^(k+1)) is split into 1024 linear sub-buckets, so any
+// recorded value is reported within 1/1024 (~0.1%) of itself while the
+// whole range up to 2^40 (about 18 minutes in nanoseconds) fits in 32k
+// counters. Recording is a shift and an increment; larger values are
+// clamped to the top bucket.
+//
+// Not thread-safe: give every thread its own histogram and merge() them.
+class HdrHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 10;
+    static const uint64_t SUB_BUCKET_HALF = 1ull << SUB_BUCKET_BITS;        // 1024
+    static const uint64_t SUB_BUCKET_COUNT = SUB_BUCKET_HALF << 1;          // 2048
+    static const int MAX_VALUE_BITS = 40;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t minValue;
+    uint64_t maxValue;
+    double sum;
+
+    static int highestBit(uint64_t v) {
+        return 63 - __builtin_clzll(v);
+    }
+
+    static size_t indexOf(uint64_t v) {
+        if (v < SUB_BUCKET_COUNT) {
+            return (size_t)v;
+        }
+        int shift = highestBit(v) - SUB_BUCKET_BITS;
+        return (size_t)(SUB_BUCKET_COUNT + (uint64_t)(shift - 1) * SUB_BUCKET_HALF +
+                        ((v >> shift) - SUB_BUCKET_HALF));
+    }
+
+    // Largest value that lands in the same counter as index i
+    static uint64_t highestEquivalent(size_t i) {
+        if (i < SUB_BUCKET_COUNT) {
+            return i;
+        }
+        int shift = (int)((i - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF) + 1;
+        uint64_t sub = (i - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    HdrHistogram()
+        : counts(indexOf((1ull << MAX_VALUE_BITS) - 1) + 1, 0), total(0), minValue(UINT64_MAX), maxValue(0), sum(0) {
+    }
+
+    void record(uint64_t value) {
+        value = std::min<uint64_t>(value, (1ull << MAX_VALUE_BITS) - 1);
+        counts[indexOf(value)]++;
+        total++;
+        sum += (double)value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    void merge(const HdrHistogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    void reset() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        sum = 0;
+        minValue = UINT64_MAX;
+        maxValue = 0;
+    }
+
+    // Smallest recorded value v (within the bucket precision) such that
+    // `percent` % of all values are <= v
+    uint64_t percentile(double percent) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(percent / 100.0 * (double)total + 0.5);
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(highestEquivalent(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    uint64_t getCount() const { return total; }
+    uint64_t getMin() const { return total ? minValue : 0; }
+    uint64_t getMax() const { return maxValue; }
+    double getMean() const { return total ? sum / (double)total : 0.0; }
+};
+
+#endif // HDR_HISTOGRAM_H
@@ -0,0 +1,113 @@
+#ifndef MPMC_RING_H
+#define MPMC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free multi-producer / multi-consumer ring buffer
+// (Vyukov's sequenced-cell design). Every cell carries a sequence number
+// that says whose turn it is: a producer may fill cell i when its sequence
+// equals the enqueue position, a consumer may empty it when the sequence is
+// one past it. Slots are allocated once up front; push and pop never
+// allocate or block. Capacity is rounded up to a power of two.
+//
+// Several consumers are allowed so producers can evict the oldest element
+// themselves when the ring is full (drop-oldest overflow).
+template<typename T>
+class MpmcRing {
+private:
+    static const size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Cell* cells;
+    size_t capacity;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> enqueuePos;
+    alignas(CACHE_LINE) std::atomic<size_t> dequeuePos;
+
+public:
+    explicit MpmcRing(size_t minCapacity = 1024) : enqueuePos(0), dequeuePos(0) {
+        capacity = 2;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        cells = new Cell[capacity];
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcRing() {
+        delete[] cells;
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    // Any thread. Returns false if the ring is full.
+    bool push(const T& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell* cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell->value = item;
+                    cell->sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Any thread. Returns false if the ring is empty.
+    bool pop(T& item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell* cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell->value);
+                    cell->sequence.store(pos + capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate number of queued elements
+    size_t size() const {
+        size_t tail = enqueuePos.load(std::memory_order_acquire);
+        size_t head = dequeuePos.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+};
+
+#endif // MPMC_RING_H
@@ -0,0 +1,127 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer FIFO queue
+// (Vyukov node-based design). push() is wait-free for producers; pop() is
+// only ever called from one consumer thread. waitPop() blocks the consumer
+// until an element arrives; producers only touch the mutex when the
+// consumer is actually asleep.
+template<typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        T value;
+
+        Node() : next(nullptr) {}
+        explicit Node(T&& v) : next(nullptr), value(std::move(v)) {}
+    };
+
+    std::atomic<Node*> head;          // Producers append here
+    Node* tail;                       // Consumer reads from here (stub node)
+    std::atomic<int> count;           // Approximate number of elements
+
+    std::mutex waitMutex;
+    std::condition_variable waitCV;
+    std::atomic<bool> consumerWaiting;
+    std::atomic<bool> closed;
+
+    void wakeConsumer() {
+        if (consumerWaiting.load()) {
+            {
+                std::lock_guard<std::mutex> lock(waitMutex);
+            }
+            waitCV.notify_one();
+        }
+    }
+
+public:
+    MpscQueue() : count(0), consumerWaiting(false), closed(false) {
+        Node* stub = new Node();
+        head.store(stub);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        T dummy;
+        while (pop(dummy)) {
+        }
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Add element (any thread)
+    void push(T item) {
+        Node* node = new Node(std::move(item));
+        Node* prev = head.exchange(node);
+        // seq_cst so the link cannot be reordered after the consumerWaiting check
+        prev->next.store(node);
+        count.fetch_add(1, std::memory_order_relaxed);
+        wakeConsumer();
+    }
+
+    // Remove oldest element without blocking (consumer thread only)
+    bool pop(T& item) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+
+        item = std::move(next->value);
+        delete tail;
+        tail = next;               // next becomes the new stub
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Remove oldest element, waiting up to timeout for one to arrive.
+    // Returns false on timeout or after close().
+    bool waitPop(T& item, std::chrono::milliseconds timeout) {
+        if (pop(item)) {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(waitMutex);
+        consumerWaiting.store(true);
+        bool ready = waitCV.wait_for(lock, timeout, [this] {
+            return tail->next.load() != nullptr || closed.load();
+        });
+        consumerWaiting.store(false);
+        lock.unlock();
+
+        return ready && pop(item);
+    }
+
+    // Wake a waiting consumer permanently (used on shutdown)
+    void close() {
+        closed.store(true);
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+        }
+        waitCV.notify_all();
+    }
+
+    // Allow waiting again after close()
+    void reopen() {
+        closed.store(false);
+    }
+
+    // Approximate size (exact when producers are quiet)
+    int size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+};
+
+#endif // MPSC_QUEUE_H
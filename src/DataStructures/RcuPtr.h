@@ -0,0 +1,245 @@
+#ifndef RCU_PTR_H
+#define RCU_PTR_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <cstdint>
+
+// Epoch-based reclamation for read-mostly data (RCU style).
+//
+// Readers wrap their accesses in an RcuReadGuard: entering publishes the
+// current global epoch in a per-thread slot (one store to a cache line
+// nobody else writes), leaving clears it. Readers never wait on writers.
+//
+// Writers swap in a new object and retire() the old one, tagged with the
+// epoch at which it was unlinked. It is freed once every thread that was
+// reading at that time has left its read section.
+class EpochDomain {
+private:
+    static const int MAX_READERS = 128;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;   // 0 = not reading
+        std::atomic<bool> inUse;
+
+        ReaderSlot() : epoch(0), inUse(false) {}
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    // Per-thread registration: slot index and read-section nesting depth
+    struct ThreadState {
+        int slot;
+        int depth;
+        bool overflow;             // No free slot: counted in overflowReaders
+
+        ThreadState() : slot(-1), depth(0), overflow(false) {}
+
+        ~ThreadState() {
+            if (slot >= 0) {
+                EpochDomain::instance().slots[slot].inUse.store(false);
+            }
+        }
+    };
+
+    ReaderSlot slots[MAX_READERS];
+    alignas(64) std::atomic<uint64_t> globalEpoch;
+    std::atomic<int> overflowReaders;
+    std::mutex retiredMutex;
+    std::vector<Retired> retired;
+
+    EpochDomain() : globalEpoch(1), overflowReaders(0) {}
+
+    static ThreadState& threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    int claimSlot() {
+        for (int i = 0; i < MAX_READERS; i++) {
+            bool expected = false;
+            if (!slots[i].inUse.load(std::memory_order_relaxed) &&
+                slots[i].inUse.compare_exchange_strong(expected, true)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Oldest epoch still being read (UINT64_MAX if nobody is reading)
+    uint64_t oldestActiveEpoch() const {
+        if (overflowReaders.load() > 0) {
+            return 0;
+        }
+
+        uint64_t oldest = UINT64_MAX;
+        for (int i = 0; i < MAX_READERS; i++) {
+            uint64_t e = slots[i].epoch.load();
+            if (e != 0 && e < oldest) {
+                oldest = e;
+            }
+        }
+        return oldest;
+    }
+
+public:
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    ~EpochDomain() {
+        for (const Retired& r : retired) {
+            r.deleter(r.object);
+        }
+    }
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    void enter() {
+        ThreadState& state = threadState();
+        if (state.depth++ > 0) {
+            return;
+        }
+
+        if (state.slot < 0 && !state.overflow) {
+            state.slot = claimSlot();
+        }
+
+        if (state.slot >= 0) {
+            // seq_cst: the slot must be visible before the protected pointer is loaded
+            slots[state.slot].epoch.store(globalEpoch.load());
+        } else {
+            state.overflow = true;
+            overflowReaders.fetch_add(1);
+        }
+    }
+
+    void leave() {
+        ThreadState& state = threadState();
+        if (--state.depth > 0) {
+            return;
+        }
+
+        if (state.slot >= 0) {
+            slots[state.slot].epoch.store(0, std::memory_order_release);
+        } else {
+            overflowReaders.fetch_sub(1);
+            state.overflow = false;
+        }
+    }
+
+    // Defer deleting an object that was just unlinked from shared memory
+    template<typename T>
+    void retire(const T* object) {
+        if (object == nullptr) {
+            return;
+        }
+
+        Retired r;
+        r.object = const_cast<T*>(object);
+        r.deleter = [](void* p) { delete static_cast<T*>(p); };
+        r.epoch = globalEpoch.fetch_add(1);
+
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.push_back(r);
+    }
+
+    // Free every retired object no reader can still see. Returns count freed.
+    int reclaim() {
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            uint64_t oldest = oldestActiveEpoch();
+
+            size_t kept = 0;
+            for (size_t i = 0; i < retired.size(); i++) {
+                if (retired[i].epoch < oldest) {
+                    ready.push_back(retired[i]);
+                } else {
+                    retired[kept++] = retired[i];
+                }
+            }
+            retired.resize(kept);
+        }
+
+        for (const Retired& r : ready) {
+            r.deleter(r.object);
+        }
+        return (int)ready.size();
+    }
+
+    // Wait until everything retired so far has been freed
+    void synchronize() {
+        while (true) {
+            reclaim();
+            {
+                std::lock_guard<std::mutex> lock(retiredMutex);
+                if (retired.empty()) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Objects waiting for their grace period
+    int pendingCount() {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        return (int)retired.size();
+    }
+};
+
+// Scoped read-side critical section; nests freely
+class RcuReadGuard {
+public:
+    RcuReadGuard() {
+        EpochDomain::instance().enter();
+    }
+
+    ~RcuReadGuard() {
+        EpochDomain::instance().leave();
+    }
+
+    RcuReadGuard(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+};
+
+// Atomically published pointer to an immutable object.
+// load() must be called inside an RcuReadGuard; the object stays valid until
+// the guard is released. Writers must be serialized by the caller.
+template<typename T>
+class RcuPtr {
+private:
+    std::atomic<const T*> ptr;
+
+public:
+    RcuPtr() : ptr(nullptr) {}
+
+    ~RcuPtr() {
+        delete ptr.load();
+    }
+
+    RcuPtr(const RcuPtr&) = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+
+    // seq_cst so the load cannot move ahead of the reader's epoch store
+    const T* load() const {
+        return ptr.load();
+    }
+
+    // Swap in a new object (may be nullptr); the old one is freed after a grace period
+    void publish(const T* next) {
+        const T* previous = ptr.exchange(next);
+        EpochDomain::instance().retire(previous);
+    }
+};
+
+#endif // RCU_PTR_H
@@ -0,0 +1,69 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+// Single-writer sequence lock around a trivially copyable value.
+//
+// The writer bumps the sequence to odd, copies the value in and bumps it to
+// even again; it never waits. Readers copy the value out and retry if the
+// sequence was odd or changed meanwhile, so readers never block the writer
+// (the publish path) and a reader only retries while a store is in flight.
+//
+// Writers must be serialized by the caller.
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values must be trivially copyable");
+
+private:
+    std::atomic<uint32_t> sequence;   // Odd while a store is in progress, 0 = never stored
+    T value;
+
+public:
+    SeqLock() : sequence(0), value() {}
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Writer only
+    void store(const T& v) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memcpy(static_cast<void*>(&value), &v, sizeof(T));
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread. Returns false if nothing was stored yet.
+    bool load(T& out) const {
+        while (true) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            memcpy(static_cast<void*>(&out), &value, sizeof(T));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+    }
+
+    bool hasValue() const {
+        return sequence.load(std::memory_order_acquire) != 0;
+    }
+};
+
+#endif // SEQ_LOCK_H
@@ -0,0 +1,115 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Hint for loops that spin polling a ring: tells the core it is waiting so
+// it backs off the memory pipeline and yields issue slots to its sibling
+// hyperthread. Falls back to a scheduler yield where there is no such hint.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Bounded single-producer / single-consumer ring buffer.
+// Capacity is rounded up to a power of two so indices wrap with a mask.
+// Head and tail live on separate cache lines, and each side keeps a cached
+// copy of the other's index so it only reads the shared one when the ring
+// looks full (producer) or empty (consumer).
+template<typename T>
+class SpscRing {
+private:
+    static const size_t CACHE_LINE = 64;
+
+    T* slots;
+    size_t capacity;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head;   // Next slot to read (consumer)
+    size_t cachedTail;                              // Consumer's view of tail
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail;   // Next slot to write (producer)
+    size_t cachedHead;                              // Producer's view of head
+
+public:
+    explicit SpscRing(size_t minCapacity = 1024)
+        : head(0), cachedTail(0), tail(0), cachedHead(0) {
+        capacity = 2;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        slots = new T[capacity];
+    }
+
+    ~SpscRing() {
+        delete[] slots;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer thread only. Returns false if the ring is full.
+    bool push(T&& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == capacity) {
+                return false;
+            }
+        }
+
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Returns false if the ring is empty.
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+
+        item = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued elements (exact from either owner thread).
+    // Head is read first: tail only grows, so from any other thread the
+    // difference cannot go negative; it is clamped to capacity in case the
+    // consumer moved on meanwhile.
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (t <= h) {
+            return 0;
+        }
+        return t - h < capacity ? t - h : capacity;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,84 @@
+#ifndef STABLE_VECTOR_H
+#define STABLE_VECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Append-only array whose elements never move.
+//
+// Storage is a fixed directory of chunks allocated on demand, so growing
+// never copies existing elements and a reference handed out stays valid
+// for the life of the container. One writer appends (callers serialize
+// writers); any number of readers index it without locking: the count is
+// published with release after the element is constructed, so an index
+// below size() always refers to a fully built element.
+template<typename T, size_t CHUNK_SIZE = 1024, size_t MAX_CHUNKS = 4096>
+class StableVector {
+private:
+    std::atomic<T*> chunks[MAX_CHUNKS];
+    std::atomic<size_t> count;
+
+public:
+    StableVector() : count(0) {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) {
+            chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~StableVector() {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) {
+            delete[] chunks[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    StableVector(const StableVector&) = delete;
+    StableVector& operator=(const StableVector&) = delete;
+
+    static size_t capacity() { return CHUNK_SIZE * MAX_CHUNKS; }
+
+    // Writer only. Returns the new element's index, or capacity() when full.
+    size_t push(T&& value) {
+        size_t index = count.load(std::memory_order_relaxed);
+        if (index >= capacity()) {
+            return capacity();
+        }
+
+        size_t chunk = index / CHUNK_SIZE;
+        T* slots = chunks[chunk].load(std::memory_order_relaxed);
+        if (slots == nullptr) {
+            slots = new T[CHUNK_SIZE];
+            chunks[chunk].store(slots, std::memory_order_release);
+        }
+        slots[index % CHUNK_SIZE] = std::move(value);
+        count.store(index + 1, std::memory_order_release);
+        return index;
+    }
+
+    size_t push(const T& value) {
+        T copy(value);
+        return push(std::move(copy));
+    }
+
+    // Any thread. Elements are immutable once pushed.
+    size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    // Element i, or nullptr if i has not been pushed yet
+    const T* find(size_t i) const {
+        if (i >= size()) {
+            return nullptr;
+        }
+        return &chunks[i / CHUNK_SIZE].load(std::memory_order_acquire)[i % CHUNK_SIZE];
+    }
+
+    T* find(size_t i) {
+        if (i >= size()) {
+            return nullptr;
+        }
+        return &chunks[i / CHUNK_SIZE].load(std::memory_order_acquire)[i % CHUNK_SIZE];
+    }
+};
+
+#endif // STABLE_VECTOR_H
@@ -0,0 +1,319 @@
+#ifndef TOPIC_TABLE_H
+#define TOPIC_TABLE_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Growable open-addressing hash table keyed by topic name (Robin Hood hashing).
+//
+// Every slot remembers its distance from the ideal bucket; inserts displace
+// entries that are closer to home, which keeps probe sequences short even at
+// high load and lets a miss stop as soon as it meets a "richer" slot.
+//
+// Growth is incremental: when the load factor is exceeded a table twice as
+// large is allocated and every following insert moves a few buckets from the
+// old table, so no single insert ever pays for a full rehash. Lookups check
+// both tables while a migration is in progress. Slots are plain data and
+// bucket arrays come from calloc, so even allocating a table for millions of
+// topics does not touch every bucket up front.
+//
+// V must be trivially copyable (the engine stores TopicEntry pointers).
+template<typename V>
+class TopicTable {
+    static_assert(std::is_trivially_copyable<V>::value, "TopicTable values must be trivially copyable");
+
+private:
+    struct Slot {
+        uint64_t hash;          // Cached full hash (avoids rehashing keys on resize)
+        uint32_t dist;          // Probe distance + 1 (0 = empty)
+        uint32_t keyLen;
+        char* key;              // Owned, NUL-terminated copy of the topic
+        V value;
+    };
+
+    struct Table {
+        Slot* slots;
+        size_t capacity;        // Always a power of two
+        size_t mask;
+        int shift;              // 64 - log2(capacity), for Fibonacci hashing
+        size_t count;
+
+        Table() : slots(nullptr), capacity(0), mask(0), shift(64), count(0) {}
+
+        void allocate(size_t cap) {
+            slots = static_cast<Slot*>(calloc(cap, sizeof(Slot)));
+            if (!slots) {
+                throw std::bad_alloc();
+            }
+            capacity = cap;
+            mask = cap - 1;
+            shift = 64;
+            while (cap > 1) {
+                cap >>= 1;
+                shift--;
+            }
+            count = 0;
+        }
+
+        // Frees the buckets only; keys must have been freed or moved before
+        void release() {
+            free(slots);
+            slots = nullptr;
+            capacity = 0;
+            count = 0;
+        }
+
+        size_t home(uint64_t h) const {
+            // Spread the hash over all bits before taking the top ones
+            return (size_t)((h * 11400714819323198485ull) >> shift) & mask;
+        }
+    };
+
+    static const size_t MIN_CAPACITY = 16;
+    static const size_t MIGRATE_STEP = 64;       // Old buckets moved per insert
+    static constexpr double MAX_LOAD = 0.85;
+
+    Table current;
+    Table old;                  // Non-empty only while migrating
+    size_t migratePos;          // Next old bucket to migrate
+
+    static V* findIn(const Table& t, const char* key, size_t keyLen, uint64_t h) {
+        if (t.count == 0) {
+            return nullptr;
+        }
+
+        size_t idx = t.home(h);
+        uint32_t dist = 1;
+
+        while (true) {
+            Slot& slot = t.slots[idx];
+            if (slot.dist < dist) {
+                return nullptr;  // Empty, or an entry closer to home: key is absent
+            }
+            if (slot.hash == h && slot.keyLen == keyLen && memcmp(slot.key, key, keyLen) == 0) {
+                return &slot.value;
+            }
+            idx = (idx + 1) & t.mask;
+            dist++;
+        }
+    }
+
+    // Robin Hood insert of a key known to be absent. Returns the final value slot.
+    static V* placeIn(Table& t, Slot incoming) {
+        incoming.dist = 1;
+
+        V* placed = nullptr;
+        size_t idx = t.home(incoming.hash);
+
+        while (true) {
+            Slot& slot = t.slots[idx];
+            if (slot.dist == 0) {
+                slot = incoming;
+                t.count++;
+                return placed ? placed : &slot.value;
+            }
+            if (slot.dist < incoming.dist) {
+                // Take from the rich: swap and keep placing the displaced entry
+                std::swap(slot, incoming);
+                if (!placed) {
+                    placed = &slot.value;
+                }
+            }
+            idx = (idx + 1) & t.mask;
+            incoming.dist++;
+        }
+    }
+
+    // Backward-shift deletion: pull the rest of the cluster one slot closer
+    // to home so no hole is left for findIn() to stop at
+    static void removeAt(Table& t, size_t idx) {
+        size_t next = (idx + 1) & t.mask;
+        while (t.slots[next].dist > 1) {
+            t.slots[idx] = t.slots[next];
+            t.slots[idx].dist--;
+            idx = next;
+            next = (next + 1) & t.mask;
+        }
+        t.slots[idx].dist = 0;
+        t.count--;
+    }
+
+    // Move up to `steps` buckets from the old table into the current one.
+    // Entries are removed with backward shift, so the old table stays a
+    // valid Robin Hood table and lookups in it keep working mid-migration.
+    // Buckets before migratePos are always empty: a removal may shift the
+    // next entry of the cluster into migratePos, so it is revisited.
+    void migrate(size_t steps) {
+        if (old.slots == nullptr) {
+            return;
+        }
+
+        while (steps-- > 0 && migratePos < old.capacity) {
+            Slot& slot = old.slots[migratePos];
+            if (slot.dist == 0) {
+                migratePos++;
+                continue;
+            }
+            placeIn(current, slot);
+            removeAt(old, migratePos);
+        }
+
+        if (migratePos >= old.capacity) {
+            old.release();
+            migratePos = 0;
+        }
+    }
+
+    static void freeKeys(Table& t) {
+        for (size_t i = 0; i < t.capacity; i++) {
+            if (t.slots[i].dist != 0) {
+                free(t.slots[i].key);
+            }
+        }
+    }
+
+    void beginGrow() {
+        // Finish any earlier migration first (only possible under extreme growth)
+        migrate(old.capacity);
+
+        old = current;
+        current = Table();
+        current.allocate(old.capacity * 2);
+        migratePos = 0;
+    }
+
+public:
+    explicit TopicTable(size_t initialCapacity = MIN_CAPACITY) : migratePos(0) {
+        size_t cap = MIN_CAPACITY;
+        while (cap < initialCapacity) {
+            cap <<= 1;
+        }
+        current.allocate(cap);
+    }
+
+    ~TopicTable() {
+        freeKeys(current);
+        freeKeys(old);
+        current.release();
+        old.release();
+    }
+
+    TopicTable(const TopicTable&) = delete;
+    TopicTable& operator=(const TopicTable&) = delete;
+
+    // 64-bit djb2 over the topic string
+    static uint64_t hashKey(const char* key) {
+        uint64_t hash = 5381;
+        int c;
+        while ((c = (unsigned char)*key++)) {
+            hash = ((hash << 5) + hash) + c;
+        }
+        return hash;
+    }
+
+    // Same hash for a key that is not NUL-terminated
+    static uint64_t hashKey(const char* key, size_t len) {
+        uint64_t hash = 5381;
+        for (size_t i = 0; i < len; i++) {
+            hash = ((hash << 5) + hash) + (unsigned char)key[i];
+        }
+        return hash;
+    }
+
+    // Find value by key; nullptr if absent
+    V* find(const char* key) const {
+        return find(key, hashKey(key));
+    }
+
+    V* find(const char* key, uint64_t h) const {
+        size_t keyLen = strlen(key);
+        V* v = findIn(current, key, keyLen, h);
+        if (!v && old.slots) {
+            v = findIn(old, key, keyLen, h);
+        }
+        return v;
+    }
+
+    // Insert key if absent. Returns pointer to the (new or existing) value.
+    // Pointers are only stable until the next insert.
+    V* insert(const char* key, const V& value, bool* inserted = nullptr) {
+        uint64_t h = hashKey(key);
+
+        V* existing = find(key, h);
+        if (existing) {
+            if (inserted) {
+                *inserted = false;
+            }
+            return existing;
+        }
+
+        migrate(MIGRATE_STEP);
+
+        if ((double)(current.count + 1) > current.capacity * MAX_LOAD) {
+            beginGrow();
+            migrate(MIGRATE_STEP);
+        }
+
+        if (inserted) {
+            *inserted = true;
+        }
+
+        Slot slot;
+        slot.hash = h;
+        slot.keyLen = (uint32_t)strlen(key);
+        slot.key = static_cast<char*>(malloc(slot.keyLen + 1));
+        if (!slot.key) {
+            throw std::bad_alloc();
+        }
+        memcpy(slot.key, key, slot.keyLen + 1);
+        slot.value = value;
+        return placeIn(current, slot);
+    }
+
+    // Number of stored keys
+    size_t size() const {
+        return current.count + old.count;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    // Total bucket count (current table)
+    size_t capacity() const {
+        return current.capacity;
+    }
+
+    // True while an incremental resize is still moving entries
+    bool isMigrating() const {
+        return old.slots != nullptr;
+    }
+
+    // Move up to `buckets` old buckets forward (e.g. from a background sweep
+    // so a migration finishes even when no more topics are inserted)
+    void advanceMigration(size_t buckets = MIGRATE_STEP) {
+        migrate(buckets);
+    }
+
+    // Visit every key/value pair: fn(const char* key, V& value)
+    template<typename Fn>
+    void forEach(Fn fn) {
+        for (size_t i = 0; i < current.capacity; i++) {
+            if (current.slots[i].dist != 0) {
+                fn(current.slots[i].key, current.slots[i].value);
+            }
+        }
+        for (size_t i = 0; i < old.capacity; i++) {
+            if (old.slots[i].dist != 0) {
+                fn(old.slots[i].key, old.slots[i].value);
+            }
+        }
+    }
+};
+
+#endif // TOPIC_TABLE_H
@@ -0,0 +1,322 @@
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+// MQTT-style topic pattern helpers.
+// Topics are '/'-separated segments ("Status/SWG/1").
+//   '+' matches exactly one segment    ("Status/+/1")
+//   '#' matches any remaining segments ("Status/#"), must be the last segment
+struct TopicPattern {
+    static bool hasWildcards(const char* pattern) {
+        return strchr(pattern, '+') != nullptr || strchr(pattern, '#') != nullptr;
+    }
+
+    // Wildcards must occupy a whole segment and '#' may only be last
+    static bool isValid(const char* pattern) {
+        if (pattern[0] == '\0') {
+            return false;
+        }
+
+        const char* p = pattern;
+        while (*p) {
+            const char* end = strchr(p, '/');
+            size_t len = end ? (size_t)(end - p) : strlen(p);
+
+            for (size_t i = 0; i < len; i++) {
+                if ((p[i] == '+' || p[i] == '#') && len != 1) {
+                    return false;
+                }
+            }
+            if (len == 1 && p[0] == '#' && end != nullptr) {
+                return false;
+            }
+
+            if (!end) {
+                break;
+            }
+            p = end + 1;
+        }
+        return true;
+    }
+
+    // Match a concrete topic against a pattern (no trie, used by subscribers)
+    static bool matches(const char* pattern, const char* topic) {
+        return matches(pattern, std::string_view(topic));
+    }
+
+    // Same, for a topic that is not NUL-terminated (e.g. a MessageView's)
+    static bool matches(const char* pattern, std::string_view topic) {
+        size_t t = 0;
+        while (true) {
+            if (pattern[0] == '#' && pattern[1] == '\0') {
+                return true;
+            }
+
+            const char* patEnd = strchr(pattern, '/');
+            size_t topEnd = topic.find('/', t);
+            size_t patLen = patEnd ? (size_t)(patEnd - pattern) : strlen(pattern);
+            size_t topLen = (topEnd == std::string_view::npos ? topic.size() : topEnd) - t;
+
+            bool plus = (patLen == 1 && pattern[0] == '+');
+            if (!plus && (patLen != topLen || topic.compare(t, topLen, pattern, patLen) != 0)) {
+                return false;
+            }
+
+            if (!patEnd && topEnd == std::string_view::npos) {
+                return true;
+            }
+            if (topEnd == std::string_view::npos) {
+                // Topic ended: only a trailing "/#" still matches ("a/#" matches "a")
+                return patEnd[1] == '#' && patEnd[2] == '\0';
+            }
+            if (!patEnd) {
+                return false;
+            }
+
+            pattern = patEnd + 1;
+            t = topEnd + 1;
+        }
+    }
+};
+
+// Segment trie of wildcard subscriptions.
+// Each node is one topic segment; '+' and '#' get dedicated children, so a
+// publish walks at most the topic's depth instead of testing every pattern.
+// Results per concrete topic are cached until the next insert/remove.
+template<typename T>
+class TopicTrie {
+private:
+    struct Node {
+        std::unordered_map<std::string, Node*> children;  // Literal segments
+        Node* plusChild;                                  // '+'
+        Node* hashChild;                                  // '#'
+        std::vector<T> values;                            // Subscriptions ending here
+
+        Node() : plusChild(nullptr), hashChild(nullptr) {}
+
+        ~Node() {
+            for (auto& kv : children) {
+                delete kv.second;
+            }
+            delete plusChild;
+            delete hashChild;
+        }
+
+        bool isEmpty() const {
+            return values.empty() && children.empty() && !plusChild && !hashChild;
+        }
+    };
+
+    static const size_t MAX_CACHE_ENTRIES = 4096;
+
+    Node* root;
+    int numValues;
+    std::unordered_map<std::string, std::vector<T>> matchCache;
+
+    static void split(const char* topic, std::vector<std::string>& segments) {
+        segments.clear();
+        const char* p = topic;
+        while (true) {
+            const char* end = strchr(p, '/');
+            if (!end) {
+                segments.emplace_back(p);
+                return;
+            }
+            segments.emplace_back(p, end - p);
+            p = end + 1;
+        }
+    }
+
+    static Node*& childFor(Node* node, const std::string& segment) {
+        if (segment == "+") {
+            return node->plusChild;
+        }
+        if (segment == "#") {
+            return node->hashChild;
+        }
+        return node->children[segment];
+    }
+
+    static void collect(const Node* node, const std::vector<std::string>& segments,
+                        size_t depth, std::vector<T>& out) {
+        // '#' also matches the parent level itself ("a/#" matches "a")
+        if (node->hashChild) {
+            out.insert(out.end(), node->hashChild->values.begin(), node->hashChild->values.end());
+        }
+
+        if (depth == segments.size()) {
+            out.insert(out.end(), node->values.begin(), node->values.end());
+            return;
+        }
+
+        auto it = node->children.find(segments[depth]);
+        if (it != node->children.end()) {
+            collect(it->second, segments, depth + 1, out);
+        }
+        if (node->plusChild) {
+            collect(node->plusChild, segments, depth + 1, out);
+        }
+    }
+
+    // Remove value under segments[depth..]; prunes nodes left empty
+    bool removeFrom(Node* node, const std::vector<std::string>& segments, size_t depth, const T& value) {
+        if (depth == segments.size()) {
+            auto it = std::find(node->values.begin(), node->values.end(), value);
+            if (it == node->values.end()) {
+                return false;
+            }
+            node->values.erase(it);
+            return true;
+        }
+
+        const std::string& segment = segments[depth];
+        Node* child = nullptr;
+        if (segment == "+") {
+            child = node->plusChild;
+        } else if (segment == "#") {
+            child = node->hashChild;
+        } else {
+            auto it = node->children.find(segment);
+            child = (it != node->children.end()) ? it->second : nullptr;
+        }
+
+        if (!child || !removeFrom(child, segments, depth + 1, value)) {
+            return false;
+        }
+
+        if (child->isEmpty()) {
+            if (segment == "+") {
+                node->plusChild = nullptr;
+            } else if (segment == "#") {
+                node->hashChild = nullptr;
+            } else {
+                node->children.erase(segment);
+            }
+            delete child;
+        }
+        return true;
+    }
+
+    static void gather(const Node* node, std::string& path, size_t depth,
+                       std::vector<std::pair<std::string, T>>& out) {
+        for (const T& v : node->values) {
+            out.emplace_back(path, v);
+        }
+
+        auto visit = [&](const std::string& segment, const Node* child) {
+            size_t len = path.size();
+            if (depth > 0) {
+                path += '/';
+            }
+            path += segment;
+            gather(child, path, depth + 1, out);
+            path.resize(len);
+        };
+
+        for (const auto& kv : node->children) {
+            visit(kv.first, kv.second);
+        }
+        if (node->plusChild) {
+            visit("+", node->plusChild);
+        }
+        if (node->hashChild) {
+            visit("#", node->hashChild);
+        }
+    }
+
+public:
+    TopicTrie() : root(new Node()), numValues(0) {}
+
+    ~TopicTrie() {
+        delete root;
+    }
+
+    TopicTrie(const TopicTrie&) = delete;
+    TopicTrie& operator=(const TopicTrie&) = delete;
+
+    // Add value under pattern. Returns false if it was already present.
+    bool insert(const char* pattern, const T& value) {
+        std::vector<std::string> segments;
+        split(pattern, segments);
+
+        Node* node = root;
+        for (const std::string& segment : segments) {
+            Node*& child = childFor(node, segment);
+            if (!child) {
+                child = new Node();
+            }
+            node = child;
+        }
+
+        if (std::find(node->values.begin(), node->values.end(), value) != node->values.end()) {
+            return false;
+        }
+
+        node->values.push_back(value);
+        numValues++;
+        matchCache.clear();
+        return true;
+    }
+
+    // Remove value from pattern. Returns false if it was not present.
+    bool remove(const char* pattern, const T& value) {
+        std::vector<std::string> segments;
+        split(pattern, segments);
+
+        if (!removeFrom(root, segments, 0, value)) {
+            return false;
+        }
+
+        numValues--;
+        matchCache.clear();
+        return true;
+    }
+
+    // Append every value whose pattern matches the concrete topic
+    void match(const char* topic, std::vector<T>& out) {
+        if (numValues == 0) {
+            return;
+        }
+
+        auto cached = matchCache.find(topic);
+        if (cached != matchCache.end()) {
+            out.insert(out.end(), cached->second.begin(), cached->second.end());
+            return;
+        }
+
+        std::vector<std::string> segments;
+        split(topic, segments);
+
+        std::vector<T> result;
+        collect(root, segments, 0, result);
+
+        if (matchCache.size() >= MAX_CACHE_ENTRIES) {
+            matchCache.clear();
+        }
+        out.insert(out.end(), result.begin(), result.end());
+        matchCache.emplace(topic, std::move(result));
+    }
+
+    // All (pattern, value) pairs currently stored
+    void getAll(std::vector<std::pair<std::string, T>>& out) const {
+        std::string path;
+        gather(root, path, 0, out);
+    }
+
+    // Number of stored values
+    int size() const {
+        return numValues;
+    }
+
+    bool isEmpty() const {
+        return numValues == 0;
+    }
+};
+
+#endif // TOPIC_TRIE_H
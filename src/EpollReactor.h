@@ -0,0 +1,418 @@
+#ifndef EPOLL_REACTOR_H
+#define EPOLL_REACTOR_H
+
+// Edge-triggered epoll reactor used by TcpServer on Linux.
+// All client sockets are multiplexed over a small fixed set of event-loop
+// threads instead of one blocking thread per client. Each connection keeps
+// its own read buffer and 4-byte length-prefixed frames are decoded
+// incrementally as bytes arrive. The frame handler can refuse a frame; the
+// frame stays buffered and its connection is not read (EPOLLIN is dropped
+// for that fd only) until resumeReading(), while the loop keeps serving
+// everyone else.
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <unordered_set>
+#include <iostream>
+
+class EpollReactor {
+public:
+    // Called on an event-loop thread for every complete frame (payload only).
+    // loopIndex (0..threads-1) identifies the calling event-loop thread.
+    // Returning false refuses the frame (payload must be left intact): the
+    // connection pauses and the frame is offered again after resumeReading().
+    using FrameHandler = std::function<bool(int loopIndex, int fd, std::vector<uint8_t>&& payload)>;
+    // Called when a connection is accepted or closed
+    using ConnectionHandler = std::function<void(int fd)>;
+
+private:
+    static const int MAX_EVENTS = 256;
+    static const size_t READ_CHUNK = 16384;
+
+    // Per-connection state, owned by exactly one event loop
+    struct Connection {
+        int fd;
+        int loopIndex;                    // Owning event loop
+        std::vector<uint8_t> readBuffer;  // Bytes received but not yet consumed
+        size_t readPos;                   // Start of the first unconsumed byte
+        bool paused;                      // Not watched for EPOLLIN (see resumeReading)
+
+        Connection(int f, int loop) : fd(f), loopIndex(loop), readPos(0), paused(false) {}
+    };
+
+    struct EventLoop {
+        int index;
+        int epollFd;
+        int wakeFd;                            // eventfd used to interrupt epoll_wait (stop, resume)
+        std::thread thread;
+        std::mutex connMutex;                  // Guards connections (touched on accept/close only)
+        std::unordered_set<Connection*> connections;
+        std::vector<Connection*> paused;       // Loop thread only
+        std::atomic<bool> resumeRequested;
+
+        explicit EventLoop(int i) : index(i), epollFd(-1), wakeFd(-1), resumeRequested(false) {}
+    };
+
+    int listenFd;
+    uint32_t maxFrameLength;
+    std::vector<EventLoop*> loops;
+    std::atomic<bool> running;
+    std::atomic<unsigned> nextLoop;            // Round-robin assignment of new connections
+
+    FrameHandler onFrame;
+    ConnectionHandler onAccept;
+    ConnectionHandler onClose;
+
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags == -1) {
+            return false;
+        }
+        return fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+
+    // Drain the (edge-triggered) listening socket and hand connections to loops
+    void acceptPending() {
+        while (true) {
+            struct sockaddr_in clientAddr;
+            socklen_t clientAddrLen = sizeof(clientAddr);
+            int client = ::accept4(listenFd, (struct sockaddr*)&clientAddr, &clientAddrLen,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // EAGAIN: no more pending connections; anything else is transient
+                return;
+            }
+
+            EventLoop* loop = loops[nextLoop.fetch_add(1) % loops.size()];
+            Connection* conn = new Connection(client, loop->index);
+            {
+                std::lock_guard<std::mutex> lock(loop->connMutex);
+                loop->connections.insert(conn);
+            }
+
+            if (onAccept) {
+                onAccept(client);
+            }
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            ev.data.ptr = conn;
+            if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, client, &ev) == -1) {
+                std::cerr << "EpollReactor: epoll_ctl ADD failed for client" << std::endl;
+                closeConnection(loop, conn);
+            }
+        }
+    }
+
+    // Read everything currently available (required in edge-triggered mode),
+    // or until the frame handler pauses the connection.
+    // Returns false if the connection must be closed.
+    bool readAvailable(Connection* conn) {
+        while (!conn->paused) {
+            size_t used = conn->readBuffer.size();
+            conn->readBuffer.resize(used + READ_CHUNK);
+            ssize_t n = ::recv(conn->fd, conn->readBuffer.data() + used, READ_CHUNK, 0);
+
+            if (n > 0) {
+                conn->readBuffer.resize(used + n);
+                if (!decodeFrames(conn)) {
+                    return false;
+                }
+                continue;
+            }
+
+            conn->readBuffer.resize(used);
+            if (n == 0) {
+                return false;  // Peer closed
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        return true;
+    }
+
+    // Watch the connection with or without EPOLLIN. Re-adding EPOLLIN reports
+    // data (or a hangup) that arrived while it was paused.
+    bool watch(Connection* conn, bool reading) {
+        struct epoll_event ev;
+        ev.events = reading ? (EPOLLIN | EPOLLRDHUP | EPOLLET) : EPOLLET;
+        ev.data.ptr = conn;
+        return epoll_ctl(loops[conn->loopIndex]->epollFd, EPOLL_CTL_MOD, conn->fd, &ev) == 0;
+    }
+
+    void pause(Connection* conn) {
+        conn->paused = true;
+        loops[conn->loopIndex]->paused.push_back(conn);
+        watch(conn, false);
+    }
+
+    // Frames already buffered (the refused one first) go out before the
+    // socket is watched again
+    void resumePaused(EventLoop* loop) {
+        std::vector<Connection*> resumed;
+        resumed.swap(loop->paused);
+
+        for (Connection* conn : resumed) {
+            conn->paused = false;
+            if (!decodeFrames(conn)) {
+                closeConnection(loop, conn);
+            } else if (!conn->paused && !watch(conn, true)) {
+                closeConnection(loop, conn);
+            }
+        }
+    }
+
+    // Emit every complete frame in the read buffer and keep the partial tail
+    bool decodeFrames(Connection* conn) {
+        std::vector<uint8_t>& buf = conn->readBuffer;
+
+        while (buf.size() - conn->readPos >= 4) {
+            const uint8_t* p = buf.data() + conn->readPos;
+            uint32_t len = ((uint32_t)p[0] << 24) |
+                           ((uint32_t)p[1] << 16) |
+                           ((uint32_t)p[2] << 8) |
+                           (uint32_t)p[3];
+
+            if (len > maxFrameLength) {
+                return false;
+            }
+            if (buf.size() - conn->readPos < 4 + (size_t)len) {
+                break;  // Partial frame, wait for more bytes
+            }
+
+            std::vector<uint8_t> payload(p + 4, p + 4 + len);
+            if (onFrame && !onFrame(conn->loopIndex, conn->fd, std::move(payload))) {
+                pause(conn);
+                break;
+            }
+            conn->readPos += 4 + len;
+        }
+
+        // Compact consumed bytes so the buffer does not grow without bound
+        if (conn->readPos == buf.size()) {
+            buf.clear();
+            conn->readPos = 0;
+        } else if (conn->readPos > buf.size() / 2) {
+            buf.erase(buf.begin(), buf.begin() + conn->readPos);
+            conn->readPos = 0;
+        }
+        return true;
+    }
+
+    void closeConnection(EventLoop* loop, Connection* conn) {
+        epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+
+        if (conn->paused) {
+            for (auto it = loop->paused.begin(); it != loop->paused.end(); ++it) {
+                if (*it == conn) {
+                    loop->paused.erase(it);
+                    break;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(loop->connMutex);
+            loop->connections.erase(conn);
+        }
+
+        // Notify before closing so the fd number cannot be reused meanwhile
+        if (onClose) {
+            onClose(conn->fd);
+        }
+        ::close(conn->fd);
+        delete conn;
+    }
+
+    void runLoop(EventLoop* loop) {
+        struct epoll_event events[MAX_EVENTS];
+
+        while (running.load()) {
+            int n = epoll_wait(loop->epollFd, events, MAX_EVENTS, -1);
+            if (n == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "EpollReactor: epoll_wait failed" << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < n; i++) {
+                void* ptr = events[i].data.ptr;
+
+                if (ptr == &listenFd) {
+                    acceptPending();
+                    continue;
+                }
+                if (ptr == &loop->wakeFd) {
+                    // Shutdown, or resumeReading()
+                    uint64_t count;
+                    ssize_t ignored = ::read(loop->wakeFd, &count, sizeof(count));
+                    (void)ignored;
+                    if (loop->resumeRequested.exchange(false)) {
+                        resumePaused(loop);
+                    }
+                    continue;
+                }
+
+                Connection* conn = static_cast<Connection*>(ptr);
+                bool keep = true;
+
+                if ((events[i].events & EPOLLIN) && !conn->paused) {
+                    keep = readAvailable(conn);
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    keep = false;
+                }
+                // A paused peer that hung up still has unread frames; the
+                // hangup is reported again when it is resumed
+                if ((events[i].events & EPOLLRDHUP) && !conn->paused) {
+                    keep = false;
+                }
+                if (!keep) {
+                    closeConnection(loop, conn);
+                }
+            }
+        }
+    }
+
+public:
+    explicit EpollReactor(uint32_t max_frame_length)
+        : listenFd(-1), maxFrameLength(max_frame_length), running(false), nextLoop(0) {}
+
+    ~EpollReactor() {
+        stop();
+    }
+
+    EpollReactor(const EpollReactor&) = delete;
+    EpollReactor& operator=(const EpollReactor&) = delete;
+
+    void setFrameHandler(FrameHandler handler) { onFrame = std::move(handler); }
+    void setAcceptHandler(ConnectionHandler handler) { onAccept = std::move(handler); }
+    void setCloseHandler(ConnectionHandler handler) { onClose = std::move(handler); }
+
+    // Start event loops on an already listening socket.
+    // The listening socket is watched by the first loop.
+    bool start(int listen_fd, int numThreads) {
+        if (numThreads < 1) {
+            numThreads = 1;
+        }
+
+        listenFd = listen_fd;
+        if (!setNonBlocking(listenFd)) {
+            std::cerr << "EpollReactor: failed to make listening socket non-blocking" << std::endl;
+            return false;
+        }
+
+        for (int i = 0; i < numThreads; i++) {
+            EventLoop* loop = new EventLoop(i);
+            loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            loops.push_back(loop);
+
+            if (loop->epollFd == -1 || loop->wakeFd == -1) {
+                std::cerr << "EpollReactor: failed to create event loop" << std::endl;
+                stop();
+                return false;
+            }
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = &loop->wakeFd;
+            epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev);
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = &listenFd;
+        if (epoll_ctl(loops[0]->epollFd, EPOLL_CTL_ADD, listenFd, &ev) == -1) {
+            std::cerr << "EpollReactor: failed to watch listening socket" << std::endl;
+            stop();
+            return false;
+        }
+
+        running.store(true);
+        for (EventLoop* loop : loops) {
+            loop->thread = std::thread(&EpollReactor::runLoop, this, loop);
+        }
+        return true;
+    }
+
+    // Stop all loops, close every client connection.
+    // The listening socket is left to its owner.
+    void stop() {
+        running.store(false);
+
+        for (EventLoop* loop : loops) {
+            if (loop->wakeFd != -1) {
+                uint64_t one = 1;
+                ssize_t ignored = ::write(loop->wakeFd, &one, sizeof(one));
+                (void)ignored;
+            }
+        }
+
+        for (EventLoop* loop : loops) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(loop->connMutex);
+                for (Connection* conn : loop->connections) {
+                    ::close(conn->fd);
+                    delete conn;
+                }
+                loop->connections.clear();
+            }
+            loop->paused.clear();
+
+            if (loop->epollFd != -1) {
+                ::close(loop->epollFd);
+            }
+            if (loop->wakeFd != -1) {
+                ::close(loop->wakeFd);
+            }
+            delete loop;
+        }
+        loops.clear();
+        listenFd = -1;
+    }
+
+    // Read every paused connection again. Any thread; each loop picks the
+    // request up on its own thread.
+    void resumeReading() {
+        for (EventLoop* loop : loops) {
+            loop->resumeRequested.store(true);
+            uint64_t one = 1;
+            ssize_t ignored = ::write(loop->wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    // Default number of event-loop threads: a few, never one per client
+    static int defaultThreadCount() {
+        unsigned hc = std::thread::hardware_concurrency();
+        if (hc == 0) {
+            hc = 1;
+        }
+        return (int)(hc < 4 ? hc : 4);
+    }
+};
+
+#endif // EPOLL_REACTOR_H
@@ -0,0 +1,187 @@
+#ifndef MESSAGE_VIEW_H
+#define MESSAGE_VIEW_H
+
+#include "Message.h"
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Little-endian loads/stores through memcpy: one mov on x86/ARM, and safe
+// for the unaligned buffers frames arrive in
+inline uint16_t loadLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t loadLE32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline void storeLE16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+inline void storeLE32(uint8_t* p, uint32_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+inline void storeLE64(uint8_t* p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+// Read-only view of a serialized message, reading fields straight out of
+// the buffer it was received in. The buffer must outlive the view.
+//
+// Version 2 layout (fixed 24-byte header, little-endian, naturally aligned
+// relative to the start of the message):
+//   [0]  version = 2      [1] type        [2] topicType    [3] topic_len
+//   [4]  publisher_port (4)
+//   [8]  timestamp (8)
+//   [16] data (4, float bits or StatusValue)
+//   [20] host_len         [21..23] reserved (0)
+//   [24] topic bytes, then host bytes
+//
+// Version 1 (variable-length, big-endian, see Serialization::serialize) is
+// read as well; its field offsets are located once in the constructor.
+class MessageView {
+public:
+    static const uint8_t VERSION_1 = 1;
+    static const uint8_t VERSION_2 = 2;
+    static const size_t V2_HEADER_BYTES = 24;
+
+    MessageView(const uint8_t* buffer, size_t length)
+        : data(buffer), len(length), valid(false), topicOffset(0), topicLen(0), hostOffset(0), hostLen(0),
+          fieldsOffset(0) {
+        if (len < 2) {
+            return;
+        }
+        if (data[0] == VERSION_2) {
+            if (len < V2_HEADER_BYTES) {
+                return;
+            }
+            topicOffset = V2_HEADER_BYTES;
+            topicLen = data[3];
+            hostOffset = topicOffset + topicLen;
+            hostLen = data[20];
+            valid = hostOffset + hostLen <= len;
+        } else if (data[0] == VERSION_1) {
+            // [1][topic_len][topic][host_len][host][port(4)][type][topicType][data(4)][timestamp(8)]
+            topicOffset = 2;
+            topicLen = data[1];
+            if (topicOffset + topicLen >= len) {
+                return;
+            }
+            hostOffset = topicOffset + topicLen + 1;
+            hostLen = data[topicOffset + topicLen];
+            fieldsOffset = hostOffset + hostLen;
+            valid = fieldsOffset + 18 <= len;
+        }
+    }
+
+    bool isValid() const { return valid; }
+    uint8_t version() const { return data[0]; }
+    size_t size() const { return len; }
+
+    std::string_view topic() const {
+        return std::string_view(reinterpret_cast<const char*>(data + topicOffset), topicLen);
+    }
+
+    std::string_view publisherHost() const {
+        return std::string_view(reinterpret_cast<const char*>(data + hostOffset), hostLen);
+    }
+
+    int publisherPort() const {
+        return version() == VERSION_2 ? (int)loadLE32(data + 4) : (int)loadBE(data + fieldsOffset, 4);
+    }
+
+    MessageType type() const {
+        return static_cast<MessageType>(version() == VERSION_2 ? data[1] : data[fieldsOffset + 4]);
+    }
+
+    TopicType topicType() const {
+        return static_cast<TopicType>(version() == VERSION_2 ? data[2] : data[fieldsOffset + 5]);
+    }
+
+    // Raw 32-bit payload: float bits for ANALOG, StatusValue for STATUS
+    uint32_t rawData() const {
+        return version() == VERSION_2 ? loadLE32(data + 16) : (uint32_t)loadBE(data + fieldsOffset + 6, 4);
+    }
+
+    float analogValue() const {
+        uint32_t bits = rawData();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    StatusValue statusValue() const {
+        return static_cast<StatusValue>(rawData());
+    }
+
+    std::time_t timestamp() const {
+        return (std::time_t)(int64_t)(version() == VERSION_2 ? loadLE64(data + 8)
+                                                              : loadBE(data + fieldsOffset + 10, 8));
+    }
+
+    // Materialize a Message (copies the strings into its fixed arrays)
+    Message toMessage() const {
+        Message msg;
+        if (!valid) {
+            return msg;
+        }
+        size_t n = topicLen < Message::MAX_TOPIC_LEN ? topicLen : Message::MAX_TOPIC_LEN - 1;
+        memcpy(msg.topic, data + topicOffset, n);
+        msg.topic[n] = '\0';
+        n = hostLen < Message::MAX_HOST_LEN ? hostLen : Message::MAX_HOST_LEN - 1;
+        memcpy(msg.publisher_host, data + hostOffset, n);
+        msg.publisher_host[n] = '\0';
+        msg.publisher_port = publisherPort();
+        msg.type = type();
+        msg.topicType = topicType();
+        uint32_t bits = rawData();
+        memcpy(&msg.data, &bits, sizeof(bits));
+        msg.timestamp = timestamp();
+        return msg;
+    }
+
+private:
+    const uint8_t* data;
+    size_t len;
+    bool valid;
+    size_t topicOffset;
+    size_t topicLen;
+    size_t hostOffset;
+    size_t hostLen;
+    size_t fieldsOffset;    // Version 1: where the fixed fields after the host start
+
+    static uint64_t loadBE(const uint8_t* p, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+};
+
+#endif // MESSAGE_VIEW_H
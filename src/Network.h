@@ -1,16 +1,208 @@
 #ifndef NETWORK_H
 #define NETWORK_H
 
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+
+// Map the Winsock names used throughout the code onto POSIX sockets
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define closesocket(s) ::close(s)
+#define ZeroMemory(p, n) memset((p), 0, (n))
+#endif
+
+#ifdef __linux__
+#define PUBSUB_USE_EPOLL 1
+#include "EpollReactor.h"
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <string>
 #include <cstring>
 #include <iostream>
 #include <chrono>
 #include <algorithm>
+#include "DataStructures/MpscQueue.h"
+
+// Largest frame payload accepted from the network
+// (64 KiB so history replies can batch many messages per frame)
+static const uint32_t MAX_FRAME_LENGTH = 65536;
+
+// Apply send/receive timeouts in a platform independent way
+inline void setSocketTimeouts(SOCKET s, int timeoutMs) {
+#ifdef _WIN32
+    DWORD timeout = timeoutMs;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+#else
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+#endif
+}
+
+// Numeric IPv4 address of a connected socket's remote end (peer = true) or
+// local end, written to out. False if the socket has no address.
+inline bool socketAddress(SOCKET s, bool peer, char* out, size_t size) {
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    int rc = peer ? getpeername(s, (struct sockaddr*)&addr, &addrLen)
+                  : getsockname(s, (struct sockaddr*)&addr, &addrLen);
+    if (rc != 0 || addr.sin_family != AF_INET) {
+        return false;
+    }
+    return inet_ntop(AF_INET, &addr.sin_addr, out, (socklen_t)size) != nullptr;
+}
+
+// 127.0.0.0/8, as written by socketAddress
+inline bool isLoopbackAddress(const char* address) {
+    return strncmp(address, "127.", 4) == 0;
+}
+
+// Send the whole buffer, retrying on partial writes.
+// Non-blocking sockets (epoll backend) wait until writable instead of failing.
+inline bool sendAll(SOCKET s, const uint8_t* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int n = ::send(s, (const char*)data + sent, (int)(len - sent), MSG_NOSIGNAL);
+        if (n == SOCKET_ERROR) {
+#ifndef _WIN32
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd;
+                pfd.fd = s;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                if (::poll(&pfd, 1, 5000) > 0) {
+                    continue;
+                }
+            }
+#endif
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// One buffer of a gather write
+struct SendPart {
+    const uint8_t* data;
+    size_t len;
+};
+
+static const int MAX_SEND_PARTS = 8;
+
+// Send several buffers back to back as one stream with a single gather
+// write (sendmsg / WSASend) per attempt, retrying on partial writes.
+// parts is consumed: entries are advanced past what has been sent.
+inline bool sendAllParts(SOCKET s, SendPart* parts, int count) {
+    int first = 0;
+    while (first < count) {
+        if (parts[first].len == 0) {
+            first++;
+            continue;
+        }
+        
+        size_t sent;
+#ifdef _WIN32
+        WSABUF bufs[MAX_SEND_PARTS];
+        DWORD n = 0;
+        for (int i = first; i < count && n < MAX_SEND_PARTS; i++, n++) {
+            bufs[n].buf = (CHAR*)parts[i].data;
+            bufs[n].len = (ULONG)parts[i].len;
+        }
+        DWORD bytes = 0;
+        if (WSASend(s, bufs, n, &bytes, 0, NULL, NULL) == SOCKET_ERROR) {
+            return false;
+        }
+        sent = bytes;
+#else
+        struct iovec iov[MAX_SEND_PARTS];
+        int n = 0;
+        for (int i = first; i < count && n < MAX_SEND_PARTS; i++, n++) {
+            iov[n].iov_base = (void*)parts[i].data;
+            iov[n].iov_len = parts[i].len;
+        }
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_iov = iov;
+        header.msg_iovlen = n;
+        ssize_t result = ::sendmsg(s, &header, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd;
+                pfd.fd = s;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                if (::poll(&pfd, 1, 5000) > 0) {
+                    continue;
+                }
+            }
+            return false;
+        }
+        sent = (size_t)result;
+#endif
+        
+        // Skip the buffers written completely, trim the one written partly
+        while (first < count && sent >= parts[first].len) {
+            sent -= parts[first].len;
+            first++;
+        }
+        if (first < count) {
+            parts[first].data += sent;
+            parts[first].len -= sent;
+        }
+    }
+    return true;
+}
+
+// Send one length-prefixed frame whose payload is head followed by body,
+// prefix included, in a single gather write
+inline bool sendFrame(SOCKET s, const uint8_t* head, size_t headLen,
+                      const uint8_t* body = nullptr, size_t bodyLen = 0) {
+    uint32_t len = (uint32_t)(headLen + bodyLen);
+    uint8_t lenBytes[4] = {
+        (uint8_t)((len >> 24) & 0xFF),
+        (uint8_t)((len >> 16) & 0xFF),
+        (uint8_t)((len >> 8) & 0xFF),
+        (uint8_t)(len & 0xFF)
+    };
+    SendPart parts[3] = { { lenBytes, 4 }, { head, headLen }, { body, bodyLen } };
+    return sendAllParts(s, parts, 3);
+}
 
 // ==================== Console Handler ====================
 class ConsoleHandler {
@@ -98,10 +290,12 @@ private:
     static void initWinsock() {
         std::lock_guard<std::mutex> lock(wsMutex);
         if (!wsInitialized) {
+#ifdef _WIN32
             WSADATA wsaData;
             if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
                 std::cerr << "WSAStartup failed" << std::endl;
             }
+#endif
             wsInitialized = true;
         }
     }
@@ -140,9 +334,7 @@ public:
         }
         
         // Set connection timeout
-        DWORD timeout = 5000; // 5 seconds
-        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
-        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+        setSocketTimeouts(socket, 5000); // 5 seconds
         
         int connectResult = ::connect(socket, result->ai_addr, (int)result->ai_addrlen);
         freeaddrinfo(result);
@@ -154,36 +346,25 @@ public:
             return false;
         }
         
+        // Frames are written as prefix + payload; never hold them back for Nagle
+        int noDelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+        
         connected = true;
         return true;
     }
     
     bool sendMessage(const std::vector<uint8_t>& data) {
+        return sendMessage(data.data(), data.size());
+    }
+    
+    // Length prefix (4 bytes, big-endian) and payload go out in one write;
+    // the payload may be split over two buffers (e.g. header + batch body)
+    bool sendMessage(const uint8_t* head, size_t headLen, const uint8_t* body = nullptr, size_t bodyLen = 0) {
         if (!connected || socket == INVALID_SOCKET) {
             return false;
         }
-        
-        // Send length prefix (4 bytes, big-endian)
-        uint32_t len = data.size();
-        uint8_t len_bytes[4] = {
-            (uint8_t)((len >> 24) & 0xFF),
-            (uint8_t)((len >> 16) & 0xFF),
-            (uint8_t)((len >> 8) & 0xFF),
-            (uint8_t)(len & 0xFF)
-        };
-        
-        int sent = ::send(socket, (const char*)len_bytes, 4, 0);
-        if (sent == SOCKET_ERROR) {
-            return false;
-        }
-        
-        // Send payload
-        sent = ::send(socket, (const char*)data.data(), data.size(), 0);
-        if (sent == SOCKET_ERROR) {
-            return false;
-        }
-        
-        return true;
+        return sendFrame(socket, head, headLen, body, bodyLen);
     }
     
     std::vector<uint8_t> receiveMessage() {
@@ -205,7 +386,7 @@ public:
                        ((uint32_t)len_bytes[2] << 8) |
                        (uint32_t)len_bytes[3];
         
-        if (len > 10000) {
+        if (len > MAX_FRAME_LENGTH) {
             std::cerr << "TcpClient: invalid message length" << std::endl;
             return result;
         }
@@ -232,10 +413,55 @@ public:
     bool isConnected() const {
         return connected && socket != INVALID_SOCKET;
     }
+    
+    // Numeric address this end of the connection uses ("" if not connected)
+    std::string getLocalAddress() const {
+        char address[INET_ADDRSTRLEN];
+        if (!isConnected() || !socketAddress(socket, false, address, sizeof(address))) {
+            return "";
+        }
+        return address;
+    }
+    
+    // Check without blocking whether the peer has closed or reset the connection.
+    // Used before reusing an idle connection, where a send could otherwise
+    // "succeed" into a socket the other side has already abandoned.
+    bool isAlive() {
+        if (!isConnected()) {
+            return false;
+        }
+        
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(socket, &readSet);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+        
+        int ready = ::select((int)socket + 1, &readSet, nullptr, nullptr, &tv);
+        if (ready == 0) {
+            return true;   // Nothing pending: still open
+        }
+        if (ready == SOCKET_ERROR) {
+            return false;
+        }
+        
+        char probe;
+        int n = ::recv(socket, &probe, 1, MSG_PEEK);
+        return n > 0;      // 0 = orderly close, SOCKET_ERROR = reset
+    }
 };
 
 
 // ==================== TCP Server ====================
+// Frame received by TcpServer together with the connection it arrived on
+struct InboundFrame {
+    SOCKET connection;
+    std::vector<uint8_t> payload;
+    
+    InboundFrame() : connection(INVALID_SOCKET) {}
+};
+
 class TcpServer {
 private:
     SOCKET listenSocket;
@@ -243,10 +469,29 @@ private:
     bool listening;
     std::thread acceptThread;
     std::atomic<bool> running;
-    std::mutex clientSocketMutex;
-    std::vector<SOCKET> clientSockets;  // Store multiple clients
-    std::mutex messageQueueMutex;
-    std::vector<std::vector<uint8_t>> messageQueue;
+    // One accepted connection. sendMutex keeps frames from different
+    // threads whole and lets a send run without clientSocketMutex; closing
+    // takes it too, so the fd cannot be reused under a send in progress.
+    struct ClientConnection {
+        SOCKET socket;
+        std::mutex sendMutex;
+        
+        explicit ClientConnection(SOCKET s) : socket(s) {}
+    };
+    
+    std::mutex clientSocketMutex;       // Guards the list only, never held while sending
+    std::vector<std::shared_ptr<ClientConnection>> clientSockets;
+    MpscQueue<InboundFrame> messageQueue;  // Frames from all client handlers
+    std::function<bool(int, SOCKET, std::vector<uint8_t>&&)> frameSink;  // Optional: bypasses the queue
+    std::function<void(SOCKET)> closeSink;  // Optional: told about every closed connection
+    int maxQueuedFrames;     // 0 = unbounded (see setMaxQueuedFrames)
+    std::atomic<bool> readersPaused;   // A reader found the queue full
+    std::mutex pauseMutex;
+    std::condition_variable readersResumed;
+#ifdef PUBSUB_USE_EPOLL
+    EpollReactor reactor;    // Multiplexes all client sockets on a few threads
+    int ioThreads;           // Number of event-loop threads
+#endif
     
     static bool wsInitialized;
     static std::mutex wsMutex;
@@ -254,25 +499,140 @@ private:
     static void initWinsock() {
         std::lock_guard<std::mutex> lock(wsMutex);
         if (!wsInitialized) {
+#ifdef _WIN32
             WSADATA wsaData;
             if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
                 std::cerr << "WSAStartup failed" << std::endl;
             }
+#endif
             wsInitialized = true;
         }
     }
     
+    // Queue a received frame. False when the queue is full: the frame is
+    // left in payload and the caller stops reading that connection until
+    // resumeReaders(), so its receive buffer fills and TCP flow control
+    // throttles the sender.
+    bool enqueueFrame(SOCKET client, std::vector<uint8_t>& payload) {
+        if (maxQueuedFrames > 0 && messageQueue.size() >= maxQueuedFrames) {
+            // Pairs with the fence in resumeReaders(): either the consumer
+            // sees the flag or we see the frames it has taken
+            readersPaused.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (messageQueue.size() > maxQueuedFrames / 2) {
+                return false;
+            }
+        }
+
+        InboundFrame frame;
+        frame.connection = client;
+        frame.payload = std::move(payload);
+        messageQueue.push(std::move(frame));
+        return true;
+    }
+    
+    // Consumer side: let paused readers go once the queue is down to half
+    void resumeReaders() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!readersPaused.load() || messageQueue.size() > maxQueuedFrames / 2) {
+            return;
+        }
+        if (!readersPaused.exchange(false)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pauseMutex);
+#ifdef PUBSUB_USE_EPOLL
+        if (running.load()) {
+            reactor.resumeReading();
+        }
+#else
+        readersResumed.notify_all();
+#endif
+    }
+    
+    void addClient(SOCKET client) {
+        std::lock_guard<std::mutex> lock(clientSocketMutex);
+        clientSockets.push_back(std::make_shared<ClientConnection>(client));
+    }
+    
+    std::shared_ptr<ClientConnection> findClient(SOCKET client) {
+        std::lock_guard<std::mutex> lock(clientSocketMutex);
+        for (const auto& conn : clientSockets) {
+            if (conn->socket == client) {
+                return conn;
+            }
+        }
+        return nullptr;
+    }
+    
+    // Forget a connection before its fd is closed; waits for a send to it
+    // that is still in progress. False if it was already gone (stop()).
+    bool removeClient(SOCKET client) {
+        std::shared_ptr<ClientConnection> removed;
+        {
+            std::lock_guard<std::mutex> lock(clientSocketMutex);
+            for (auto it = clientSockets.begin(); it != clientSockets.end(); ++it) {
+                if ((*it)->socket == client) {
+                    removed = *it;
+                    clientSockets.erase(it);
+                    break;
+                }
+            }
+        }
+        if (!removed) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> sendLock(removed->sendMutex);
+            removed->socket = INVALID_SOCKET;
+        }
+        if (closeSink) {
+            closeSink(client);
+        }
+        return true;
+    }
+    
+    // Client handler thread: stop() may have closed the socket already
+    void closeClient(SOCKET client) {
+        if (removeClient(client)) {
+            closesocket(client);
+        }
+    }
+    
+    static bool sendOn(ClientConnection& conn, const std::vector<uint8_t>& data) {
+        std::lock_guard<std::mutex> sendLock(conn.sendMutex);
+        if (conn.socket == INVALID_SOCKET) {
+            return false;   // Closed while we were waiting
+        }
+        return sendFrame(conn.socket, data.data(), data.size());
+    }
+    
+#ifdef PUBSUB_USE_EPOLL
+    void installReactorHandlers() {
+        reactor.setAcceptHandler([this](int fd) {
+            addClient(fd);
+        });
+        reactor.setCloseHandler([this](int fd) {
+            removeClient(fd);
+        });
+        reactor.setFrameHandler([this](int loopIndex, int fd, std::vector<uint8_t>&& payload) {
+            if (frameSink) {
+                return frameSink(loopIndex, fd, std::move(payload));
+            }
+            return enqueueFrame(fd, payload);
+        });
+    }
+#endif
+    
     void acceptLoop() {
         struct sockaddr_in clientAddr;
-        int clientAddrLen = sizeof(clientAddr);
+        socklen_t clientAddrLen = sizeof(clientAddr);
         
         while (running.load()) {
+            clientAddrLen = sizeof(clientAddr);
             SOCKET client = ::accept(listenSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
             if (client != INVALID_SOCKET) {
-                {
-                    std::lock_guard<std::mutex> lock(clientSocketMutex);
-                    clientSockets.push_back(client);
-                }
+                addClient(client);
                 
                 // Spawn thread to handle this client
                 std::thread(&TcpServer::handleClient, this, client).detach();
@@ -288,15 +648,7 @@ private:
             uint8_t len_bytes[4];
             int received = ::recv(client, (char*)len_bytes, 4, MSG_WAITALL);
             if (received != 4) {
-                closesocket(client);
-                
-                {
-                    std::lock_guard<std::mutex> lock(clientSocketMutex);
-                    auto it = std::find(clientSockets.begin(), clientSockets.end(), client);
-                    if (it != clientSockets.end()) {
-                        clientSockets.erase(it);
-                    }
-                }
+                closeClient(client);
                 return;
             }
             
@@ -305,16 +657,8 @@ private:
                            ((uint32_t)len_bytes[2] << 8) |
                            (uint32_t)len_bytes[3];
             
-            if (len > 10000) {
-                closesocket(client);
-                
-                {
-                    std::lock_guard<std::mutex> lock(clientSocketMutex);
-                    auto it = std::find(clientSockets.begin(), clientSockets.end(), client);
-                    if (it != clientSockets.end()) {
-                        clientSockets.erase(it);
-                    }
-                }
+            if (len > MAX_FRAME_LENGTH) {
+                closeClient(client);
                 return;
             }
             
@@ -322,29 +666,86 @@ private:
             std::vector<uint8_t> payload(len);
             received = ::recv(client, (char*)payload.data(), len, MSG_WAITALL);
             if (received != (int)len) {
-                closesocket(client);
-                
-                {
-                    std::lock_guard<std::mutex> lock(clientSocketMutex);
-                    auto it = std::find(clientSockets.begin(), clientSockets.end(), client);
-                    if (it != clientSockets.end()) {
-                        clientSockets.erase(it);
-                    }
-                }
+                closeClient(client);
                 return;
             }
             
-            {
-                std::lock_guard<std::mutex> lock(messageQueueMutex);
-                messageQueue.push_back(payload);
+            while (!enqueueFrame(client, payload)) {
+                std::unique_lock<std::mutex> lock(pauseMutex);
+                readersResumed.wait(lock, [this] { return !readersPaused.load() || !running.load(); });
+                if (!running.load()) {
+                    return;
+                }
             }
         }
     }
     
 public:
-    TcpServer() : listenSocket(INVALID_SOCKET), port(0), listening(false), running(false) {
+#ifdef PUBSUB_USE_EPOLL
+    TcpServer() : listenSocket(INVALID_SOCKET), port(0), listening(false), running(false), maxQueuedFrames(0),
+                  readersPaused(false), reactor(MAX_FRAME_LENGTH), ioThreads(EpollReactor::defaultThreadCount()) {
         initWinsock();
     }
+#else
+    TcpServer() : listenSocket(INVALID_SOCKET), port(0), listening(false), running(false), maxQueuedFrames(0),
+                  readersPaused(false) {
+        initWinsock();
+    }
+#endif
+    
+    // Number of event-loop threads used by the epoll backend (call before start)
+    void setIoThreads(int count) {
+#ifdef PUBSUB_USE_EPOLL
+        ioThreads = count;
+#else
+        (void)count;
+#endif
+    }
+    
+    // Number of threads that can call a frame sink (0 = sinks not supported,
+    // frames are only available through receiveMessage)
+    int getIngestThreadCount() const {
+#ifdef PUBSUB_USE_EPOLL
+        return ioThreads < 1 ? 1 : ioThreads;
+#else
+        return 0;
+#endif
+    }
+    
+    // Deliver frames straight to sink(ingestIndex, connection, payload) on the receiving
+    // I/O thread instead of queueing them (call before start). Each ingest
+    // index is only ever used by one thread. Needs getIngestThreadCount() > 0.
+    // A sink that cannot take a frame returns false and leaves payload
+    // intact; that connection is then not read until resumeReading().
+    void setFrameSink(std::function<bool(int, SOCKET, std::vector<uint8_t>&&)> sink) {
+        frameSink = std::move(sink);
+    }
+    
+    // Call sink(connection) when a client connection goes away, before its
+    // fd can be reused (call before start). Runs on the thread that noticed
+    // the close; frames it sent may still be queued.
+    void setCloseSink(std::function<void(SOCKET)> sink) {
+        closeSink = std::move(sink);
+    }
+    
+    // Offer refused frames to the sink again. Any thread.
+    void resumeReading() {
+#ifdef PUBSUB_USE_EPOLL
+        std::lock_guard<std::mutex> lock(pauseMutex);
+        if (running.load()) {
+            reactor.resumeReading();
+        }
+#endif
+    }
+    
+    // Bound the received-frame queue (call before start; 0 = unbounded).
+    // A connection whose frame fills it is not read again until the consumer
+    // has taken half of the queue, so a slow consumer pushes back on the
+    // sending peers. With the epoll backend only those connections pause;
+    // their event loop keeps serving the rest.
+    void setMaxQueuedFrames(int count) {
+        maxQueuedFrames = count > 0 ? count : 0;
+    }
     
     ~TcpServer() {
         stop();
@@ -366,6 +767,7 @@ public:
         }
         
         struct sockaddr_in serverAddr;
+        ZeroMemory(&serverAddr, sizeof(serverAddr));
         serverAddr.sin_family = AF_INET;
         serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // localhost only
         serverAddr.sin_port = htons(port);
@@ -386,76 +788,117 @@ public:
         
         listening = true;
         running.store(true);
+        messageQueue.reopen();
+        
+#ifdef PUBSUB_USE_EPOLL
+        installReactorHandlers();
+        if (!reactor.start(listenSocket, ioThreads)) {
+            std::cerr << "TcpServer: failed to start epoll reactor" << std::endl;
+            running.store(false);
+            closesocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+            listening = false;
+            return false;
+        }
+#else
         acceptThread = std::thread(&TcpServer::acceptLoop, this);
         acceptThread.detach();
+#endif
         
         return true;
     }
     
-    std::vector<uint8_t> receiveMessage() {
-        std::vector<uint8_t> result;
-        
-        {
-            std::lock_guard<std::mutex> lock(messageQueueMutex);
-            if (!messageQueue.empty()) {
-                result = messageQueue.front();
-                messageQueue.erase(messageQueue.begin());
-            }
+    // Return the next received frame, waiting up to timeoutMs for one to arrive.
+    // Wakes as soon as a frame is queued; returns an empty vector on timeout
+    // or when the server is stopped. Must be called from a single consumer thread.
+    std::vector<uint8_t> receiveMessage(int timeoutMs = 100) {
+        InboundFrame frame;
+        if (messageQueue.waitPop(frame, std::chrono::milliseconds(timeoutMs))) {
+            resumeReaders();
         }
-        
-        if (result.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::move(frame.payload);
+    }
+    
+    // Non-blocking receiveMessage: the next frame, or an empty vector if none
+    // is queued. For consumers that busy-poll instead of sleeping.
+    std::vector<uint8_t> pollMessage() {
+        InboundFrame frame;
+        if (messageQueue.pop(frame)) {
+            resumeReaders();
         }
-        
-        return result;
+        return std::move(frame.payload);
     }
     
-    bool sendMessage(const std::vector<uint8_t>& data) {
-        std::lock_guard<std::mutex> lock(clientSocketMutex);
-        
-        if (clientSockets.empty()) {
+    // Same as receiveMessage, but also reports the connection the frame came
+    // from so the caller can answer with sendTo(). False on timeout/stop.
+    bool receiveFrame(InboundFrame& frame, int timeoutMs = 100) {
+        if (!messageQueue.waitPop(frame, std::chrono::milliseconds(timeoutMs))) {
             return false;
         }
-        
-        // Send to the first connected client (or could be improved to track specific clients)
-        SOCKET client = clientSockets[0];
-        
-        // Send length prefix
-        uint32_t len = data.size();
-        uint8_t len_bytes[4] = {
-            (uint8_t)((len >> 24) & 0xFF),
-            (uint8_t)((len >> 16) & 0xFF),
-            (uint8_t)((len >> 8) & 0xFF),
-            (uint8_t)(len & 0xFF)
-        };
-        
-        int sent = ::send(client, (const char*)len_bytes, 4, 0);
-        if (sent == SOCKET_ERROR) {
-            return false;
+        resumeReaders();
+        return true;
+    }
+    
+    // Number of received frames waiting to be consumed
+    int getQueuedFrameCount() const {
+        return messageQueue.size();
+    }
+    
+    bool sendMessage(const std::vector<uint8_t>& data) {
+        std::shared_ptr<ClientConnection> first;
+        {
+            std::lock_guard<std::mutex> lock(clientSocketMutex);
+            if (clientSockets.empty()) {
+                return false;
+            }
+            // Send to the first connected client (or could be improved to track specific clients)
+            first = clientSockets[0];
         }
-        
-        // Send payload
-        sent = ::send(client, (const char*)data.data(), data.size(), 0);
-        if (sent == SOCKET_ERROR) {
+        return sendOn(*first, data);
+    }
+    
+    // Send a frame back over a specific client connection (e.g. a query reply).
+    // Fails if the connection has been closed meanwhile. A slow peer only
+    // holds up senders to that same connection.
+    bool sendTo(SOCKET client, const std::vector<uint8_t>& data) {
+        std::shared_ptr<ClientConnection> conn = findClient(client);
+        if (!conn) {
             return false;
         }
-        
-        return true;
+        return sendOn(*conn, data);
     }
     
     void stop() {
         running.store(false);
+        messageQueue.close();   // Release a consumer blocked in receiveMessage()
+        {
+            // Paused readers give up; a resumeReaders() in progress finishes
+            // before the reactor goes away
+            std::lock_guard<std::mutex> lock(pauseMutex);
+        }
+        readersResumed.notify_all();
         
+        // Detach every connection from senders before its fd is closed
+        std::vector<std::shared_ptr<ClientConnection>> closing;
         {
             std::lock_guard<std::mutex> lock(clientSocketMutex);
-            for (SOCKET client : clientSockets) {
-                if (client != INVALID_SOCKET) {
-                    closesocket(client);
-                }
+            closing.swap(clientSockets);
+        }
+        for (const auto& conn : closing) {
+            std::lock_guard<std::mutex> sendLock(conn->sendMutex);
+#ifndef PUBSUB_USE_EPOLL
+            if (conn->socket != INVALID_SOCKET) {
+                closesocket(conn->socket);
             }
-            clientSockets.clear();
+#endif
+            conn->socket = INVALID_SOCKET;
         }
         
+#ifdef PUBSUB_USE_EPOLL
+        // The reactor owns and closes the client sockets itself
+        reactor.stop();
+#endif
+        
         if (listenSocket != INVALID_SOCKET) {
             closesocket(listenSocket);
             listenSocket = INVALID_SOCKET;
@@ -2,13 +2,15 @@
 #define SERIALIZATION_H
 
 #include "Message.h"
+#include "MessageView.h"
 #include <vector>
 #include <cstring>
 #include <cstdint>
 
 class Serialization {
 public:
-    // Serialize a Message to binary format
+    // Serialize a Message to the version 1 format (kept for existing
+    // publishers and subscribers; new code uses encode())
     // Format: [protocol_version(1)] [topic_len(1)] [topic(var)] [host_len(1)] [host(var)] [port(4)] [type(1)] [topicType(1)] [data(4)] [timestamp(8)]
     static std::vector<uint8_t> serialize(const Message& msg) {
         std::vector<uint8_t> buffer;
@@ -72,8 +74,51 @@ public:
         return buffer;
     }
     
-    // Deserialize binary format back to Message
+    // Size of a message in the version 2 format (see MessageView)
+    static size_t encodedSize(const Message& msg) {
+        return MessageView::V2_HEADER_BYTES + strnlen(msg.topic, 255) + strnlen(msg.publisher_host, 255);
+    }
+    
+    // Encode a message in the version 2 format into a caller-supplied buffer.
+    // Returns the number of bytes written, or 0 if capacity is too small.
+    static size_t encode(const Message& msg, uint8_t* out, size_t capacity) {
+        size_t topicLen = strnlen(msg.topic, 255);
+        size_t hostLen = strnlen(msg.publisher_host, 255);
+        size_t total = MessageView::V2_HEADER_BYTES + topicLen + hostLen;
+        if (total > capacity) {
+            return 0;
+        }
+        
+        uint32_t dataBits;
+        memcpy(&dataBits, &msg.data, sizeof(dataBits));
+        
+        out[0] = MessageView::VERSION_2;
+        out[1] = static_cast<uint8_t>(msg.type);
+        out[2] = static_cast<uint8_t>(msg.topicType);
+        out[3] = (uint8_t)topicLen;
+        storeLE32(out + 4, (uint32_t)msg.publisher_port);
+        storeLE64(out + 8, (uint64_t)(int64_t)msg.timestamp);
+        storeLE32(out + 16, dataBits);
+        out[20] = (uint8_t)hostLen;
+        out[21] = out[22] = out[23] = 0;
+        memcpy(out + MessageView::V2_HEADER_BYTES, msg.topic, topicLen);
+        memcpy(out + MessageView::V2_HEADER_BYTES + topicLen, msg.publisher_host, hostLen);
+        return total;
+    }
+    
+    // Version 2 encoding into a new vector
+    static std::vector<uint8_t> encode(const Message& msg) {
+        std::vector<uint8_t> buffer(encodedSize(msg));
+        encode(msg, buffer.data(), buffer.size());
+        return buffer;
+    }
+    
+    // Deserialize binary format back to Message (either protocol version)
     static Message deserialize(const uint8_t* data, size_t len) {
+        if (len > 0 && data[0] == MessageView::VERSION_2) {
+            return MessageView(data, len).toMessage();
+        }
+        
         Message msg;
         
         if (len < 20) {
@@ -153,6 +198,78 @@ public:
         
         return msg;
     }
+    
+    // Locate the topic inside a serialized message without copying it
+    // (not NUL-terminated). Returns false if the buffer is malformed.
+    static bool peekTopic(const uint8_t* data, size_t len, const char*& topic, size_t& topicLen) {
+        MessageView view(data, len);
+        if (!view.isValid()) {
+            return false;
+        }
+        topic = view.topic().data();
+        topicLen = view.topic().size();
+        return true;
+    }
+    
+    // Read the timestamp of a serialized message in place
+    static bool peekTimestamp(const uint8_t* data, size_t len, long& ts) {
+        MessageView view(data, len);
+        if (!view.isValid()) {
+            return false;
+        }
+        ts = (long)view.timestamp();
+        return true;
+    }
+    
+    // Serialize a list of messages (version 2) into one payload
+    // Format: [count(2)] { [msg_len(2)] [serialized message] } * count
+    // Stops before exceeding maxBytes; returns how many messages were written.
+    static int serializeList(const std::vector<Message>& messages, size_t maxBytes, std::vector<uint8_t>& out) {
+        size_t countPos = out.size();
+        out.push_back(0);
+        out.push_back(0);
+        
+        int count = 0;
+        for (const Message& msg : messages) {
+            size_t size = encodedSize(msg);
+            if (out.size() + 2 + size > maxBytes || count == 0xFFFF) {
+                break;
+            }
+            out.push_back((size >> 8) & 0xFF);
+            out.push_back(size & 0xFF);
+            size_t pos = out.size();
+            out.resize(pos + size);
+            encode(msg, out.data() + pos, size);
+            count++;
+        }
+        
+        out[countPos] = (count >> 8) & 0xFF;
+        out[countPos + 1] = count & 0xFF;
+        return count;
+    }
+    
+    // Parse a payload written by serializeList; returns false if it is truncated
+    static bool deserializeList(const uint8_t* data, size_t len, std::vector<Message>& out) {
+        if (len < 2) {
+            return false;
+        }
+        
+        int count = ((int)data[0] << 8) | data[1];
+        size_t pos = 2;
+        for (int i = 0; i < count; i++) {
+            if (pos + 2 > len) {
+                return false;
+            }
+            size_t msgLen = ((size_t)data[pos] << 8) | data[pos + 1];
+            pos += 2;
+            if (pos + msgLen > len) {
+                return false;
+            }
+            out.push_back(deserialize(data + pos, msgLen));
+            pos += msgLen;
+        }
+        return true;
+    }
 };
 
 #endif // SERIALIZATION_H
@@ -0,0 +1,359 @@
+#include "DeliveryExecutor.h"
+
+DeliveryExecutor::DeliveryExecutor(int numThreads)
+    : numWorkers(numThreads), running(false), callers(0), stealableLanes(0), sleepingWorkers(0),
+      queueDepth(0), activeWorkers(0), depthWaiters(0) {
+    if (numWorkers <= 0) {
+        numWorkers = (int)std::thread::hardware_concurrency();
+        if (numWorkers <= 0) {
+            numWorkers = 2;
+        }
+    }
+}
+
+DeliveryExecutor::~DeliveryExecutor() {
+    stop();
+}
+
+void DeliveryExecutor::start() {
+    if (running) {
+        return;
+    }
+
+    running = true;
+    for (int i = 0; i < numWorkers; i++) {
+        workers.push_back(new Worker());
+    }
+    for (int i = 0; i < numWorkers; i++) {
+        workers[i]->thread = std::thread(&DeliveryExecutor::workerLoop, this, i);
+    }
+}
+
+void DeliveryExecutor::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    for (Worker* worker : workers) {
+        worker->wake.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(depthMutex);
+    }
+    depthDropped.notify_all();
+
+    // Calls that got past enter() before running dropped still use workers
+    while (callers.load() > 0) {
+        std::this_thread::yield();
+    }
+
+    for (Worker* worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+        delete worker;
+    }
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(lanesMutex);
+    lanes.clear();
+    stealableLanes = 0;
+    queueDepth = 0;
+}
+
+bool DeliveryExecutor::enter() {
+    // Sequentially consistent on both sides: either stop() sees the count or
+    // we see !running
+    callers.fetch_add(1);
+    if (!running.load()) {
+        callers.fetch_sub(1);
+        return false;
+    }
+    return true;
+}
+
+void DeliveryExecutor::leave() {
+    callers.fetch_sub(1);
+}
+
+std::shared_ptr<DeliveryExecutor::Lane>& DeliveryExecutor::getLane(uint64_t key) {
+    std::shared_ptr<Lane>& lane = lanes[key];
+    if (!lane) {
+        lane = std::make_shared<Lane>(key, (int)(key % (uint64_t)numWorkers));
+    }
+    return lane;
+}
+
+int DeliveryExecutor::targetWorker(const Lane& lane) {
+    int pinned = lane.pinnedWorker.load(std::memory_order_relaxed);
+    return pinned >= 0 ? pinned : lane.homeWorker;
+}
+
+void DeliveryExecutor::schedule(int workerIndex, const std::shared_ptr<Lane>& lane) {
+    Worker* worker = workers[workerIndex];
+    bool pinned = lane->pinnedWorker.load(std::memory_order_relaxed) == workerIndex;
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->ready.push_back(ReadyLane{ lane, pinned });
+    }
+    if (pinned) {
+        worker->pinnedLanes.fetch_add(1);
+    } else {
+        stealableLanes.fetch_add(1);
+    }
+
+    // Only touch the sleep mutex when somebody may be waiting on it
+    if (sleepingWorkers.load() > 0) {
+        wakeWorker(workerIndex, pinned);
+    }
+}
+
+void DeliveryExecutor::wakeWorker(int workerIndex, bool pinned) {
+    // A pinned lane needs its own worker; anyone may take a stealable one,
+    // preferably the worker it was queued on
+    Worker* target = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (workers[workerIndex]->sleeping) {
+            target = workers[workerIndex];
+        } else if (!pinned) {
+            for (Worker* worker : workers) {
+                if (worker->sleeping) {
+                    target = worker;
+                    break;
+                }
+            }
+        }
+        if (target != nullptr) {
+            target->sleeping = false;
+            sleepingWorkers.fetch_sub(1);
+        }
+    }
+    if (target != nullptr) {
+        target->wake.notify_one();
+    }
+}
+
+void DeliveryExecutor::submit(uint64_t key, Task task) {
+    if (!enter()) {
+        return;
+    }
+
+    std::shared_ptr<Lane> lane;
+    {
+        std::lock_guard<std::mutex> lock(lanesMutex);
+        lane = getLane(key);
+    }
+    bool needsScheduling = false;
+    {
+        std::lock_guard<std::mutex> lock(lane->mutex);
+        lane->tasks.push_back(PendingTask{ std::move(task), std::chrono::steady_clock::now() });
+        if (!lane->scheduled) {
+            lane->scheduled = true;
+            needsScheduling = true;
+        }
+    }
+    queueDepth.fetch_add(1);
+
+    if (needsScheduling) {
+        schedule(targetWorker(*lane), lane);
+    }
+    leave();
+}
+
+void DeliveryExecutor::pin(uint64_t key, int workerIndex) {
+    if (!enter()) {
+        return;
+    }
+    {
+        // Under lanesMutex so releaseLane() never drops a lane being pinned
+        std::lock_guard<std::mutex> lock(lanesMutex);
+        getLane(key)->pinnedWorker.store(workerIndex < numWorkers ? workerIndex : workerIndex % numWorkers,
+                                         std::memory_order_relaxed);
+    }
+    leave();
+}
+
+std::shared_ptr<DeliveryExecutor::Lane> DeliveryExecutor::takeLane(int workerIndex) {
+    std::shared_ptr<Lane> lane;
+    Worker* own = workers[workerIndex];
+
+    // Own queue first, oldest lane first
+    {
+        std::lock_guard<std::mutex> lock(own->mutex);
+        if (!own->ready.empty()) {
+            lane = std::move(own->ready.front().lane);
+            if (own->ready.front().pinned) {
+                own->pinnedLanes.fetch_sub(1);
+            } else {
+                stealableLanes.fetch_sub(1);
+            }
+            own->ready.pop_front();
+        }
+    }
+
+    // Otherwise steal from the back of another worker's queue, skipping
+    // lanes pinned to their worker
+    for (int i = 1; !lane && i < numWorkers; i++) {
+        Worker* victim = workers[(workerIndex + i) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        for (auto it = victim->ready.rbegin(); it != victim->ready.rend(); ++it) {
+            if (!it->pinned) {
+                lane = std::move(it->lane);
+                victim->ready.erase(std::next(it).base());
+                stealableLanes.fetch_sub(1);
+                own->lanesStolen.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    return lane;
+}
+
+void DeliveryExecutor::runLane(int workerIndex, const std::shared_ptr<Lane>& lane) {
+    Worker* worker = workers[workerIndex];
+    for (int processed = 0; ; processed++) {
+        PendingTask task;
+        {
+            std::unique_lock<std::mutex> lock(lane->mutex);
+            if (lane->tasks.empty()) {
+                lane->scheduled = false;
+                lock.unlock();
+                releaseLane(lane);
+                return;
+            }
+            if (processed == LANE_BATCH || !running) {
+                break;  // Still scheduled, requeue below
+            }
+            task = std::move(lane->tasks.front());
+            lane->tasks.pop_front();
+        }
+        queueDepth.fetch_sub(1);
+        // Sequentially consistent with waitForQueueBelow(): either it sees
+        // the new depth or we see it waiting
+        if (depthWaiters.load() > 0) {
+            {
+                std::lock_guard<std::mutex> lock(depthMutex);
+            }
+            depthDropped.notify_all();
+        }
+
+        uint64_t lagNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - task.queued).count();
+        worker->lastLagNs.store(lagNs, std::memory_order_relaxed);
+        if (lagNs > worker->maxLagNs.load(std::memory_order_relaxed)) {
+            worker->maxLagNs.store(lagNs, std::memory_order_relaxed);
+        }
+        task.task();
+        worker->tasksRun.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    schedule(targetWorker(*lane), lane);
+}
+
+void DeliveryExecutor::releaseLane(const std::shared_ptr<Lane>& lane) {
+    // Drop a drained lane so `lanes` does not grow with every key ever
+    // submitted. References: the map and the worker that just ran it. Any
+    // other holder (submit(), pin(), a ready queue) got its copy under
+    // lanesMutex or while the lane was scheduled, so the count is exact here.
+    if (lane.use_count() != 2) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(lanesMutex);
+    if (lane.use_count() != 2 || lane->pinnedWorker.load(std::memory_order_relaxed) >= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> laneLock(lane->mutex);
+        if (lane->scheduled || !lane->tasks.empty()) {
+            return;
+        }
+    }
+    lanes.erase(lane->key);
+}
+
+void DeliveryExecutor::waitForWork(int workerIndex) {
+    Worker* worker = workers[workerIndex];
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    worker->sleeping = true;
+    sleepingWorkers.fetch_add(1);
+
+    // Lanes pinned to other workers do not count: they would only wake us
+    // to find nothing to take
+    worker->wake.wait(lock, [this, worker] {
+        return !worker->sleeping || stealableLanes.load() > 0 || worker->pinnedLanes.load() > 0 || !running;
+    });
+    if (worker->sleeping) {
+        worker->sleeping = false;
+        sleepingWorkers.fetch_sub(1);
+    }
+}
+
+void DeliveryExecutor::workerLoop(int workerIndex) {
+    while (running) {
+        std::shared_ptr<Lane> lane = takeLane(workerIndex);
+
+        if (!lane) {
+            waitForWork(workerIndex);
+            continue;
+        }
+
+        activeWorkers.fetch_add(1);
+        runLane(workerIndex, lane);
+        activeWorkers.fetch_sub(1);
+    }
+}
+
+int DeliveryExecutor::getQueueDepth() const {
+    return queueDepth.load();
+}
+
+bool DeliveryExecutor::waitForQueueBelow(int limit) {
+    if (queueDepth.load() < limit) {
+        return true;
+    }
+    if (!enter()) {
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> lock(depthMutex);
+        depthWaiters.fetch_add(1);
+        depthDropped.wait(lock, [this, limit] {
+            return queueDepth.load() < limit || !running.load();
+        });
+        depthWaiters.fetch_sub(1);
+    }
+    bool stillRunning = running.load();
+    leave();
+    return stillRunning;
+}
+
+int DeliveryExecutor::getActiveWorkers() const {
+    return activeWorkers.load();
+}
+
+int DeliveryExecutor::getWorkerCount() const {
+    return numWorkers;
+}
+
+void DeliveryExecutor::getWorkerStats(std::vector<WorkerStats>& out) {
+    out.clear();
+    if (!enter()) {
+        return;
+    }
+    for (Worker* worker : workers) {
+        WorkerStats stats;
+        stats.tasksRun = worker->tasksRun.load(std::memory_order_relaxed);
+        stats.lanesStolen = worker->lanesStolen.load(std::memory_order_relaxed);
+        stats.lastLagUs = worker->lastLagNs.load(std::memory_order_relaxed) / 1000;
+        stats.maxLagUs = worker->maxLagNs.exchange(0, std::memory_order_relaxed) / 1000;
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            stats.readyLanes = (int)worker->ready.size();
+        }
+        out.push_back(stats);
+    }
+    leave();
+}
@@ -0,0 +1,162 @@
+#ifndef DELIVERY_EXECUTOR_H
+#define DELIVERY_EXECUTOR_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+// Fixed-size thread pool for message delivery.
+//
+// Tasks are submitted with a key (the subscriber port). Tasks with the same
+// key run one at a time in submission order, so per-subscriber ordering is
+// preserved, while different keys run in parallel. Each key owns a "lane";
+// a lane with pending tasks is queued on its home worker and idle workers
+// steal whole lanes from the back of other workers' queues. A lane that
+// still has work after a batch goes back to its home worker, so a stolen
+// slow lane does not settle on the thief. A key can be pinned to a worker;
+// its lane then only ever runs there and is never stolen. Idle workers
+// sleep until a lane they may run becomes ready, and a key's lane is
+// dropped once it drains (pinned lanes are kept).
+class DeliveryExecutor {
+public:
+    using Task = std::function<void()>;
+
+    // Per-worker counters (see getWorkerStats)
+    struct WorkerStats {
+        uint64_t tasksRun = 0;
+        uint64_t lanesStolen = 0;      // Lanes taken from another worker's queue
+        int readyLanes = 0;            // Lanes waiting in this worker's queue
+        uint64_t lastLagUs = 0;        // Queue wait of the last task it started
+        uint64_t maxLagUs = 0;         // Longest queue wait since the previous getWorkerStats()
+    };
+
+private:
+    struct PendingTask {
+        Task task;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    // Tasks for one key. At most one worker drains a lane at a time.
+    struct Lane {
+        std::mutex mutex;
+        std::deque<PendingTask> tasks;
+        bool scheduled;                // Lane is sitting in a ready queue or being run
+        uint64_t key;
+        int homeWorker;                // key % workers
+        std::atomic<int> pinnedWorker; // -1 = home worker by key, may be stolen
+
+        Lane(uint64_t k, int home) : scheduled(false), key(k), homeWorker(home), pinnedWorker(-1) {}
+    };
+
+    // A queued lane; pinned is fixed when it is queued so the ready counts
+    // below stay balanced if the lane is pinned meanwhile
+    struct ReadyLane {
+        std::shared_ptr<Lane> lane;
+        bool pinned;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<ReadyLane> ready;   // Lanes with pending work
+        std::thread thread;
+
+        std::atomic<int> pinnedLanes{0};   // Pinned lanes in `ready`; only this worker runs them
+        std::condition_variable wake;
+        bool sleeping = false;             // Guarded by sleepMutex; cleared by whoever wakes it
+
+        std::atomic<uint64_t> tasksRun{0};
+        std::atomic<uint64_t> lanesStolen{0};
+        std::atomic<uint64_t> lastLagNs{0};
+        std::atomic<uint64_t> maxLagNs{0};
+    };
+
+    // Max tasks run from one lane before it is requeued (fairness between lanes)
+    static const int LANE_BATCH = 32;
+
+    int numWorkers;
+    std::vector<Worker*> workers;
+    std::atomic<bool> running;
+    std::atomic<int> callers;          // submit()/pin()/getWorkerStats() calls using `workers`
+
+    std::mutex lanesMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Lane>> lanes;
+
+    // Sleeping workers wait on their own condition variable until a lane
+    // they may run becomes ready: any stealable lane, or one pinned to them
+    std::mutex sleepMutex;
+    std::atomic<int> stealableLanes;   // Unpinned lanes across all ready queues
+    std::atomic<int> sleepingWorkers;
+
+    std::atomic<int> queueDepth;       // Submitted tasks not yet started
+    std::atomic<int> activeWorkers;    // Workers currently running a lane
+
+    // waitForQueueBelow() callers wait here; workers signal as tasks start
+    std::mutex depthMutex;
+    std::condition_variable depthDropped;
+    std::atomic<int> depthWaiters;
+
+    // Registers a call that uses `workers`. False once stop() has begun;
+    // stop() waits for registered calls before deleting the workers.
+    bool enter();
+    void leave();
+
+    std::shared_ptr<Lane>& getLane(uint64_t key);   // Caller holds lanesMutex
+    static int targetWorker(const Lane& lane);
+    void schedule(int workerIndex, const std::shared_ptr<Lane>& lane);
+    void wakeWorker(int workerIndex, bool pinned);
+    std::shared_ptr<Lane> takeLane(int workerIndex);
+    void runLane(int workerIndex, const std::shared_ptr<Lane>& lane);
+    void releaseLane(const std::shared_ptr<Lane>& lane);
+    void waitForWork(int workerIndex);
+    void workerLoop(int workerIndex);
+
+public:
+    // numThreads <= 0 sizes the pool from std::thread::hardware_concurrency()
+    explicit DeliveryExecutor(int numThreads = 0);
+
+    ~DeliveryExecutor();
+
+    DeliveryExecutor(const DeliveryExecutor&) = delete;
+    DeliveryExecutor& operator=(const DeliveryExecutor&) = delete;
+
+    // Start worker threads
+    void start();
+
+    // Stop workers; tasks that have not started yet are discarded
+    void stop();
+
+    // Queue a task. Tasks with the same key run sequentially in submit order.
+    // Any thread; ignored once stop() has begun.
+    void submit(uint64_t key, Task task);
+
+    // Run key's tasks only on worker workerIndex (after start(); a lane
+    // already queued may still be taken by another worker once). workerIndex < 0
+    // unpins the key.
+    void pin(uint64_t key, int workerIndex);
+
+    // Number of tasks waiting to run
+    int getQueueDepth() const;
+
+    // Block until fewer than `limit` tasks are waiting to run (bounds a
+    // producer without polling). False if stop() has begun.
+    bool waitForQueueBelow(int limit);
+
+    // Number of workers currently running tasks
+    int getActiveWorkers() const;
+
+    // Size of the pool
+    int getWorkerCount() const;
+
+    // One entry per worker; also restarts each worker's maxLagUs window
+    void getWorkerStats(std::vector<WorkerStats>& out);
+};
+
+#endif // DELIVERY_EXECUTOR_H
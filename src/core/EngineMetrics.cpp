@@ -0,0 +1,368 @@
+#include "EngineMetrics.h"
+#include "../MessageView.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+
+const uint8_t EngineMetrics::CMD_STATS;
+const uint8_t EngineMetrics::SNAPSHOT_VERSION;
+const int EngineMetrics::DEFAULT_MAX_TOPICS;
+const int EngineMetrics::SUB_BUCKET_BITS;
+const int EngineMetrics::LATENCY_BUCKETS;
+const size_t EngineMetrics::MAX_SLOTS;
+
+namespace {
+
+std::atomic<uint64_t> nextInstanceId(1);
+
+// Last slot this thread used, tagged with the metrics instance it belongs to
+struct CachedSlot {
+    uint64_t instance;
+    void* slot;
+};
+thread_local CachedSlot cachedSlot = { 0, nullptr };
+
+void appendLE16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back((v >> 8) & 0xFF);
+}
+
+void appendLE32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t bytes[4];
+    storeLE32(bytes, v);
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+void appendLE64(std::vector<uint8_t>& out, uint64_t v) {
+    uint8_t bytes[8];
+    storeLE64(bytes, v);
+    out.insert(out.end(), bytes, bytes + 8);
+}
+
+// Bounds-checked reader over a reply frame
+struct Reader {
+    const uint8_t* p;
+    size_t left;
+
+    bool u8(uint8_t& v) {
+        if (left < 1) return false;
+        v = *p++;
+        left--;
+        return true;
+    }
+    bool u16(uint16_t& v) {
+        if (left < 2) return false;
+        v = (uint16_t)(p[0] | (p[1] << 8));
+        p += 2;
+        left -= 2;
+        return true;
+    }
+    bool u32(uint32_t& v) {
+        if (left < 4) return false;
+        v = loadLE32(p);
+        p += 4;
+        left -= 4;
+        return true;
+    }
+    bool u64(uint64_t& v) {
+        if (left < 8) return false;
+        v = loadLE64(p);
+        p += 8;
+        left -= 8;
+        return true;
+    }
+    bool bytes(std::string& s, size_t n) {
+        if (left < n) return false;
+        s.assign((const char*)p, n);
+        p += n;
+        left -= n;
+        return true;
+    }
+};
+
+}
+
+EngineMetrics::Slot::Slot() : latencySum(0), latencyMax(0), owner(std::this_thread::get_id()) {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        latency[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+EngineMetrics::EngineMetrics()
+    : instanceId(nextInstanceId.fetch_add(1)), started(std::chrono::steady_clock::now()) {
+}
+
+EngineMetrics::~EngineMetrics() {
+    for (size_t i = 0; i < slots.size(); i++) {
+        delete *slots.find(i);
+    }
+}
+
+EngineMetrics::Slot* EngineMetrics::localSlot() {
+    if (cachedSlot.instance == instanceId) {
+        return static_cast<Slot*>(cachedSlot.slot);
+    }
+    Slot* slot = registerSlot();
+    cachedSlot.instance = instanceId;
+    cachedSlot.slot = slot;
+    return slot;
+}
+
+EngineMetrics::Slot* EngineMetrics::registerSlot() {
+    std::lock_guard<std::mutex> lock(slotsMutex);
+
+    // The thread may already own a slot if it last recorded for another engine
+    std::thread::id self = std::this_thread::get_id();
+    for (size_t i = 0; i < slots.size(); i++) {
+        Slot* slot = *slots.find(i);
+        if (slot->owner == self) {
+            return slot;
+        }
+    }
+
+    if (slots.size() >= MAX_SLOTS) {
+        // Out of slots: share the last one (counts become approximate)
+        return *slots.find(MAX_SLOTS - 1);
+    }
+    Slot* slot = new Slot();
+    slots.push(slot);
+    return slot;
+}
+
+size_t EngineMetrics::bucketOf(uint64_t ns) {
+    if (ns < 16) {
+        return (size_t)ns;
+    }
+    ns = std::min<uint64_t>(ns, (1ull << 40) - 1);
+    int highest = 63 - __builtin_clzll(ns);
+    int shift = highest - SUB_BUCKET_BITS;
+    return 16 + (size_t)(highest - 4) * 8 + (size_t)((ns >> shift) - 8);
+}
+
+uint64_t EngineMetrics::bucketUpperBound(size_t bucket) {
+    if (bucket < 16) {
+        return bucket;
+    }
+    int highest = (int)((bucket - 16) / 8) + 4;
+    uint64_t sub = (bucket - 16) % 8;
+    return ((8 + sub + 1) << (highest - SUB_BUCKET_BITS)) - 1;
+}
+
+void EngineMetrics::recordLatency(uint64_t ns) {
+    Slot* slot = localSlot();
+    std::atomic<uint64_t>& bucket = slot->latency[bucketOf(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slot->latencySum.store(slot->latencySum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > slot->latencyMax.load(std::memory_order_relaxed)) {
+        slot->latencyMax.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void EngineMetrics::collect(std::vector<uint64_t>& counters, LatencySummary& latency) const {
+    counters.assign(COUNTER_COUNT, 0);
+    std::vector<uint64_t> buckets(LATENCY_BUCKETS, 0);
+    uint64_t sum = 0;
+    latency = LatencySummary();
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        const Slot* slot = *slots.find(i);
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            counters[c] += slot->counters[c].load(std::memory_order_relaxed);
+        }
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            buckets[b] += slot->latency[b].load(std::memory_order_relaxed);
+        }
+        sum += slot->latencySum.load(std::memory_order_relaxed);
+        latency.max = std::max(latency.max, slot->latencyMax.load(std::memory_order_relaxed));
+    }
+
+    for (uint64_t n : buckets) {
+        latency.count += n;
+    }
+    if (latency.count == 0) {
+        return;
+    }
+    latency.mean = sum / latency.count;
+
+    const double percents[] = { 50, 90, 99, 99.9 };
+    uint64_t* targets[] = { &latency.p50, &latency.p90, &latency.p99, &latency.p999 };
+    uint64_t seen = 0;
+    int next = 0;
+    for (int b = 0; b < LATENCY_BUCKETS && next < 4; b++) {
+        seen += buckets[b];
+        while (next < 4 && seen >= std::max<uint64_t>(1, (uint64_t)(percents[next] / 100.0 * latency.count + 0.5))) {
+            *targets[next++] = std::min(bucketUpperBound(b), latency.max);
+        }
+    }
+}
+
+uint64_t EngineMetrics::getUptimeMs() const {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+}
+
+int EngineMetrics::parseRequest(const std::vector<uint8_t>& frame) {
+    if (frame.size() >= 3) {
+        return frame[1] | (frame[2] << 8);
+    }
+    return DEFAULT_MAX_TOPICS;
+}
+
+std::vector<uint8_t> EngineMetrics::makeRequest(int maxTopics) {
+    std::vector<uint8_t> frame;
+    frame.push_back(CMD_STATS);
+    appendLE16(frame, (uint16_t)std::min(std::max(maxTopics, 0), 0xFFFF));
+    return frame;
+}
+
+std::vector<uint8_t> EngineMetrics::encodeSnapshot(const Snapshot& snapshot, int maxTopics, size_t maxBytes) {
+    std::vector<uint8_t> out;
+    out.push_back(CMD_STATS);
+    out.push_back(SNAPSHOT_VERSION);
+    appendLE64(out, snapshot.uptimeMs);
+
+    out.push_back((uint8_t)snapshot.counters.size());
+    for (uint64_t v : snapshot.counters) {
+        appendLE64(out, v);
+    }
+    out.push_back((uint8_t)snapshot.gauges.size());
+    for (uint64_t v : snapshot.gauges) {
+        appendLE64(out, v);
+    }
+
+    const LatencySummary& l = snapshot.fanOutLatency;
+    for (uint64_t v : { l.count, l.mean, l.p50, l.p90, l.p99, l.p999, l.max }) {
+        appendLE64(out, v);
+    }
+
+    appendLE16(out, (uint16_t)std::min<size_t>(snapshot.shards.size(), 0xFFFF));
+    for (size_t i = 0; i < snapshot.shards.size() && i < 0xFFFF; i++) {
+        appendLE32(out, snapshot.shards[i].queueDepth);
+        appendLE64(out, snapshot.shards[i].processed);
+    }
+
+    // Busiest topics first, as many as asked for and as fit
+    std::vector<const TopicStats*> order;
+    for (const TopicStats& t : snapshot.topics) {
+        order.push_back(&t);
+    }
+    size_t keep = std::min(order.size(), (size_t)std::max(maxTopics, 0));
+    std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                      [](const TopicStats* a, const TopicStats* b) { return a->messagesIn > b->messagesIn; });
+
+    size_t countPos = out.size();
+    appendLE16(out, 0);
+    uint16_t written = 0;
+    for (size_t i = 0; i < keep && written < 0xFFFF; i++) {
+        const TopicStats& t = *order[i];
+        size_t len = std::min<size_t>(t.topic.size(), 255);
+        if (out.size() + 21 + len > maxBytes) {
+            break;
+        }
+        appendLE64(out, t.messagesIn);
+        appendLE64(out, t.messagesOut);
+        appendLE32(out, t.subscribers);
+        out.push_back((uint8_t)len);
+        out.insert(out.end(), t.topic.begin(), t.topic.begin() + len);
+        written++;
+    }
+    out[countPos] = written & 0xFF;
+    out[countPos + 1] = (written >> 8) & 0xFF;
+    return out;
+}
+
+bool EngineMetrics::decodeSnapshot(const std::vector<uint8_t>& frame, Snapshot& out) {
+    Reader r = { frame.data(), frame.size() };
+    uint8_t cmd, version, n;
+    if (!r.u8(cmd) || cmd != CMD_STATS || !r.u8(version) || version < 1 || !r.u64(out.uptimeMs)) {
+        return false;
+    }
+
+    if (!r.u8(n)) return false;
+    out.counters.assign(n, 0);
+    for (uint64_t& v : out.counters) {
+        if (!r.u64(v)) return false;
+    }
+    if (!r.u8(n)) return false;
+    out.gauges.assign(n, 0);
+    for (uint64_t& v : out.gauges) {
+        if (!r.u64(v)) return false;
+    }
+
+    LatencySummary& l = out.fanOutLatency;
+    for (uint64_t* v : { &l.count, &l.mean, &l.p50, &l.p90, &l.p99, &l.p999, &l.max }) {
+        if (!r.u64(*v)) return false;
+    }
+
+    uint16_t count;
+    if (!r.u16(count)) return false;
+    out.shards.assign(count, ShardStats());
+    for (ShardStats& s : out.shards) {
+        if (!r.u32(s.queueDepth) || !r.u64(s.processed)) return false;
+    }
+
+    if (!r.u16(count)) return false;
+    out.topics.assign(count, TopicStats());
+    for (TopicStats& t : out.topics) {
+        uint8_t len;
+        if (!r.u64(t.messagesIn) || !r.u64(t.messagesOut) || !r.u32(t.subscribers) ||
+            !r.u8(len) || !r.bytes(t.topic, len)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* EngineMetrics::counterName(int counter) {
+    static const char* names[] = {
+        "frames_in", "bytes_in", "messages_in", "messages_no_subscriber",
+        "deliveries", "delivery_failures", "bytes_out"
+    };
+    return counter >= 0 && counter < COUNTER_COUNT ? names[counter] : "unknown";
+}
+
+const char* EngineMetrics::gaugeName(int gauge) {
+    static const char* names[] = {
+        "topics", "subscriptions", "delivery_queue", "delivery_active",
+        "delivery_workers", "shard_queue", "registered_ids"
+    };
+    return gauge >= 0 && gauge < GAUGE_COUNT ? names[gauge] : "unknown";
+}
+
+void EngineMetrics::printSnapshot(const Snapshot& snapshot) {
+    std::cout << "=== Engine stats (uptime " << snapshot.uptimeMs / 1000.0 << " s) ===" << std::endl;
+    for (size_t i = 0; i < snapshot.counters.size(); i++) {
+        std::cout << "  " << std::left << std::setw(24) << counterName((int)i) << std::right
+                  << snapshot.counters[i] << std::endl;
+    }
+    for (size_t i = 0; i < snapshot.gauges.size(); i++) {
+        std::cout << "  " << std::left << std::setw(24) << gaugeName((int)i) << std::right
+                  << snapshot.gauges[i] << std::endl;
+    }
+
+    const LatencySummary& l = snapshot.fanOutLatency;
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    std::cout << std::fixed << std::setprecision(1)
+              << "  fan-out latency (us)    n=" << l.count << " mean " << us(l.mean)
+              << " p50 " << us(l.p50) << " p90 " << us(l.p90) << " p99 " << us(l.p99)
+              << " p99.9 " << us(l.p999) << " max " << us(l.max) << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    for (size_t i = 0; i < snapshot.shards.size(); i++) {
+        std::cout << "  shard " << i << ": queue " << snapshot.shards[i].queueDepth
+                  << ", processed " << snapshot.shards[i].processed << std::endl;
+    }
+    if (!snapshot.topics.empty()) {
+        std::cout << "  " << std::left << std::setw(40) << "topic" << std::right
+                  << std::setw(12) << "in" << std::setw(12) << "out" << std::setw(8) << "subs" << std::endl;
+        for (const TopicStats& t : snapshot.topics) {
+            std::cout << "  " << std::left << std::setw(40) << t.topic << std::right
+                      << std::setw(12) << t.messagesIn << std::setw(12) << t.messagesOut
+                      << std::setw(8) << t.subscribers << std::endl;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef ENGINE_METRICS_H
+#define ENGINE_METRICS_H
+
+#include "../DataStructures/StableVector.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Engine counters and the fan-out latency histogram, plus the STATS command.
+//
+// Every thread that records gets its own cache-line aligned slot on first
+// use. Only that thread writes the slot, so recording is a relaxed load and
+// store per value, with no locked instruction and no sharing between cores.
+// snapshot() sums all slots with relaxed loads; a reader may see one value
+// a moment before another, which is fine for monitoring.
+//
+// Latency buckets are log-linear: 8 linear steps per power of two, so a
+// reported percentile is within 12.5% of the true value, up to 2^40 ns.
+//
+// Wire format (little-endian like protocol version 2):
+//   STATS request: [8] [max_topics(2)]          (max_topics optional, default 100)
+//   reply:         [8] [version(1)] [uptime_ms(8)]
+//                  [counter_count(1)] { [value(8)] }*       (Counter order)
+//                  [gauge_count(1)] { [value(8)] }*         (Gauge order)
+//                  [latency: count(8) mean p50 p90 p99 p99.9 max (8 each, ns)]
+//                  [shard_count(2)] { [queue_depth(4)] [processed(8)] }*
+//                  [topic_count(2)] { [in(8)] [out(8)] [subscribers(4)] [topic_len(1)] [topic...] }*
+// Topics are the busiest ones by messages in. New counters and gauges are
+// appended, so older readers skip what they do not know by the counts.
+class EngineMetrics {
+public:
+    static const uint8_t CMD_STATS = 8;
+    static const uint8_t SNAPSHOT_VERSION = 1;
+    static const int DEFAULT_MAX_TOPICS = 100;
+
+    enum Counter {
+        FRAMES_IN,              // Frames received from publishers and subscribers
+        BYTES_IN,               // Payload bytes of those frames
+        MESSAGES_IN,            // Messages published (after batch / ID decoding)
+        MESSAGES_NO_SUBSCRIBER, // Published messages nobody was subscribed to
+        DELIVERIES,             // Messages sent to a subscriber
+        DELIVERY_FAILURES,      // Deliveries the subscriber's connection refused
+        BYTES_OUT,              // Bytes of successful deliveries
+        COUNTER_COUNT
+    };
+
+    enum Gauge {
+        TOPICS,                 // Topics known to the engine
+        SUBSCRIPTIONS,          // Exact topic subscriptions (wildcards not included)
+        DELIVERY_QUEUE,         // Deliveries queued but not started
+        DELIVERY_ACTIVE,        // Delivery workers sending right now
+        DELIVERY_WORKERS,       // Size of the delivery pool
+        SHARD_QUEUE,            // Frames queued to shard workers
+        REGISTERED_IDS,         // Topic IDs handed out by REGISTER_TOPIC
+        GAUGE_COUNT
+    };
+
+    struct ShardStats {
+        uint32_t queueDepth = 0;
+        uint64_t processed = 0;
+    };
+
+    struct TopicStats {
+        std::string topic;
+        uint64_t messagesIn = 0;
+        uint64_t messagesOut = 0;      // Deliveries dispatched (one per subscriber)
+        uint32_t subscribers = 0;
+    };
+
+    struct LatencySummary {
+        uint64_t count = 0;
+        uint64_t mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+        uint64_t max = 0;
+    };
+
+    // Decoded STATS reply
+    struct Snapshot {
+        uint64_t uptimeMs = 0;
+        std::vector<uint64_t> counters;
+        std::vector<uint64_t> gauges;
+        LatencySummary fanOutLatency;   // Publish accepted -> delivery written, ns
+        std::vector<ShardStats> shards;
+        std::vector<TopicStats> topics;
+    };
+
+    EngineMetrics();
+    ~EngineMetrics();
+
+    EngineMetrics(const EngineMetrics&) = delete;
+    EngineMetrics& operator=(const EngineMetrics&) = delete;
+
+    // Calling thread's counters (any thread)
+    void add(Counter counter, uint64_t value = 1) {
+        Slot* slot = localSlot();
+        uint64_t current = slot->counters[counter].load(std::memory_order_relaxed);
+        slot->counters[counter].store(current + value, std::memory_order_relaxed);
+    }
+
+    // Record one publish-to-delivery latency in nanoseconds (any thread)
+    void recordLatency(uint64_t ns);
+
+    // Counters and latency summed over all threads so far
+    void collect(std::vector<uint64_t>& counters, LatencySummary& latency) const;
+
+    // Milliseconds since construction
+    uint64_t getUptimeMs() const;
+
+    // Max topics a STATS request asks for
+    static int parseRequest(const std::vector<uint8_t>& frame);
+
+    static std::vector<uint8_t> makeRequest(int maxTopics = DEFAULT_MAX_TOPICS);
+
+    // Build a STATS reply. Keeps the maxTopics busiest topics and stops
+    // adding topics before the frame would exceed maxBytes.
+    static std::vector<uint8_t> encodeSnapshot(const Snapshot& snapshot, int maxTopics, size_t maxBytes);
+
+    // Parse a STATS reply; false if it is not one
+    static bool decodeSnapshot(const std::vector<uint8_t>& frame, Snapshot& out);
+
+    // Human-readable dump of a snapshot
+    static void printSnapshot(const Snapshot& snapshot);
+
+    static const char* counterName(int counter);
+    static const char* gaugeName(int gauge);
+
+private:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int LATENCY_BUCKETS = 16 + 36 * 8;    // Up to 2^40 ns
+    static const size_t MAX_SLOTS = 4096;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+        std::atomic<uint64_t> latency[LATENCY_BUCKETS];
+        std::atomic<uint64_t> latencySum;
+        std::atomic<uint64_t> latencyMax;
+        std::thread::id owner;
+
+        Slot();
+    };
+
+    uint64_t instanceId;                    // Tells engines apart in the thread-local cache
+    std::chrono::steady_clock::time_point started;
+    std::mutex slotsMutex;                  // Serializes slot registration only
+    StableVector<Slot*, 64, MAX_SLOTS / 64> slots;
+
+    Slot* localSlot();
+    Slot* registerSlot();
+
+    static size_t bucketOf(uint64_t ns);
+    static uint64_t bucketUpperBound(size_t bucket);
+};
+
+#endif // ENGINE_METRICS_H
@@ -0,0 +1,619 @@
+#include "EngineShard.h"
+#include "../Serialization.h"
+#include "../Network.h"
+#include "PublishBatcher.h"
+#include "../utils/Logger.h"
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+static uint32_t readPort(const std::vector<uint8_t>& frame) {
+    return ((uint32_t)frame[1] << 24) |
+           ((uint32_t)frame[2] << 16) |
+           ((uint32_t)frame[3] << 8) |
+           (uint32_t)frame[4];
+}
+
+const uint8_t EngineShard::CMD_UNSUBSCRIBE_PORT;
+const uint8_t EngineShard::CMD_REMOVE_PORT;
+const uint8_t EngineShard::CMD_SET_RETENTION;
+const uint8_t EngineShard::CMD_REPLAY_TO;
+const uint8_t EngineShard::CMD_OPEN_TOPIC;
+
+EngineShard::EngineShard(int shardIndex, int numProducers, int retention, MessageLog* log,
+                         const TopicRegistry* topicRegistry, EngineMetrics* engineMetrics, DeliverFn deliverFn, ReplyFn replyFn,
+                         ResumeFn resumeFn)
+    : index(shardIndex), deliver(std::move(deliverFn)), reply(std::move(replyFn)), resume(std::move(resumeFn)),
+      defaultRetention(retention), messageLog(log), metrics(engineMetrics), registry(topicRegistry),
+      running(false), sleeping(false), processedFrames(0) {
+    for (int i = 0; i <= numProducers; i++) {
+        rings.push_back(new SpscRing<std::vector<uint8_t>>(RING_CAPACITY));
+    }
+    ringFull.reset(new std::atomic<bool>[rings.size()]);
+    for (size_t i = 0; i < rings.size(); i++) {
+        ringFull[i].store(false);
+    }
+}
+
+EngineShard::~EngineShard() {
+    stop();
+    topics.forEach([](const char*, TopicEntry*& entry) {
+        delete entry;
+    });
+    for (auto* ring : rings) {
+        delete ring;
+    }
+}
+
+void EngineShard::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread(&EngineShard::run, this);
+}
+
+void EngineShard::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    workAvailable.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+int EngineShard::shardOf(const char* topic, int numShards) {
+    return (int)(TopicTable<TopicEntry*>::hashKey(topic) % (uint64_t)numShards);
+}
+
+bool EngineShard::readTopic(const std::vector<uint8_t>& frame, char* topic, size_t size) {
+    if (frame.empty()) {
+        return false;
+    }
+
+    // PUBLISH: [0][serialized message], either protocol version
+    if (frame[0] == 0) {
+        MessageView view(frame.data() + 1, frame.size() - 1);
+        if (!view.isValid() || view.topic().size() >= size) {
+            return false;
+        }
+        memcpy(topic, view.topic().data(), view.topic().size());
+        topic[view.topic().size()] = '\0';
+        return true;
+    }
+
+    // Offset of the topic length byte for each command
+    size_t lenPos;
+    switch (frame[0]) {
+        case 1: lenPos = 5; break;                      // [1][port(4)][topic_len][topic...]
+        case 2: lenPos = 1; break;                      // [2][topic_len][topic...]
+        case 3: lenPos = 1; break;                      // [3][topic_len][topic...]
+        case 4: lenPos = 10; break;                     // [4][mode][from(8)][topic_len][topic...]
+        case CMD_UNSUBSCRIBE_PORT: lenPos = 5; break;
+        case CMD_SET_RETENTION: lenPos = 5; break;
+        case CMD_OPEN_TOPIC: lenPos = 5; break;
+        case CMD_REPLAY_TO: lenPos = 18; break;
+        default: return false;
+    }
+
+    if (frame.size() <= lenPos) {
+        return false;
+    }
+    size_t len = frame[lenPos];
+    if (len >= size || frame.size() < lenPos + 1 + len) {
+        return false;
+    }
+
+    memcpy(topic, &frame[lenPos + 1], len);
+    topic[len] = '\0';
+    return true;
+}
+
+std::vector<uint8_t> EngineShard::makeTopicCommand(uint8_t cmd, int value, const char* topic) {
+    size_t len = std::min(strlen(topic), (size_t)255);
+    std::vector<uint8_t> frame = {
+        cmd,
+        (uint8_t)((value >> 24) & 0xFF),
+        (uint8_t)((value >> 16) & 0xFF),
+        (uint8_t)((value >> 8) & 0xFF),
+        (uint8_t)(value & 0xFF),
+        (uint8_t)len
+    };
+    frame.insert(frame.end(), topic, topic + len);
+    return frame;
+}
+
+std::vector<uint8_t> EngineShard::makeReplayCommand(uint64_t connection, const std::vector<uint8_t>& request) {
+    std::vector<uint8_t> frame(9);
+    frame.reserve(request.size() + 8);
+    frame[0] = CMD_REPLAY_TO;
+    storeLE64(&frame[1], connection);
+    frame.insert(frame.end(), request.begin() + 1, request.end());
+    return frame;
+}
+
+void EngineShard::push(SpscRing<std::vector<uint8_t>>* ring, std::vector<uint8_t>&& frame) {
+    // Ring full: only callers that cannot stop reading instead get here
+    // (API threads, the queue-fed ingest thread); wait for the worker
+    while (!ring->push(std::move(frame))) {
+        if (!running) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    // Pairs with the fence in run(): either we see the worker asleep or it sees our frame
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        workAvailable.notify_one();
+    }
+}
+
+bool EngineShard::hasRoom(int producer) {
+    SpscRing<std::vector<uint8_t>>* ring = rings[producer];
+    if (ring->size() < ring->getCapacity()) {
+        return true;
+    }
+    // Pairs with the fence in releaseProducer(): either the worker sees the
+    // flag or we see the room it has made
+    ringFull[producer].store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return ring->size() < ring->getCapacity();
+}
+
+void EngineShard::releaseProducer(size_t ringIndex) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ringFull[ringIndex].load(std::memory_order_relaxed) ||
+        rings[ringIndex]->size() > rings[ringIndex]->getCapacity() / 2) {
+        return;
+    }
+    if (ringFull[ringIndex].exchange(false) && resume) {
+        resume();
+    }
+}
+
+void EngineShard::post(int producer, std::vector<uint8_t>&& frame) {
+    push(rings[producer], std::move(frame));
+}
+
+void EngineShard::postControl(std::vector<uint8_t>&& frame) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    push(rings.back(), std::move(frame));
+}
+
+bool EngineShard::hasPendingFrames() const {
+    for (const auto* ring : rings) {
+        if (!ring->isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EngineShard::drain() {
+    bool didWork = false;
+    std::vector<uint8_t> frame;
+
+    for (size_t r = 0; r < rings.size(); r++) {
+        int taken = 0;
+        for (; taken < DRAIN_BATCH && rings[r]->pop(frame); taken++) {
+            handleFrame(frame);
+            processedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (taken > 0) {
+            releaseProducer(r);
+            didWork = true;
+        }
+    }
+    return didWork;
+}
+
+void EngineShard::run() {
+    int idle = 0;
+
+    while (running) {
+        if (drain()) {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Nothing for a while: sleep until a producer posts
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        workAvailable.wait_for(lock, std::chrono::milliseconds(100), [this] {
+            return hasPendingFrames() || !running;
+        });
+        sleeping.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+void EngineShard::handleFrame(const std::vector<uint8_t>& frame) {
+    uint8_t cmd = frame[0];
+
+    if (cmd == 0) {
+        publish(frame.data(), frame.size());
+        return;
+    }
+
+    if (cmd == TopicRegistry::CMD_PUBLISH_ID) {
+        publishById(frame.data(), frame.size());
+        return;
+    }
+
+    if (cmd == PublishBatcher::CMD_PUBLISH_BATCH) {
+        // Routed batches only hold this shard's entries, already validated
+        PublishBatcher::forEachEntry(frame.data(), frame.size(), [this](const uint8_t* entry, size_t len) {
+            if (entry[0] == TopicRegistry::CMD_PUBLISH_ID) {
+                publishById(entry, len);
+            } else {
+                publish(entry, len);
+            }
+        });
+        return;
+    }
+
+    if (cmd == CMD_REMOVE_PORT) {
+        if (frame.size() >= 5) {
+            removePort(readPort(frame));
+        }
+        return;
+    }
+
+    char topic[Message::MAX_TOPIC_LEN + 1];
+    if (!readTopic(frame, topic, sizeof(topic))) {
+        return;
+    }
+
+    if (cmd == 1) {
+        subscribe(topic, readPort(frame));
+    } else if (cmd == 2) {
+        unsubscribe(topic, 0);   // The wire UNSUBSCRIBE carries no port
+    } else if (cmd == CMD_UNSUBSCRIBE_PORT) {
+        unsubscribe(topic, readPort(frame));
+    } else if (cmd == CMD_SET_RETENTION) {
+        setRetention(topic, readPort(frame));
+    } else if (cmd == CMD_REPLAY_TO) {
+        replay(frame, topic);
+    } else if (cmd == CMD_OPEN_TOPIC) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        getOrCreateTopic(topic);
+    }
+}
+
+EngineShard::TopicEntry* EngineShard::findTopic(const char* topic) const {
+    TopicEntry** entry = topics.find(topic);
+    return entry ? *entry : nullptr;
+}
+
+EngineShard::TopicEntry* EngineShard::getOrCreateTopic(const char* topic) {
+    TopicEntry* entry = findTopic(topic);
+    if (entry != nullptr) {
+        return entry;
+    }
+
+    auto retention = retentionByTopic.find(topic);
+    entry = new TopicEntry(retention != retentionByTopic.end() ? retention->second : defaultRetention);
+    strncpy(entry->topic, topic, 63);
+    entry->topic[63] = '\0';
+
+    // Continue the topic's numbering and last value from the log
+    if (messageLog != nullptr) {
+        Message last;
+        uint64_t lastSeq = messageLog->readLastMessage(topic, last);
+        if (lastSeq > 0) {
+            entry->history.setNextSeq(lastSeq + 1);
+            entry->lastValue.store(last);
+        }
+    }
+    topics.insert(topic, entry);
+
+    LOG_INFO("[PubSubEngine:SHARD ", index, "] Kreiran novi topic: ", topic);
+    return entry;
+}
+
+void EngineShard::publish(const uint8_t* frame, size_t len) {
+    Message msg = MessageView(frame + 1, len - 1).toMessage();
+
+    // Only this thread mutates the table, so reading it needs no lock
+    TopicEntry* entry = findTopic(msg.topic);
+    if (entry == nullptr) {
+        // First publish: keep an entry so the last value is cached
+        std::lock_guard<std::mutex> lock(stateMutex);
+        entry = getOrCreateTopic(msg.topic);
+    }
+
+    publishToEntry(entry, msg, frame + 1, len - 1);
+}
+
+void EngineShard::publishById(const uint8_t* frame, size_t len) {
+    uint32_t id = TopicRegistry::readId(frame, len);
+    const TopicRegistry::Registration* reg = registry->find(id);
+    if (reg == nullptr) {
+        return;
+    }
+
+    // Array index instead of a topic lookup; the first frame for an ID resolves it
+    if (id >= entriesById.size()) {
+        entriesById.resize(id + 1, nullptr);
+    }
+    TopicEntry*& entry = entriesById[id];
+    if (entry == nullptr) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        entry = getOrCreateTopic(reg->header.topic);
+    }
+
+    // Log and subscribers get the complete message
+    Message msg;
+    TopicRegistry::decodePublish(frame, *reg, msg);
+    encodeBuffer.resize(Serialization::encodedSize(msg));
+    Serialization::encode(msg, encodeBuffer.data(), encodeBuffer.size());
+    publishToEntry(entry, msg, encodeBuffer.data(), encodeBuffer.size());
+}
+
+void EngineShard::publishToEntry(TopicEntry* entry, const Message& msg, const uint8_t* serialized, size_t len) {
+    uint64_t seq = entry->history.append(msg);
+    entry->lastValue.store(msg);
+    if (messageLog != nullptr && !messageLog->append(msg.topic, seq, serialized, len)) {
+        LOG_ERROR("[PubSubEngine:SHARD ", index, "] Upis u log nije uspeo za topic: ", msg.topic);
+    }
+
+    SubscriberSnapshot subscribers;
+    for (auto it = entry->subscribers.begin(); it != entry->subscribers.end(); ++it) {
+        subscribers.push_back(*it);
+    }
+
+    size_t exactCount = subscribers.size();
+    wildcardSubscriptions.match(msg.topic, subscribers);
+    if (subscribers.size() > exactCount) {
+        SubscriberSnapshot unique;
+        for (const auto& addr : subscribers) {
+            if (std::find(unique.begin(), unique.end(), addr) == unique.end()) {
+                unique.push_back(addr);
+            }
+        }
+        subscribers.swap(unique);
+    }
+
+    metrics->add(EngineMetrics::MESSAGES_IN);
+    entry->messagesIn.store(entry->messagesIn.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    entry->messagesOut.store(entry->messagesOut.load(std::memory_order_relaxed) + subscribers.size(),
+                             std::memory_order_relaxed);
+    if (subscribers.empty()) {
+        metrics->add(EngineMetrics::MESSAGES_NO_SUBSCRIBER);
+        LOG_DEBUG("[PubSubEngine] Nema pretplatnika za topic: ", msg.topic);
+        return;
+    }
+
+    LOG_DEBUG("[PubSubEngine:SHARD ", index, "] Message published to topic '", msg.topic,
+              "', delivering to ", subscribers.size(), " subscriber(s)");
+
+    // Forward the serialized message as is
+    deliver(subscribers, msg, std::vector<uint8_t>(serialized, serialized + len));
+}
+
+void EngineShard::sendLastValue(TopicEntry* entry, const SubscriberAddress& addr) {
+    Message last;
+    if (!entry->lastValue.load(last)) {
+        return;
+    }
+
+    LOG_INFO("[PubSubEngine:SHARD ", index, "] Slanje poslednje vrednosti za '", entry->topic,
+             "' subscriber-u na portu ", addr.port);
+    deliver(SubscriberSnapshot(1, addr), last, Serialization::encode(last));
+}
+
+void EngineShard::setRetention(const char* topic, int depth) {
+    retentionByTopic[topic] = depth;
+
+    TopicEntry* entry = findTopic(topic);
+    if (entry != nullptr) {
+        entry->history.setDepth(depth);
+    }
+}
+
+void EngineShard::replay(const std::vector<uint8_t>& frame, const char* topic) {
+    // [cmd][connection(8)][mode(1)][from(8)][topic_len][topic...]
+    // Both little-endian: the tail is the client's REPLAY request as is
+    uint64_t connection = loadLE64(&frame[1]);
+    uint64_t from = loadLE64(&frame[10]);
+    uint8_t mode = frame[9];
+
+    std::vector<std::vector<uint8_t>> replies;
+    size_t count;
+    if (messageLog != nullptr) {
+        ReplayEncoder encoder(MAX_FRAME_LENGTH);
+        messageLog->scan(topic, mode, from, [&encoder](uint64_t seq, const uint8_t* message, size_t len) {
+            encoder.add(seq, message, len);
+        });
+        count = encoder.getCount();
+        replies = encoder.finish();
+    } else {
+        std::vector<RetainedMessage> retained;
+        TopicEntry* entry = findTopic(topic);
+        if (entry != nullptr) {
+            entry->history.collect(mode, from, retained);
+        }
+        count = retained.size();
+        replies = TopicHistory::encodeReplay(retained, MAX_FRAME_LENGTH);
+    }
+    LOG_INFO("[PubSubEngine:SHARD ", index, "] Replay '", topic, "': ", count,
+             " poruka u ", replies.size(), " frame-ova");
+    reply(connection, topic, std::move(replies));
+}
+
+void EngineShard::subscribe(const char* topic, int port) {
+    SubscriberAddress addr(port);
+    std::lock_guard<std::mutex> lock(stateMutex);
+
+    if (TopicPattern::hasWildcards(topic)) {
+        if (!TopicPattern::isValid(topic)) {
+            if (index == 0) {
+                LOG_WARN("[PubSubEngine] Neispravan wildcard topic: ", topic);
+            }
+            return;
+        }
+        // Every shard gets the pattern; only the first one reports it
+        if (wildcardSubscriptions.insert(topic, addr) && index == 0) {
+            LOG_INFO("[PubSubEngine] Subscriber on port ", port,
+                     " subscribed to pattern: ", topic);
+        }
+
+        // Warm start: last value of every topic in this shard the pattern covers
+        topics.forEach([this, topic, &addr](const char*, TopicEntry*& entry) {
+            if (TopicPattern::matches(topic, entry->topic)) {
+                sendLastValue(entry, addr);
+            }
+        });
+        return;
+    }
+
+    TopicEntry* entry = getOrCreateTopic(topic);
+    if (!entry->subscribers.contains(addr)) {
+        entry->subscribers.pushBack(addr);
+        LOG_INFO("[PubSubEngine:SHARD ", index, "] Subscriber on port ", port,
+                 " subscribed to topic: ", topic);
+    } else {
+        LOG_INFO("[PubSubEngine:SHARD ", index, "] Subscriber on port ", port,
+                 " already subscribed to topic: ", topic);
+    }
+
+    // Warm start: the new subscriber gets the current value right away
+    sendLastValue(entry, addr);
+}
+
+void EngineShard::unsubscribe(const char* topic, int port) {
+    SubscriberAddress addr(port);
+    std::lock_guard<std::mutex> lock(stateMutex);
+
+    if (TopicPattern::hasWildcards(topic)) {
+        if (wildcardSubscriptions.remove(topic, addr) && index == 0) {
+            LOG_INFO("[PubSubEngine] Subscriber on port ", port,
+                     " unsubscribed from pattern: ", topic);
+        }
+        return;
+    }
+
+    TopicEntry* entry = findTopic(topic);
+    if (entry == nullptr) {
+        LOG_INFO("[PubSubEngine] Topic not found: ", topic);
+        return;
+    }
+
+    if (entry->subscribers.remove(addr)) {
+        LOG_INFO("[PubSubEngine:SHARD ", index, "] Subscriber on port ", port,
+                 " unsubscribed from topic: ", topic);
+    } else {
+        LOG_INFO("[PubSubEngine:SHARD ", index, "] Subscriber on port ", port,
+                 " was not subscribed to topic: ", topic);
+    }
+}
+
+void EngineShard::removePort(int port) {
+    SubscriberAddress dead(port);
+    std::lock_guard<std::mutex> lock(stateMutex);
+
+    topics.forEach([&](const char*, TopicEntry*& entry) {
+        if (entry->subscribers.remove(dead)) {
+            LOG_INFO("[PubSubEngine:VALIDATION] Removed unreachable subscriber on port ",
+                     port, " from topic '", entry->topic, "'");
+        }
+    });
+
+    std::vector<std::pair<std::string, SubscriberAddress>> patterns;
+    wildcardSubscriptions.getAll(patterns);
+    for (const auto& sub : patterns) {
+        if (sub.second == dead && wildcardSubscriptions.remove(sub.first.c_str(), dead) && index == 0) {
+            LOG_INFO("[PubSubEngine:VALIDATION] Removed unreachable subscriber on port ",
+                     port, " from pattern '", sub.first, "'");
+        }
+    }
+
+    // Idle time on this thread: keep a pending table resize moving
+    topics.advanceMigration(4096);
+}
+
+int EngineShard::getSubscriberCount(const char* topic) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    TopicEntry* entry = findTopic(topic);
+    return entry ? entry->subscribers.size() : 0;
+}
+
+void EngineShard::collectTopics(std::vector<std::string>& out) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    topics.forEach([&out](const char* topic, TopicEntry*&) {
+        out.emplace_back(topic);
+    });
+}
+
+void EngineShard::collectTopicStats(std::vector<EngineMetrics::TopicStats>& out) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    topics.forEach([&out](const char* topic, TopicEntry*& entry) {
+        EngineMetrics::TopicStats stats;
+        stats.topic = topic;
+        stats.messagesIn = entry->messagesIn.load(std::memory_order_relaxed);
+        stats.messagesOut = entry->messagesOut.load(std::memory_order_relaxed);
+        stats.subscribers = (uint32_t)entry->subscribers.size();
+        out.push_back(std::move(stats));
+    });
+}
+
+void EngineShard::collectLastValues(const char* topic, std::vector<Message>& out) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    Message last;
+
+    if (!TopicPattern::hasWildcards(topic)) {
+        TopicEntry* entry = findTopic(topic);
+        if (entry != nullptr && entry->lastValue.load(last)) {
+            out.push_back(last);
+        }
+        return;
+    }
+
+    topics.forEach([&](const char*, TopicEntry*& entry) {
+        if (TopicPattern::matches(topic, entry->topic) && entry->lastValue.load(last)) {
+            out.push_back(last);
+        }
+    });
+}
+
+void EngineShard::collectPorts(std::vector<int>& out) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    topics.forEach([&out](const char*, TopicEntry*& entry) {
+        for (auto it = entry->subscribers.begin(); it != entry->subscribers.end(); ++it) {
+            out.push_back(it->port);
+        }
+    });
+
+    std::vector<std::pair<std::string, SubscriberAddress>> patterns;
+    wildcardSubscriptions.getAll(patterns);
+    for (const auto& sub : patterns) {
+        out.push_back(sub.second.port);
+    }
+}
+
+int EngineShard::getQueueDepth() const {
+    size_t depth = 0;
+    for (const auto* ring : rings) {
+        depth += ring->size();
+    }
+    return (int)depth;
+}
+
+uint64_t EngineShard::getProcessedCount() const {
+    return processedFrames.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,187 @@
+#ifndef ENGINE_SHARD_H
+#define ENGINE_SHARD_H
+
+#include "../Message.h"
+#include "../DataStructures/LinkedList.h"
+#include "../DataStructures/CircularBuffer.h"
+#include "../DataStructures/TopicTrie.h"
+#include "../DataStructures/TopicTable.h"
+#include "../DataStructures/SpscRing.h"
+#include "../DataStructures/SeqLock.h"
+#include "SubscriberAddress.h"
+#include "TopicHistory.h"
+#include "MessageLog.h"
+#include "TopicRegistry.h"
+#include "EngineMetrics.h"
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+// One slice of the engine in sharded mode (--shards N).
+//
+// Topics are hashed to shards. A shard's worker thread is the only thread
+// that touches its topic table, retention buffers and subscriber lists, so
+// the publish path runs without any locks. Every ingest thread owns one
+// SPSC ring into every shard; frames for wildcard patterns are broadcast to
+// all shards, each of which keeps its own pattern trie.
+class EngineShard {
+public:
+    // Hands a routed publish to the delivery pool:
+    // (subscribers, message, serialized message)
+    using DeliverFn = std::function<void(const SubscriberSnapshot&, const Message&, std::vector<uint8_t>&&)>;
+
+    // Queues reply frames for an ingest connection: (connection, topic, frames)
+    using ReplyFn = std::function<void(uint64_t connection, const char* topic, std::vector<std::vector<uint8_t>>&&)>;
+
+    // Called on the worker once an ingest thread that found its ring full
+    // (see hasRoom) can post again
+    using ResumeFn = std::function<void()>;
+
+    // Shard-internal commands next to the wire protocol's 0/1/2
+    static const uint8_t CMD_UNSUBSCRIBE_PORT = 0xF0;  // [cmd][port(4)][topic_len(1)][topic...]
+    static const uint8_t CMD_REMOVE_PORT = 0xF1;       // [cmd][port(4)]
+    static const uint8_t CMD_SET_RETENTION = 0xF2;     // [cmd][depth(4)][topic_len(1)][topic...]
+    static const uint8_t CMD_REPLAY_TO = 0xF3;         // [cmd][connection(8, LE)][REPLAY request minus its cmd byte]
+    static const uint8_t CMD_OPEN_TOPIC = 0xF4;        // [cmd][0(4)][topic_len(1)][topic...]
+
+private:
+    struct TopicEntry {
+        char topic[64];
+        LinkedList<SubscriberAddress> subscribers;  // Store subscriber ports
+        TopicHistory history;                       // Retained messages with sequence numbers
+        SeqLock<Message> lastValue;                 // Written by the worker, read by queries
+        std::atomic<uint64_t> messagesIn;           // Messages published to the topic (worker writes)
+        std::atomic<uint64_t> messagesOut;          // Deliveries dispatched (worker writes)
+
+        explicit TopicEntry(int retention) : history(retention), messagesIn(0), messagesOut(0) {
+            topic[0] = '\0';
+        }
+    };
+
+    static const size_t RING_CAPACITY = 4096;
+    static const int DRAIN_BATCH = 64;        // Frames taken from one ring before moving on
+    static const int IDLE_SPINS = 200;        // Empty polls before the worker sleeps
+
+    int index;
+    DeliverFn deliver;
+    ReplyFn reply;
+    ResumeFn resume;
+
+    // Retention settings (worker thread only)
+    int defaultRetention;
+    std::unordered_map<std::string, int> retentionByTopic;
+
+    MessageLog* messageLog;     // Shared by all shards, nullptr when disabled
+    EngineMetrics* metrics;     // Engine-wide counters (the worker records into its own slot)
+
+    // PUBLISH_ID: registered IDs (engine-wide) and this shard's entry for
+    // each ID it has seen, filled on first use (worker thread only)
+    const TopicRegistry* registry;
+    std::vector<TopicEntry*> entriesById;
+    std::vector<uint8_t> encodeBuffer;     // PUBLISH_ID message re-encoded for delivery
+
+    // rings[0..producers-1] belong to ingest threads, the last one is shared
+    // by every other caller (API calls, validation) under controlMutex
+    std::vector<SpscRing<std::vector<uint8_t>>*> rings;
+    std::unique_ptr<std::atomic<bool>[]> ringFull;   // Per ring: its producer is waiting for room
+    std::mutex controlMutex;
+
+    TopicTable<TopicEntry*> topics;
+    TopicTrie<SubscriberAddress> wildcardSubscriptions;
+
+    // The worker mutates topics/subscribers only while holding stateMutex;
+    // other threads take it to read them. The worker's own reads go unlocked.
+    std::mutex stateMutex;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::atomic<bool> sleeping;
+    std::atomic<uint64_t> processedFrames;
+
+    // Worker thread
+    void run();
+    bool drain();
+    bool hasPendingFrames() const;
+    void releaseProducer(size_t ringIndex);
+    void handleFrame(const std::vector<uint8_t>& frame);
+
+    TopicEntry* findTopic(const char* topic) const;
+    TopicEntry* getOrCreateTopic(const char* topic);
+    void publish(const uint8_t* frame, size_t len);
+    void publishById(const uint8_t* frame, size_t len);
+    void publishToEntry(TopicEntry* entry, const Message& msg, const uint8_t* serialized, size_t len);
+    void subscribe(const char* topic, int port);
+    void unsubscribe(const char* topic, int port);
+    void removePort(int port);
+    void sendLastValue(TopicEntry* entry, const SubscriberAddress& addr);
+    void setRetention(const char* topic, int depth);
+    void replay(const std::vector<uint8_t>& frame, const char* topic);
+
+    void push(SpscRing<std::vector<uint8_t>>* ring, std::vector<uint8_t>&& frame);
+
+public:
+    EngineShard(int shardIndex, int numProducers, int retention, MessageLog* log,
+                const TopicRegistry* topicRegistry, EngineMetrics* engineMetrics, DeliverFn deliverFn, ReplyFn replyFn,
+                ResumeFn resumeFn);
+    ~EngineShard();
+
+    EngineShard(const EngineShard&) = delete;
+    EngineShard& operator=(const EngineShard&) = delete;
+
+    void start();
+
+    // Stop the worker; frames still queued are dropped
+    void stop();
+
+    // Whether ingest thread `producer` can post a frame without waiting.
+    // False marks it as waiting; resumeFn runs once the worker has drained
+    // its ring to half, so the caller can stop reading instead of blocking.
+    bool hasRoom(int producer);
+
+    // Queue a frame from ingest thread `producer` (each index used by one
+    // thread only). Waits for room unless hasRoom() said there is some.
+    void post(int producer, std::vector<uint8_t>&& frame);
+
+    // Queue a frame from any other thread
+    void postControl(std::vector<uint8_t>&& frame);
+
+    // Shard owning an exact topic
+    static int shardOf(const char* topic, int numShards);
+
+    // Topic a PUBLISH/SUBSCRIBE/UNSUBSCRIBE/QUERY_LAST frame refers to.
+    // Returns false for malformed frames, other commands or topics >= size.
+    static bool readTopic(const std::vector<uint8_t>& frame, char* topic, size_t size);
+
+    // [cmd][value(4)][topic_len(1)][topic...] (SUBSCRIBE layout, also used
+    // by CMD_UNSUBSCRIBE_PORT and CMD_SET_RETENTION)
+    static std::vector<uint8_t> makeTopicCommand(uint8_t cmd, int value, const char* topic);
+
+    // Wrap a wire REPLAY request with the connection to answer on
+    static std::vector<uint8_t> makeReplayCommand(uint64_t connection, const std::vector<uint8_t>& request);
+
+    // Thread-safe queries (take stateMutex)
+    int getSubscriberCount(const char* topic);
+    void collectTopics(std::vector<std::string>& out);
+    void collectPorts(std::vector<int>& out);
+    void collectTopicStats(std::vector<EngineMetrics::TopicStats>& out);
+
+    // Cached last values of a topic, or of every topic matching a pattern
+    void collectLastValues(const char* topic, std::vector<Message>& out);
+
+    // Frames queued across all rings
+    int getQueueDepth() const;
+
+    // Frames handled since start
+    uint64_t getProcessedCount() const;
+};
+
+#endif // ENGINE_SHARD_H
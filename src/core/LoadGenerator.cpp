@@ -0,0 +1,175 @@
+#include "LoadGenerator.h"
+#include "../DataStructures/SpscRing.h"
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <cmath>
+#include <cstring>
+
+using Clock = std::chrono::steady_clock;
+
+static const double PI = 3.14159265358979323846;
+
+LoadGenerator::LoadGenerator(const Options& options) : opts(options) {
+    opts.threads = std::max(opts.threads, 1);
+    opts.topics = std::max(opts.topics, 1);
+    opts.rate = std::max(opts.rate, 1.0);
+    opts.durationSec = std::max(opts.durationSec, 1);
+}
+
+void LoadGenerator::waitUntil(Clock::time_point deadline) {
+    // Sleeping overshoots by tens of microseconds, so the last stretch spins
+    const auto spinWindow = std::chrono::microseconds(200);
+    for (;;) {
+        auto now = Clock::now();
+        if (now >= deadline) {
+            return;
+        }
+        if (deadline - now > spinWindow) {
+            std::this_thread::sleep_for(deadline - now - spinWindow);
+        } else {
+            cpuRelax();
+        }
+    }
+}
+
+bool LoadGenerator::parseDistribution(const std::string& name, ValueDistribution& out) {
+    if (name == "constant") {
+        out = ValueDistribution::CONSTANT;
+    } else if (name == "uniform") {
+        out = ValueDistribution::UNIFORM;
+    } else if (name == "normal") {
+        out = ValueDistribution::NORMAL;
+    } else if (name == "sine") {
+        out = ValueDistribution::SINE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+LoadGenerator::Report LoadGenerator::run() {
+    std::vector<Report> reports(opts.threads);
+    std::vector<std::thread> threads;
+
+    // Connections and registrations are made before the clock starts
+    auto start = Clock::now() + std::chrono::milliseconds(500) + std::chrono::milliseconds(20 * opts.threads);
+    for (int i = 0; i < opts.threads; i++) {
+        threads.emplace_back(&LoadGenerator::runThread, this, i, start, std::ref(reports[i]));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    Report total;
+    for (const Report& r : reports) {
+        total.sent += r.sent;
+        total.failed += r.failed;
+        total.elapsedSec = std::max(total.elapsedSec, r.elapsedSec);
+        total.callLatency.merge(r.callLatency);
+        total.scheduleLatency.merge(r.scheduleLatency);
+    }
+    return total;
+}
+
+void LoadGenerator::runThread(int index, Clock::time_point start, Report& out) {
+    int port = opts.basePort > 0 ? opts.basePort + index : PortPool::getNextPublisherPort();
+    Publisher publisher(index + 1, opts.engineHost, opts.enginePort, port);
+    publisher.setVerbose(false);
+    if (opts.batchSize > 1) {
+        publisher.enableBatching(opts.batchSize, opts.lingerMs);
+    }
+    if (opts.asyncQueue > 0) {
+        publisher.enableAsync(opts.asyncQueue, opts.overflow);
+    }
+    if (!publisher.open()) {
+        return;
+    }
+
+    std::vector<uint32_t> ids(opts.topics);
+    std::vector<Message> templates(opts.topics);
+    for (int t = 0; t < opts.topics; t++) {
+        Message& msg = templates[t];
+        snprintf(msg.topic, sizeof(msg.topic), "Bench/%d", t);
+        strncpy(msg.publisher_host, "localhost", Message::MAX_HOST_LEN - 1);
+        msg.publisher_port = port;
+        msg.type = MessageType::ANALOG;
+        msg.topicType = TopicType::MER;
+        ids[t] = publisher.registerTopic(msg.topic);
+    }
+
+    std::mt19937 rng(1234 + index);
+    std::uniform_real_distribution<float> uniform(0.0f, 1000.0f);
+    std::normal_distribution<float> normal(220.0f, 10.0f);
+
+    // Threads are offset by a fraction of the interval so their sends interleave
+    std::chrono::duration<double> interval(opts.threads / opts.rate);
+    auto first = start + std::chrono::duration_cast<Clock::duration>(interval * ((double)index / opts.threads));
+    auto end = start + std::chrono::seconds(opts.durationSec);
+
+    for (uint64_t i = 0; !ConsoleHandler::shouldExit(); i++) {
+        auto scheduled = first + std::chrono::duration_cast<Clock::duration>(interval * (double)i);
+        if (scheduled >= end) {
+            break;
+        }
+        waitUntil(scheduled);
+
+        int t = (int)(i % (uint64_t)opts.topics);
+        Message& msg = templates[t];
+        msg.timestamp = std::time(nullptr);
+        switch (opts.values) {
+            case ValueDistribution::CONSTANT:
+                msg.data.analogValue = 220.0f;
+                break;
+            case ValueDistribution::UNIFORM:
+                msg.data.analogValue = uniform(rng);
+                break;
+            case ValueDistribution::NORMAL:
+                msg.data.analogValue = normal(rng);
+                break;
+            case ValueDistribution::SINE: {
+                double seconds = std::chrono::duration<double>(scheduled - start).count();
+                msg.data.analogValue = 220.0f + 20.0f * (float)std::sin(2.0 * PI * seconds / 10.0);
+                break;
+            }
+        }
+
+        auto before = Clock::now();
+        bool ok = publisher.publishAsync(ids[t], msg);
+        auto after = Clock::now();
+
+        out.callLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+        out.scheduleLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(after - scheduled).count());
+        if (ok) {
+            out.sent++;
+        } else {
+            out.failed++;
+        }
+    }
+
+    out.elapsedSec = std::chrono::duration<double>(Clock::now() - start).count();
+    publisher.stop();
+}
+
+static void printLatencyRow(const char* name, const HdrHistogram& h) {
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    std::cout << "  " << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << us(h.percentile(50)) << std::setw(10) << us(h.percentile(90))
+              << std::setw(10) << us(h.percentile(99)) << std::setw(10) << us(h.percentile(99.9))
+              << std::setw(12) << us(h.getMax()) << std::endl;
+}
+
+void LoadGenerator::printReport(const Options& options, const Report& report) {
+    double achieved = report.elapsedSec > 0 ? report.sent / report.elapsedSec : 0;
+    std::cout << "\n=== Publisher bench ===" << std::endl;
+    std::cout << "  threads " << options.threads << ", topics " << options.topics
+              << ", target " << std::fixed << std::setprecision(0) << options.rate << " msg/s, duration "
+              << options.durationSec << " s" << std::endl;
+    std::cout << "  sent " << report.sent << ", failed " << report.failed << ", achieved "
+              << std::setprecision(0) << achieved << " msg/s (" << std::setprecision(1)
+              << (100.0 * achieved / options.rate) << "% of target)" << std::endl;
+    std::cout << "  latency (us)              p50       p90       p99     p99.9         max" << std::endl;
+    printLatencyRow("publish call", report.callLatency);
+    printLatencyRow("from schedule", report.scheduleLatency);
+}
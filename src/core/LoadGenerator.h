@@ -0,0 +1,73 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include "Publisher.h"
+#include "../DataStructures/HdrHistogram.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+// Sustained-rate traffic source for sizing engines (--publisher --bench).
+//
+// Each thread owns a Publisher, registers the bench topics once and then
+// publishes on a fixed schedule: message i of a thread is due at
+// start + i / (rate / threads). Waiting sleeps until shortly before the
+// deadline and spins the rest, so pacing is not bound to the scheduler's
+// sleep granularity. Latency is recorded twice per message: the publish
+// call alone, and from the scheduled send time, which also counts time
+// spent behind schedule when the publisher cannot keep up (no coordinated
+// omission).
+class LoadGenerator {
+public:
+    // Shape of the published values
+    enum class ValueDistribution {
+        CONSTANT,   // 220.0
+        UNIFORM,    // [0, 1000)
+        NORMAL,     // mean 220, sd 10
+        SINE        // 220 +- 20, period 10 s
+    };
+
+    struct Options {
+        std::string engineHost = "localhost";
+        int enginePort = 5000;
+        int basePort = 0;                   // Publisher ports basePort, basePort + 1, ... (0 = from PortPool)
+        double rate = 10000;                // Messages per second over all threads
+        int topics = 100;                   // Bench/0 ... Bench/<topics - 1>
+        ValueDistribution values = ValueDistribution::UNIFORM;
+        int durationSec = 10;
+        int threads = 1;
+        int batchSize = 0;                  // Publisher batching (see Publisher::enableBatching)
+        int lingerMs = 5;
+        int asyncQueue = 0;                 // Publisher outbox (see Publisher::enableAsync)
+        OverflowPolicy overflow = OverflowPolicy::BLOCK;
+    };
+
+    struct Report {
+        uint64_t sent = 0;
+        uint64_t failed = 0;
+        double elapsedSec = 0;
+        HdrHistogram callLatency;           // ns inside publish()
+        HdrHistogram scheduleLatency;       // ns from the scheduled send time to publish() returning
+    };
+
+    explicit LoadGenerator(const Options& options);
+
+    // Run for the configured duration (or until exit is typed); blocks
+    Report run();
+
+    static void printReport(const Options& options, const Report& report);
+
+    // "constant", "uniform", "normal" or "sine"
+    static bool parseDistribution(const std::string& name, ValueDistribution& out);
+    
+    // Sleep until shortly before the deadline, then spin (open-loop pacing)
+    static void waitUntil(std::chrono::steady_clock::time_point deadline);
+
+private:
+    Options opts;
+
+    void runThread(int index, std::chrono::steady_clock::time_point start, Report& out);
+};
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,66 @@
+#include "LogCompactor.h"
+#include <algorithm>
+
+LogCompactor::LogCompactor(MessageLog& messageLog, uint64_t bytes_per_second, int check_interval_ms)
+    : log(messageLog), bytesPerSecond(std::max<uint64_t>(bytes_per_second, 1)),
+      checkInterval(check_interval_ms), tokens(0), running(false) {
+    // A quarter second worth of I/O may go out in one burst
+    burst = std::max(bytesPerSecond / 4.0, 64.0 * 1024);
+}
+
+LogCompactor::~LogCompactor() {
+    stop();
+}
+
+void LogCompactor::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    thread = std::thread(&LogCompactor::run, this);
+}
+
+void LogCompactor::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    waitCv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool LogCompactor::acquire(size_t bytes) {
+    // Large requests are paid off in burst-sized pieces so stop() stays responsive
+    double needed = (double)bytes;
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+        tokens = std::min(burst, tokens + elapsed * bytesPerSecond);
+        lastRefill = now;
+
+        double take = std::min(needed, tokens);
+        tokens -= take;
+        needed -= take;
+        if (needed <= 0) {
+            return true;
+        }
+
+        double waitSeconds = std::min(needed, burst) / bytesPerSecond;
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waitCv.wait_for(lock, std::chrono::duration<double>(waitSeconds), [this] { return !running; });
+    }
+    return false;
+}
+
+void LogCompactor::run() {
+    lastRefill = std::chrono::steady_clock::now();
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            waitCv.wait_for(lock, checkInterval, [this] { return !running; });
+        }
+        if (running && log.needsCompaction()) {
+            log.compact([this](size_t bytes) { return acquire(bytes); });
+        }
+    }
+}
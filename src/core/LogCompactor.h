@@ -0,0 +1,52 @@
+#ifndef LOG_COMPACTOR_H
+#define LOG_COMPACTOR_H
+
+#include "MessageLog.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Background thread that keeps a MessageLog compacted.
+// Every checkIntervalMs it asks the log whether sealed segments hold
+// superseded records and, if so, runs MessageLog::compact(). Reads and
+// writes of the compaction pass through a token bucket so it never uses
+// more than bytesPerSecond of disk bandwidth, leaving the rest to the
+// publish path.
+class LogCompactor {
+private:
+    MessageLog& log;
+    uint64_t bytesPerSecond;
+    std::chrono::milliseconds checkInterval;
+
+    // Token bucket (compactor thread only)
+    double tokens;
+    double burst;
+    std::chrono::steady_clock::time_point lastRefill;
+
+    std::mutex waitMutex;
+    std::condition_variable waitCv;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    void run();
+
+    // Wait until `bytes` may be transferred; false once stop() was called
+    bool acquire(size_t bytes);
+
+public:
+    LogCompactor(MessageLog& messageLog, uint64_t bytes_per_second, int check_interval_ms = 1000);
+    ~LogCompactor();
+
+    LogCompactor(const LogCompactor&) = delete;
+    LogCompactor& operator=(const LogCompactor&) = delete;
+
+    void start();
+
+    // Stops the thread; a compaction in progress is abandoned
+    void stop();
+};
+
+#endif // LOG_COMPACTOR_H
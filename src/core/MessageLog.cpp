@@ -0,0 +1,791 @@
+#include "MessageLog.h"
+#include "TopicHistory.h"
+#include "../Serialization.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const int MessageLog::INDEX_INTERVAL;
+const uint32_t MessageLog::HEADER_BYTES;
+const uint32_t MessageLog::RECORD_HEADER_BYTES;
+const uint32_t MessageLog::FLAG_COMPACTED;
+
+static const char SEGMENT_MAGIC[8] = {'P', 'S', 'L', 'O', 'G', '0', '0', '1'};
+
+// ==================== Mapped segment file ====================
+
+struct MessageLog::Segment {
+    uint32_t id = 0;
+    uint8_t* base = nullptr;
+    uint32_t size = 0;
+    uint32_t end = HEADER_BYTES;    // Write position (logMutex)
+    uint32_t synced = 0;            // Flushed up to (syncMutex)
+    bool compacted = false;         // Holds at most one record per topic
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    // Map an existing segment (createSize == 0) or create one of createSize bytes
+    bool map(const std::string& path, uint32_t createSize);
+    void flush(uint32_t from, uint32_t to);
+
+    ~Segment();
+};
+
+#ifdef _WIN32
+
+bool MessageLog::Segment::map(const std::string& path, uint32_t createSize) {
+    // FILE_SHARE_DELETE lets compaction delete segments that are still mapped
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                       createSize ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER length;
+    if (createSize) {
+        length.QuadPart = createSize;
+        if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            return false;
+        }
+    } else if (!GetFileSizeEx(file, &length)) {
+        return false;
+    }
+    size = (uint32_t)length.QuadPart;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, size, nullptr);
+    if (mapping == nullptr) {
+        return false;
+    }
+    base = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    return base != nullptr;
+}
+
+void MessageLog::Segment::flush(uint32_t from, uint32_t to) {
+    FlushViewOfFile(base + from, to - from);
+    FlushFileBuffers(file);
+}
+
+MessageLog::Segment::~Segment() {
+    if (base != nullptr) {
+        UnmapViewOfFile(base);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+}
+
+#else
+
+bool MessageLog::Segment::map(const std::string& path, uint32_t createSize) {
+    fd = ::open(path.c_str(), O_RDWR | (createSize ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (createSize) {
+        // Reserve the blocks now: running out of disk inside a mapping is a SIGBUS
+#ifdef __linux__
+        if (posix_fallocate(fd, 0, createSize) != 0) {
+            return false;
+        }
+#else
+        if (ftruncate(fd, createSize) != 0) {
+            return false;
+        }
+#endif
+        size = createSize;
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            return false;
+        }
+        size = (uint32_t)st.st_size;
+    }
+
+    if (size == 0) {
+        return false;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    base = (uint8_t*)addr;
+    return true;
+}
+
+void MessageLog::Segment::flush(uint32_t from, uint32_t to) {
+    static const uintptr_t pageMask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t start = (uintptr_t)(base + from) & ~pageMask;
+    msync((void*)start, (uintptr_t)(base + to) - start, MS_SYNC);
+}
+
+MessageLog::Segment::~Segment() {
+    if (base != nullptr) {
+        munmap(base, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+#endif
+
+// ==================== Encoding helpers ====================
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    static const struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+        }
+    } table;
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (v >> ((7 - i) * 8)) & 0xFF;
+    }
+}
+
+static uint64_t get64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// CRC covers the sequence number and the message
+static uint32_t recordCrc(const uint8_t* seqBytes, const uint8_t* message, size_t len) {
+    return crc32(crc32(0, seqBytes, 8), message, len);
+}
+
+static bool sameTopic(const uint8_t* message, size_t len, const char* topic, size_t topicLen) {
+    const char* recordTopic;
+    size_t recordTopicLen;
+    return Serialization::peekTopic(message, len, recordTopic, recordTopicLen) &&
+           recordTopicLen == topicLen && memcmp(recordTopic, topic, topicLen) == 0;
+}
+
+// ==================== MessageLog ====================
+
+MessageLog::MessageLog(const Options& opts)
+    : options(opts), spareInFlight(false), nextSegmentId(0), running(false), syncCount(0), compactionCount(0) {
+    if (options.segmentBytes < 64 * 1024) {
+        options.segmentBytes = 64 * 1024;
+    }
+    if (options.syncIntervalMs < 1) {
+        options.syncIntervalMs = 1;
+    }
+}
+
+MessageLog::~MessageLog() {
+    close();
+}
+
+std::string MessageLog::segmentPath(uint32_t id) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%010u.log", id);
+    return (std::filesystem::path(options.directory) / name).string();
+}
+
+std::shared_ptr<MessageLog::Segment> MessageLog::findSegment(uint32_t id) const {
+    auto it = std::lower_bound(segments.begin(), segments.end(), id,
+                               [](const std::shared_ptr<Segment>& s, uint32_t v) { return s->id < v; });
+    return (it != segments.end() && (*it)->id == id) ? *it : nullptr;
+}
+
+std::shared_ptr<MessageLog::Segment> MessageLog::createSegment(uint32_t id, const std::string& path,
+                                                               uint32_t size, uint32_t flags) {
+    auto segment = std::make_shared<Segment>();
+    segment->id = id;
+    if (!segment->map(path, size)) {
+        LOG_ERROR("[MessageLog] Ne mogu da kreiram segment ", path);
+        return nullptr;
+    }
+
+    memcpy(segment->base, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    put32(segment->base + 8, segment->size);
+    put32(segment->base + 12, flags);
+    segment->compacted = (flags & FLAG_COMPACTED) != 0;
+    return segment;
+}
+
+bool MessageLog::recoverSegment(uint32_t id, const std::string& path) {
+    auto segment = std::make_shared<Segment>();
+    segment->id = id;
+    if (!segment->map(path, 0)) {
+        LOG_ERROR("[MessageLog] Ne mogu da otvorim segment ", path);
+        return false;
+    }
+    if (segment->size < HEADER_BYTES || memcmp(segment->base, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+        LOG_WARN("[MessageLog] Skipping ", path, ": not a log segment");
+        return true;
+    }
+    segment->compacted = (get32(segment->base + 12) & FLAG_COMPACTED) != 0;
+
+    // Walk records until the end marker or the first torn/corrupt one
+    uint32_t offset = HEADER_BYTES;
+    while (offset + RECORD_HEADER_BYTES <= segment->size) {
+        const uint8_t* record = segment->base + offset;
+        uint32_t len = get32(record);
+        if (len == 0 || len > segment->size - offset - RECORD_HEADER_BYTES) {
+            break;
+        }
+
+        const uint8_t* message = record + RECORD_HEADER_BYTES;
+        const char* topic;
+        size_t topicLen;
+        if (get32(record + 4) != recordCrc(record + 8, message, len) ||
+            !Serialization::peekTopic(message, len, topic, topicLen)) {
+            LOG_WARN("[MessageLog] ", path, ": corrupt record at offset ", offset,
+                     ", ignoring the rest of the segment");
+            break;
+        }
+
+        indexRecord(topic, topicLen, get64(record + 8), Position{id, offset});
+        offset += RECORD_HEADER_BYTES + len;
+    }
+
+    segment->end = offset;
+    segment->synced = offset;
+    segments.push_back(segment);
+    return true;
+}
+
+void MessageLog::indexRecord(const char* topic, size_t topicLen, uint64_t seq, Position position) {
+    TopicIndex& topicIndex = index[std::string(topic, topicLen)];
+    if (topicIndex.records % INDEX_INTERVAL == 0) {
+        topicIndex.sparse.push_back(IndexEntry{seq, position});
+    }
+    topicIndex.records++;
+    topicIndex.lastSeq = seq;
+    topicIndex.last = position;
+}
+
+bool MessageLog::open() {
+    auto started = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    std::filesystem::create_directories(options.directory, ec);
+    if (ec) {
+        LOG_ERROR("[MessageLog] Ne mogu da kreiram direktorijum ", options.directory, ": ", ec.message());
+        return false;
+    }
+
+    std::vector<uint32_t> ids;
+    std::vector<std::filesystem::path> unfinished;
+    for (const auto& file : std::filesystem::directory_iterator(options.directory, ec)) {
+        if (file.path().extension() == ".tmp") {
+            unfinished.push_back(file.path());
+            continue;
+        }
+        std::string stem = file.path().stem().string();
+        if (file.path().extension() == ".log" && !stem.empty() &&
+            std::all_of(stem.begin(), stem.end(), [](unsigned char c) { return std::isdigit(c) != 0; })) {
+            ids.push_back((uint32_t)std::stoul(stem));
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // Output of a compaction that did not finish; the segments it was
+    // built from are all still there
+    for (const auto& path : unfinished) {
+        std::filesystem::remove(path, ec);
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    for (uint32_t id : ids) {
+        if (!recoverSegment(id, segmentPath(id))) {
+            return false;
+        }
+    }
+    nextSegmentId = ids.empty() ? 0 : ids.back() + 1;
+
+    // Appends continue in the last segment; clear whatever a torn write left
+    // behind so it can never be mistaken for a record later
+    if (!segments.empty()) {
+        Segment* last = segments.back().get();
+        uint8_t* tail = last->base + last->end;
+        uint8_t* limit = last->base + last->size;
+        auto reverseEnd = std::find_if(std::reverse_iterator<uint8_t*>(limit),
+                                       std::reverse_iterator<uint8_t*>(tail),
+                                       [](uint8_t b) { return b != 0; });
+        uint8_t* dirtyEnd = reverseEnd.base();
+        if (dirtyEnd > tail) {
+            memset(tail, 0, dirtyEnd - tail);
+            last->synced = 0;
+        }
+    }
+
+    uint64_t records = 0;
+    for (const auto& kv : index) {
+        records += kv.second.records;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("[MessageLog] ", options.directory, ": ", records, " zapis(a), ", index.size(),
+             " topic(a), ", segments.size(), " segment(a) oporavljeno za ", elapsed.count(), " ms");
+
+    running = true;
+    syncThread = std::thread(&MessageLog::syncLoop, this);
+    return true;
+}
+
+void MessageLog::close() {
+    if (running.exchange(false)) {
+        syncCv.notify_all();
+        if (syncThread.joinable()) {
+            syncThread.join();
+        }
+    }
+    sync();
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    segments.clear();
+    spare.reset();
+    index.clear();
+}
+
+bool MessageLog::append(const char* topic, uint64_t seq, const uint8_t* message, size_t len) {
+    uint32_t recordBytes = RECORD_HEADER_BYTES + (uint32_t)len;
+    if (len == 0 || len > options.segmentBytes - HEADER_BYTES - RECORD_HEADER_BYTES) {
+        return false;
+    }
+
+    uint8_t header[RECORD_HEADER_BYTES];
+    put32(header, (uint32_t)len);
+    put64(header + 8, seq);
+    put32(header + 4, recordCrc(header + 8, message, len));
+
+    std::unique_lock<std::mutex> lock(logMutex);
+
+    Segment* segment = segments.empty() ? nullptr : segments.back().get();
+    if (segment == nullptr || segment->end + recordBytes > segment->size) {
+        // The spare being created has the next id: wait for it rather than
+        // push a later segment ahead of it
+        spareReady.wait(lock, [this] { return !spareInFlight; });
+        std::shared_ptr<Segment> next = std::move(spare);
+        if (next == nullptr) {
+            next = createSegment(nextSegmentId, segmentPath(nextSegmentId), options.segmentBytes, 0);
+            nextSegmentId++;
+            if (next == nullptr) {
+                return false;
+            }
+        }
+        segments.push_back(next);
+        segment = next.get();
+    }
+
+    // Message first, length last: a torn record fails its CRC on recovery
+    uint8_t* record = segment->base + segment->end;
+    memcpy(record + RECORD_HEADER_BYTES, message, len);
+    memcpy(record, header, RECORD_HEADER_BYTES);
+
+    indexRecord(topic, strlen(topic), seq, Position{segment->id, segment->end});
+    segment->end += recordBytes;
+    return true;
+}
+
+size_t MessageLog::scan(const char* topic, uint8_t mode, uint64_t from, const RecordFn& fn) const {
+    std::vector<std::shared_ptr<Segment>> range;
+    std::vector<uint32_t> ends;
+    uint32_t startOffset;
+    uint64_t lastSeq;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        auto it = index.find(topic);
+        if (it == index.end() || it->second.sparse.empty()) {
+            return 0;
+        }
+        const TopicIndex& topicIndex = it->second;
+        if (mode == TopicHistory::FROM_SEQUENCE && from > topicIndex.lastSeq) {
+            return 0;
+        }
+
+        // Seek to the last index entry at or before the requested sequence
+        Position start = topicIndex.sparse.front().position;
+        if (mode == TopicHistory::FROM_SEQUENCE) {
+            auto after = std::upper_bound(topicIndex.sparse.begin(), topicIndex.sparse.end(), from,
+                                          [](uint64_t seq, const IndexEntry& e) { return seq < e.seq; });
+            if (after != topicIndex.sparse.begin()) {
+                start = (after - 1)->position;
+            }
+        }
+
+        // Pin the segments; everything before the snapshotted ends is immutable
+        for (const auto& segment : segments) {
+            if (segment->id >= start.segment) {
+                range.push_back(segment);
+                ends.push_back(segment->end);
+            }
+        }
+        startOffset = start.offset;
+        lastSeq = topicIndex.lastSeq;
+    }
+
+    size_t topicLen = strlen(topic);
+    size_t visited = 0;
+    for (size_t i = 0; i < range.size(); i++) {
+        const Segment* segment = range[i].get();
+        uint32_t offset = (i == 0) ? startOffset : HEADER_BYTES;
+
+        while (offset < ends[i]) {
+            const uint8_t* record = segment->base + offset;
+            uint32_t len = get32(record);
+            const uint8_t* message = record + RECORD_HEADER_BYTES;
+            offset += RECORD_HEADER_BYTES + len;
+
+            if (!sameTopic(message, len, topic, topicLen)) {
+                continue;
+            }
+
+            uint64_t seq = get64(record + 8);
+            bool wanted;
+            if (mode == TopicHistory::FROM_TIMESTAMP) {
+                long ts;
+                wanted = Serialization::peekTimestamp(message, len, ts) && (uint64_t)ts >= from;
+            } else {
+                wanted = seq >= from;
+            }
+            if (wanted) {
+                fn(seq, message, len);
+                visited++;
+            }
+            if (seq >= lastSeq) {
+                return visited;
+            }
+        }
+    }
+    return visited;
+}
+
+uint64_t MessageLog::readLastMessage(const char* topic, Message& out) const {
+    std::shared_ptr<Segment> segment;
+    uint32_t offset;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        auto it = index.find(topic);
+        if (it == index.end() || it->second.records == 0) {
+            return 0;
+        }
+        segment = findSegment(it->second.last.segment);
+        offset = it->second.last.offset;
+    }
+    if (segment == nullptr) {
+        return 0;
+    }
+
+    const uint8_t* record = segment->base + offset;
+    out = Serialization::deserialize(record + RECORD_HEADER_BYTES, get32(record));
+    return get64(record + 8);
+}
+
+uint64_t MessageLog::getLastSeq(const char* topic) const {
+    std::lock_guard<std::mutex> lock(logMutex);
+    auto it = index.find(topic);
+    return it != index.end() ? it->second.lastSeq : 0;
+}
+
+std::vector<std::string> MessageLog::getTopics() const {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::vector<std::string> topics;
+    topics.reserve(index.size());
+    for (const auto& kv : index) {
+        topics.push_back(kv.first);
+    }
+    return topics;
+}
+
+void MessageLog::flushPending() {
+    // Collect dirty ranges under the log lock, flush them without it
+    struct Dirty {
+        std::shared_ptr<Segment> segment;
+        uint32_t end;
+    };
+    std::vector<Dirty> dirty;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        for (const auto& segment : segments) {
+            if (segment->synced < segment->end) {
+                dirty.push_back(Dirty{segment, segment->end});
+            }
+        }
+    }
+
+    for (const Dirty& d : dirty) {
+        d.segment->flush(d.segment->synced, d.end);
+        d.segment->synced = d.end;
+    }
+    if (!dirty.empty()) {
+        syncCount++;
+    }
+}
+
+void MessageLog::sync() {
+    std::lock_guard<std::mutex> lock(syncMutex);
+    flushPending();
+}
+
+void MessageLog::syncLoop() {
+    std::unique_lock<std::mutex> lock(syncMutex);
+    while (running) {
+        syncCv.wait_for(lock, std::chrono::milliseconds(options.syncIntervalMs), [this] { return !running; });
+
+        // Group commit: one flush for every append since the last one
+        flushPending();
+
+        // Have the next segment ready so a roll never waits for the disk
+        uint32_t id;
+        {
+            std::lock_guard<std::mutex> logLock(logMutex);
+            if (spare != nullptr || segments.empty() ||
+                segments.back()->end < segments.back()->size / 2) {
+                continue;
+            }
+            id = nextSegmentId++;
+            spareInFlight = true;
+        }
+        std::shared_ptr<Segment> next = createSegment(id, segmentPath(id), options.segmentBytes, 0);
+        {
+            // On failure the id is skipped; append creates the one after it
+            std::lock_guard<std::mutex> logLock(logMutex);
+            spare = next;
+            spareInFlight = false;
+        }
+        spareReady.notify_all();
+    }
+}
+
+bool MessageLog::needsCompaction() const {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (segments.size() < 2) {
+        return false;
+    }
+    // Sealed segments: everything before the one being appended to
+    return segments.size() > 2 || !segments.front()->compacted;
+}
+
+// Make a rename or delete in the log directory durable
+static void syncDirectory(const std::string& directory) {
+#ifndef _WIN32
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)directory;    // NTFS journals renames itself
+#endif
+}
+
+bool MessageLog::compact(const ThrottleFn& throttle) {
+    auto started = std::chrono::steady_clock::now();
+
+    // Snapshot the sealed segments and where each topic's newest record is
+    std::vector<std::shared_ptr<Segment>> sealed;
+    std::unordered_map<std::string, Position> newest;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if (segments.size() < 2) {
+            return false;
+        }
+        sealed.assign(segments.begin(), segments.end() - 1);
+        for (const auto& kv : index) {
+            newest.emplace(kv.first, kv.second.last);
+        }
+    }
+    uint32_t targetId = sealed.back()->id;
+
+    // Pass 1: find the records to keep. A sealed record survives only if it
+    // is still its topic's newest; topics updated since live elsewhere.
+    struct Kept {
+        const uint8_t* record;
+        uint32_t bytes;
+    };
+    std::vector<Kept> kept;
+    std::unordered_map<std::string, uint64_t> dropped;     // Records per topic leaving the sealed range
+    uint64_t inputBytes = 0;
+    uint64_t inputRecords = 0;
+    uint32_t outputBytes = HEADER_BYTES;
+
+    for (const auto& segment : sealed) {
+        if (!throttle(segment->end)) {
+            return false;
+        }
+        uint32_t offset = HEADER_BYTES;
+        while (offset < segment->end) {
+            const uint8_t* record = segment->base + offset;
+            uint32_t bytes = RECORD_HEADER_BYTES + get32(record);
+            const char* topic;
+            size_t topicLen;
+            Serialization::peekTopic(record + RECORD_HEADER_BYTES, bytes - RECORD_HEADER_BYTES, topic, topicLen);
+
+            std::string key(topic, topicLen);
+            dropped[key]++;
+            auto it = newest.find(key);
+            if (it != newest.end() && it->second.segment == segment->id && it->second.offset == offset) {
+                kept.push_back(Kept{record, bytes});
+                outputBytes += bytes;
+            }
+            inputRecords++;
+            offset += bytes;
+        }
+        inputBytes += segment->end;
+    }
+
+    // Pass 2: write the survivors to a temporary segment and make it durable
+    std::string tmpPath = segmentPath(targetId) + ".tmp";
+    std::shared_ptr<Segment> output = createSegment(targetId, tmpPath, outputBytes, FLAG_COMPACTED);
+    if (output == nullptr) {
+        return false;
+    }
+
+    std::unordered_map<std::string, IndexEntry> moved;
+    for (const Kept& k : kept) {
+        if (!throttle(k.bytes)) {
+            output.reset();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        memcpy(output->base + output->end, k.record, k.bytes);
+
+        const char* topic;
+        size_t topicLen;
+        Serialization::peekTopic(k.record + RECORD_HEADER_BYTES, k.bytes - RECORD_HEADER_BYTES, topic, topicLen);
+        moved[std::string(topic, topicLen)] = IndexEntry{get64(k.record + 8), Position{targetId, output->end}};
+        output->end += k.bytes;
+    }
+    output->flush(0, output->size);
+    output->synced = output->end;
+
+    // Atomic swap on disk: the new segment replaces the newest sealed one
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, segmentPath(targetId), ec);
+    if (ec) {
+        LOG_ERROR("[MessageLog] Kompakcija prekinuta, rename nije uspeo: ", ec.message());
+        output.reset();
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    syncDirectory(options.directory);
+
+    // ...and in memory; appends only ever touch the last segment, so the
+    // sealed prefix is unchanged
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        segments.erase(segments.begin(), segments.begin() + sealed.size());
+        segments.insert(segments.begin(), output);
+        uint32_t firstUnsealed = segments[1]->id;
+
+        for (auto& kv : index) {
+            TopicIndex& topicIndex = kv.second;
+            auto& sparse = topicIndex.sparse;
+
+            // Entries into the sealed range are a prefix (seq and segment ids both grow)
+            auto firstKept = std::find_if(sparse.begin(), sparse.end(),
+                                          [targetId](const IndexEntry& e) { return e.position.segment > targetId; });
+            bool erased = firstKept != sparse.begin();
+            uint64_t erasedSeq = erased ? (firstKept - 1)->seq : 0;
+            sparse.erase(sparse.begin(), firstKept);
+
+            // Records written after the sealed range but before the topic's
+            // next index entry are only reachable from the start of the first
+            // unsealed segment; scan skips other topics' records on the way
+            bool reindex = erased && topicIndex.last.segment > targetId &&
+                           (sparse.empty() || sparse.front().position.segment != firstUnsealed ||
+                            sparse.front().position.offset != HEADER_BYTES);
+
+            auto droppedIt = dropped.find(kv.first);
+            if (droppedIt != dropped.end()) {
+                topicIndex.records -= droppedIt->second;
+            }
+
+            auto movedIt = moved.find(kv.first);
+            bool kept = movedIt != moved.end();
+            if (kept) {
+                sparse.insert(sparse.begin(), movedIt->second);
+                topicIndex.records++;
+                if (topicIndex.last.segment <= targetId) {
+                    topicIndex.last = movedIt->second.position;
+                }
+            }
+
+            if (reindex) {
+                // Behind a kept record everything unsealed is newer than it
+                uint64_t seq = kept ? movedIt->second.seq + 1 : erasedSeq;
+                sparse.insert(sparse.begin() + (kept ? 1 : 0),
+                              IndexEntry{seq, Position{firstUnsealed, HEADER_BYTES}});
+            }
+        }
+    }
+
+    // Older sealed segments go last: until now recovery still finds the old records
+    for (size_t i = 0; i + 1 < sealed.size(); i++) {
+        std::filesystem::remove(segmentPath(sealed[i]->id), ec);
+    }
+    syncDirectory(options.directory);
+    compactionCount++;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("[MessageLog] Kompakcija: ", sealed.size(), " segment(a), ", inputRecords, " -> ",
+             kept.size(), " zapis(a), ", inputBytes / 1024, " KB -> ", outputBytes / 1024,
+             " KB za ", elapsed.count(), " ms");
+    return true;
+}
+
+int MessageLog::getSegmentCount() const {
+    std::lock_guard<std::mutex> lock(logMutex);
+    return (int)segments.size();
+}
+
+uint64_t MessageLog::getSyncCount() const {
+    return syncCount.load();
+}
+
+uint64_t MessageLog::getCompactionCount() const {
+    return compactionCount.load();
+}
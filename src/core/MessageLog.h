@@ -0,0 +1,154 @@
+#ifndef MESSAGE_LOG_H
+#define MESSAGE_LOG_H
+
+#include "../Message.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Durable append-only log of published messages (write-ahead log).
+//
+// Records are appended to fixed-size segment files named <id>.log in the log
+// directory. Every segment is memory-mapped: appends are a memcpy into the
+// mapping and reads hand out pointers into it, so replay never copies or
+// deserializes a message. A background thread flushes written ranges to disk
+// every syncIntervalMs (group commit: one fsync covers every append since the
+// previous one) and prepares the next segment ahead of time.
+//
+// Segment layout:  [magic "PSLOG001"(8)] [segment size(4)] [flags(4)] records...
+// Record layout:   [len(4)] [crc32(4)] [seq(8)] [serialized message(len)]
+// A zero length marks the end of the written part of a segment.
+//
+// A sparse index keeps one (seq, position) pair per topic every
+// INDEX_INTERVAL records; lookups seek to the nearest entry and scan forward.
+// open() rebuilds the index by walking the segments and stops at the first
+// torn or corrupt record.
+//
+// compact() folds every sealed segment (all but the one being appended to)
+// into a single segment holding only the newest record of each topic, so
+// recovery work depends on the number of topics rather than on uptime.
+class MessageLog {
+public:
+    struct Options {
+        std::string directory;
+        uint32_t segmentBytes = 16 * 1024 * 1024;
+        int syncIntervalMs = 10;
+    };
+
+    // Called with each matching record; message points into the mapped segment
+    using RecordFn = std::function<void(uint64_t seq, const uint8_t* message, size_t len)>;
+
+    // Called before compact() reads or writes a chunk of bytes; may sleep to
+    // bound bandwidth. Returning false abandons the compaction.
+    using ThrottleFn = std::function<bool(size_t bytes)>;
+
+    static const uint32_t FLAG_COMPACTED = 1;   // Segment written by compact()
+
+    static const int INDEX_INTERVAL = 64;       // Records per topic between index entries
+    static const uint32_t HEADER_BYTES = 16;    // Segment header
+    static const uint32_t RECORD_HEADER_BYTES = 16;
+
+    explicit MessageLog(const Options& options);
+    ~MessageLog();
+
+    MessageLog(const MessageLog&) = delete;
+    MessageLog& operator=(const MessageLog&) = delete;
+
+    // Recover existing segments and start the sync thread.
+    // Returns false if the directory or a segment cannot be opened.
+    bool open();
+
+    // Flush everything and unmap the segments
+    void close();
+
+    // Append one serialized message. Callers keep seq increasing per topic.
+    // Returns false if the record does not fit in a segment or the disk is full.
+    bool append(const char* topic, uint64_t seq, const uint8_t* message, size_t len);
+
+    // Visit a topic's records with seq >= from (TopicHistory::FROM_SEQUENCE) or
+    // timestamp >= from (TopicHistory::FROM_TIMESTAMP), oldest first.
+    // Returns the number of records visited.
+    size_t scan(const char* topic, uint8_t mode, uint64_t from, const RecordFn& fn) const;
+
+    // Newest logged message of a topic (restores the last-value cache after
+    // a restart). Returns its sequence number, 0 if the log has none.
+    uint64_t readLastMessage(const char* topic, Message& out) const;
+
+    // Highest sequence number logged for a topic (0 if none)
+    uint64_t getLastSeq(const char* topic) const;
+
+    // Topics that have at least one record
+    std::vector<std::string> getTopics() const;
+
+    // Flush written data now instead of waiting for the next group commit
+    void sync();
+
+    // True when a sealed segment holds records compact() would drop
+    bool needsCompaction() const;
+
+    // Rewrite the sealed segments as one segment with the newest record per
+    // topic: written to <id>.log.tmp, flushed, then renamed over the newest
+    // sealed segment before the older ones are deleted. A crash at any point
+    // leaves either the old or the new set of records. Not thread-safe with
+    // itself (one compactor per log). Returns false if nothing was compacted.
+    bool compact(const ThrottleFn& throttle);
+
+    int getSegmentCount() const;
+    uint64_t getSyncCount() const;
+    uint64_t getCompactionCount() const;
+
+private:
+    struct Position {
+        uint32_t segment;   // Segment id
+        uint32_t offset;
+    };
+
+    struct IndexEntry {
+        uint64_t seq;
+        Position position;
+    };
+
+    struct TopicIndex {
+        uint64_t lastSeq = 0;
+        uint64_t records = 0;
+        Position last;                      // Newest record
+        std::vector<IndexEntry> sparse;     // Ordered by seq
+    };
+
+    struct Segment;
+
+    Options options;
+
+    mutable std::mutex logMutex;            // Guards segments, spare, index and write positions
+    std::vector<std::shared_ptr<Segment>> segments;     // Ordered by id
+    std::shared_ptr<Segment> spare;         // Next segment, created ahead by the sync thread
+    bool spareInFlight;                     // Sync thread holds the next id and is creating spare
+    std::condition_variable spareReady;     // spareInFlight cleared (with logMutex)
+    std::unordered_map<std::string, TopicIndex> index;
+    uint32_t nextSegmentId;
+
+    std::mutex syncMutex;                   // Serializes flushes
+    std::condition_variable syncCv;
+    std::thread syncThread;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> syncCount;
+    std::atomic<uint64_t> compactionCount;
+
+    std::shared_ptr<Segment> createSegment(uint32_t id, const std::string& path, uint32_t size, uint32_t flags);
+    bool recoverSegment(uint32_t id, const std::string& path);
+    void indexRecord(const char* topic, size_t topicLen, uint64_t seq, Position position);
+    void syncLoop();
+    void flushPending();
+    std::string segmentPath(uint32_t id) const;
+    std::shared_ptr<Segment> findSegment(uint32_t id) const;
+};
+
+#endif // MESSAGE_LOG_H
@@ -1,37 +1,133 @@
 #include "PubSubEngine.h"
-#include <iostream>
+#include "../utils/Logger.h"
 #include <cstring>
 #include <chrono>
+#include <algorithm>
 
-PubSubEngine::PubSubEngine() : numTopics(0), running(false) {
-    topics = new TopicEntry[MAX_TOPICS];
+const int PubSubEngine::REPLY_THREADS;
+const int PubSubEngine::MAX_IDS_PER_CONNECTION;
+
+PubSubEngine::PubSubEngine(int deliveryThreads, int shards)
+    : wildcardCount(0), deliveryExecutor(deliveryThreads), replyExecutor(REPLY_THREADS), running(false), numShards(shards),
+      defaultRetention(TopicHistory::DEFAULT_DEPTH), messageLog(nullptr), logCompactor(nullptr) {
+    topicIndex.publish(new TopicIndex(64));
 }
 
 PubSubEngine::~PubSubEngine() {
     stop();
-    delete[] topics;
+    // Free snapshots replaced so far before their entries go away
+    EpochDomain::instance().synchronize();
+    topics.forEach([](const char*, TopicEntry*& entry) {
+        delete entry;
+    });
+    delete logCompactor;
+    delete messageLog;
+}
+
+bool PubSubEngine::enableMessageLog(const MessageLog::Options& options, uint64_t compactBytesPerSecond) {
+    MessageLog* log = new MessageLog(options);
+    if (!log->open()) {
+        delete log;
+        return false;
+    }
+    delete logCompactor;
+    delete messageLog;
+    messageLog = log;
+    logCompactor = compactBytesPerSecond > 0 ? new LogCompactor(*log, compactBytesPerSecond) : nullptr;
+    return true;
 }
 
 void PubSubEngine::start() {
     if (!running) {
         running = true;
         
+        deliveryExecutor.start();
+        replyExecutor.start();
+        if (logCompactor != nullptr) {
+            logCompactor->start();
+        }
+        
+        // Sharded mode: reactor threads route frames themselves when the
+        // server supports it, otherwise acceptConnections is the one producer
+        int ingestThreads = server.getIngestThreadCount();
+        if (numShards > 0) {
+            int producers = ingestThreads > 0 ? ingestThreads : 1;
+            std::lock_guard<std::mutex> lock(retentionMutex);
+            for (int i = 0; i < numShards; i++) {
+                EngineShard* shard = new EngineShard(i, producers, defaultRetention, messageLog, &topicRegistry, &metrics,
+                    [this](const SubscriberSnapshot& subscribers, const Message& msg, std::vector<uint8_t>&& serialized) {
+                        dispatchDeliveries(subscribers, msg, std::move(serialized));
+                    },
+                    [this](uint64_t connection, const char* topic, std::vector<std::vector<uint8_t>>&& frames) {
+                        sendReplies((SOCKET)connection, topic, std::move(frames));
+                    },
+                    [this]() {
+                        server.resumeReading();
+                    });
+                shard->start();
+                shards.push_back(shard);
+            }
+            
+            // Hand per-topic retention settings to the owning shards
+            for (const auto& kv : retentionByTopic) {
+                shards[EngineShard::shardOf(kv.first.c_str(), numShards)]->postControl(
+                    EngineShard::makeTopicCommand(EngineShard::CMD_SET_RETENTION, kv.second, kv.first.c_str()));
+            }
+            
+            // Topics recovered from the log exist again before any traffic
+            if (messageLog != nullptr) {
+                for (const std::string& topic : messageLog->getTopics()) {
+                    shards[EngineShard::shardOf(topic.c_str(), numShards)]->postControl(
+                        EngineShard::makeTopicCommand(EngineShard::CMD_OPEN_TOPIC, 0, topic.c_str()));
+                }
+            }
+            if (ingestThreads > 0) {
+                server.setFrameSink([this](int ingestIndex, SOCKET connection, std::vector<uint8_t>&& frame) {
+                    return ingestFrame(ingestIndex, connection, std::move(frame));
+                });
+            }
+        } else if (messageLog != nullptr) {
+            // Topics recovered from the log exist again before any traffic
+            std::lock_guard<std::mutex> lock(engineMutex);
+            for (const std::string& topic : messageLog->getTopics()) {
+                getOrCreateTopic(topic.c_str());
+            }
+        }
+        
+        server.setCloseSink([this](SOCKET connection) {
+            forgetConnection(connection);
+        });
+        
         int enginePort = PortPool::getEnginePort();
         if (!server.start(enginePort)) {
-            std::cerr << "[PubSubEngine] Failed to start server on port " << enginePort << std::endl;
+            LOG_ERROR("[PubSubEngine] Failed to start server on port ", enginePort);
             running = false;
+            for (EngineShard* shard : shards) {
+                delete shard;
+            }
+            shards.clear();
+            deliveryExecutor.stop();
+            replyExecutor.stop();
             return;
         }
         
-        std::cout << "[PubSubEngine] Engine started on port " << enginePort << std::endl;
+        LOG_INFO("[PubSubEngine] Engine started on port ", enginePort);
+        LOG_INFO("[PubSubEngine] Delivery pool started with ",
+                 deliveryExecutor.getWorkerCount(), " worker(s)");
+        if (!shards.empty()) {
+            LOG_INFO("[PubSubEngine] Sharded mode: ", shards.size(), " shard(s), ",
+                     (ingestThreads > 0 ? ingestThreads : 1), " ingest thread(s)");
+        }
         
-        acceptThread = std::thread(&PubSubEngine::acceptConnections, this);
-        acceptThread.detach();
+        if (shards.empty() || ingestThreads == 0) {
+            acceptThread = std::thread(&PubSubEngine::acceptConnections, this);
+            acceptThread.detach();
+        }
         
         // Start validation thread for subscriber health checks
         validationThread = std::thread(&PubSubEngine::validateSubscribers, this);
         validationThread.detach();
-        std::cout << "[PubSubEngine] Subscriber validation thread started" << std::endl;
+        LOG_INFO("[PubSubEngine] Subscriber validation thread started");
     }
 }
 
@@ -39,29 +135,101 @@ void PubSubEngine::stop() {
     if (running) {
         running = false;
         server.stop();
-        std::cout << "[PubSubEngine] Engine stopped" << std::endl;
+        for (EngineShard* shard : shards) {
+            shard->stop();
+            delete shard;
+        }
+        shards.clear();
+        if (logCompactor != nullptr) {
+            logCompactor->stop();
+        }
+        if (messageLog != nullptr) {
+            messageLog->sync();
+        }
+        deliveryExecutor.stop();
+        replyExecutor.stop();
+        connectionPool.clear();
+        LOG_INFO("[PubSubEngine] Engine stopped");
+    }
+}
+
+bool PubSubEngine::ingestFrame(int ingestIndex, SOCKET connection, std::vector<uint8_t>&& frame) {
+    // A refused frame is offered again once the shard has room; count it then
+    size_t bytes = frame.size();
+    bool taken = true;
+    if (!frame.empty() && frame[0] == 3) {
+        handleQuery(connection, frame);  // Read-only, answered on the I/O thread
+    } else if (!frame.empty() && frame[0] == TopicRegistry::CMD_REGISTER_TOPIC) {
+        handleRegister(connection, frame);
+    } else if (!frame.empty() && frame[0] == TopicHistory::CMD_REPLAY) {
+        taken = handleReplay(ingestIndex, connection, frame);
+    } else if (!frame.empty() && frame[0] == EngineMetrics::CMD_STATS) {
+        handleStats(connection, frame);
+    } else {
+        taken = routeFrame(ingestIndex, std::move(frame));
+    }
+    if (taken) {
+        countInbound(bytes);
     }
+    return taken;
 }
 
 void PubSubEngine::acceptConnections() {
     while (running && !ConsoleHandler::shouldExit()) {
-        std::vector<uint8_t> data = server.receiveMessage();
+        // Blocks until a frame arrives; the timeout only bounds shutdown latency
+        InboundFrame frame;
+        if (!server.receiveFrame(frame, 100)) continue;
+        std::vector<uint8_t>& data = frame.payload;
+        
+        // Parse command: [command(1)] [data...]
+        if (data.empty()) continue;
+        countInbound(data.size());
         
-        if (data.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (data[0] == 3) {
+            // QUERY_LAST command: [topic_len(1)] [topic or pattern...]
+            handleQuery(frame.connection, data);
             continue;
         }
         
-        // Parse command: [command(1)] [data...]
-        if (data.empty()) continue;
+        if (data[0] == TopicHistory::CMD_REPLAY) {
+            // REPLAY command: [mode(1)] [from(8)] [topic_len(1)] [topic...]
+            handleReplay(0, frame.connection, data);
+            continue;
+        }
+        
+        if (data[0] == TopicRegistry::CMD_REGISTER_TOPIC) {
+            // REGISTER_TOPIC command: [port(4)] [host_len(1)] [host...] [topic_len(1)] [topic...]
+            handleRegister(frame.connection, data);
+            continue;
+        }
+        
+        if (data[0] == EngineMetrics::CMD_STATS) {
+            // STATS command: [max_topics(2)]
+            handleStats(frame.connection, data);
+            continue;
+        }
+        
+        if (!shards.empty()) {
+            routeFrame(0, std::move(data));
+            continue;
+        }
         
         uint8_t cmd = data[0];
         
         if (cmd == 0) {
             // PUBLISH command: [data...]
-            // The rest is a serialized Message
-            Message msg = Serialization::deserialize(data.data() + 1, data.size() - 1);
-            publish(msg);
+            // The rest is a serialized Message; subscribers get the same bytes
+            MessageView view(data.data() + 1, data.size() - 1);
+            if (!view.isValid()) continue;
+            Message msg = view.toMessage();
+            data.erase(data.begin());
+            publishSerialized(msg, std::move(data));
+        } else if (cmd == TopicRegistry::CMD_PUBLISH_ID) {
+            // PUBLISH_ID command: [id(4)] [type(1)] [topicType(1)] [data(4)] [timestamp(8)]
+            publishById(data.data(), data.size());
+        } else if (cmd == PublishBatcher::CMD_PUBLISH_BATCH) {
+            // PUBLISH_BATCH command: [count(2)] { [len(2)] [PUBLISH or PUBLISH_ID frame] }*
+            publishBatch(data);
         } else if (cmd == 1) {
             // SUBSCRIBE command: [port(4)] [topic_len(1)] [topic...]
             if (data.size() < 6) continue;
@@ -92,184 +260,798 @@ void PubSubEngine::acceptConnections() {
             
             unsubscribeInternal(topic, 0);
         }
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
-int PubSubEngine::hashTopic(const char* topic) const {
-    unsigned long hash = 5381;
-    int c;
-    const char* str = topic;
+void PubSubEngine::postToShard(int producer, EngineShard* shard, std::vector<uint8_t>&& frame) {
+    if (producer < 0) {
+        shard->postControl(std::move(frame));
+    } else {
+        shard->post(producer, std::move(frame));
+    }
+}
+
+int PubSubEngine::shardOfPublish(const uint8_t* frame, size_t len) const {
+    if (frame[0] == TopicRegistry::CMD_PUBLISH_ID) {
+        // Registered topics carry their shard with them
+        const TopicRegistry::Registration* reg = topicRegistry.find(TopicRegistry::readId(frame, len));
+        return reg != nullptr ? reg->shard : -1;
+    }
+    if (frame[0] != 0) {
+        return -1;
+    }
     
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
+    MessageView view(frame + 1, len - 1);
+    if (!view.isValid() || view.topic().size() >= Message::MAX_TOPIC_LEN) {
+        return -1;
+    }
+    char topic[Message::MAX_TOPIC_LEN];
+    memcpy(topic, view.topic().data(), view.topic().size());
+    topic[view.topic().size()] = '\0';
+    return EngineShard::shardOf(topic, (int)shards.size());
+}
+
+bool PubSubEngine::shardsHaveRoom(int producer, const std::vector<int>& owners) {
+    if (producer < 0) {
+        return true;
+    }
+    for (int shard : owners) {
+        if (shard >= 0 && !shards[shard]->hasRoom(producer)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PubSubEngine::routeFrame(int producer, std::vector<uint8_t>&& frame) {
+    auto post = [this, producer](EngineShard* shard, std::vector<uint8_t>&& f) {
+        postToShard(producer, shard, std::move(f));
+    };
+    
+    if (!frame.empty() && frame[0] == TopicRegistry::CMD_PUBLISH_ID) {
+        int shard = shardOfPublish(frame.data(), frame.size());
+        if (shard >= 0) {
+            if (!shardsHaveRoom(producer, { shard })) {
+                return false;
+            }
+            post(shards[shard], std::move(frame));
+        }
+        return true;
     }
     
-    return hash % MAX_TOPICS;
+    if (!frame.empty() && frame[0] == PublishBatcher::CMD_PUBLISH_BATCH) {
+        return routeBatch(producer, std::move(frame));
+    }
+    
+    char topic[Message::MAX_TOPIC_LEN + 1];
+    if (!EngineShard::readTopic(frame, topic, sizeof(topic))) {
+        return true;
+    }
+    
+    // Wildcard (un)subscriptions concern topics on every shard; all or none
+    // of them get it, so a refused frame is never applied twice
+    if (frame[0] != 0 && TopicPattern::hasWildcards(topic)) {
+        std::vector<int> all;
+        for (size_t i = 0; i < shards.size(); i++) {
+            all.push_back((int)i);
+        }
+        if (!shardsHaveRoom(producer, all)) {
+            return false;
+        }
+        for (size_t i = 0; i + 1 < shards.size(); i++) {
+            post(shards[i], std::vector<uint8_t>(frame));
+        }
+        post(shards.back(), std::move(frame));
+        return true;
+    }
+    
+    int shard = EngineShard::shardOf(topic, (int)shards.size());
+    if (!shardsHaveRoom(producer, { shard })) {
+        return false;
+    }
+    post(shards[shard], std::move(frame));
+    return true;
+}
+
+bool PubSubEngine::routeBatch(int producer, std::vector<uint8_t>&& frame) {
+    std::vector<int> owners;
+    bool valid = PublishBatcher::forEachEntry(frame.data(), frame.size(), [&](const uint8_t* entry, size_t len) {
+        owners.push_back(shardOfPublish(entry, len));
+    });
+    if (!valid || owners.empty()) {
+        return true;
+    }
+    if (!shardsHaveRoom(producer, owners)) {
+        return false;
+    }
+    
+    if (owners.front() >= 0 && std::all_of(owners.begin(), owners.end(), [&](int s) { return s == owners.front(); })) {
+        postToShard(producer, shards[owners.front()], std::move(frame));
+        return true;
+    }
+    
+    // Entries keep their relative order within each shard's batch
+    std::vector<std::vector<uint8_t>> batches(shards.size());
+    size_t next = 0;
+    PublishBatcher::forEachEntry(frame.data(), frame.size(), [&](const uint8_t* entry, size_t len) {
+        int shard = owners[next++];
+        if (shard < 0) {
+            return;
+        }
+        std::vector<uint8_t>& batch = batches[shard];
+        if (batch.empty()) {
+            batch = { PublishBatcher::CMD_PUBLISH_BATCH, 0, 0 };
+        }
+        size_t count = (batch[1] | ((size_t)batch[2] << 8)) + 1;
+        batch[1] = (uint8_t)(count & 0xFF);
+        batch[2] = (uint8_t)(count >> 8);
+        batch.push_back((uint8_t)(len & 0xFF));
+        batch.push_back((uint8_t)(len >> 8));
+        batch.insert(batch.end(), entry, entry + len);
+    });
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (!batches[i].empty()) {
+            postToShard(producer, shards[i], std::move(batches[i]));
+        }
+    }
+    return true;
+}
+
+void PubSubEngine::dispatchDeliveries(const SubscriberSnapshot& subscribers, const Message& msg, std::vector<uint8_t>&& serialized) {
+    // Queue one delivery per subscriber; the subscriber port keys the lane so
+    // messages to the same subscriber keep their order
+    auto message = std::make_shared<const Message>(msg);
+    auto frame = std::make_shared<const std::vector<uint8_t>>(std::move(serialized));
+    auto dispatched = std::chrono::steady_clock::now();
+    for (const auto& addr : subscribers) {
+        deliveryExecutor.submit(addr.port, [this, addr, message, frame, dispatched]() {
+            deliverToSubscriber(addr, *message, *frame, dispatched);
+        });
+    }
 }
 
-int PubSubEngine::findTopicIndex(const char* topic) const {
-    int index = hashTopic(topic);
-    int originalIndex = index;
+PubSubEngine::TopicEntry* PubSubEngine::findTopic(const char* topic) const {
+    TopicEntry** entry = topics.find(topic);
+    return entry ? *entry : nullptr;
+}
+
+PubSubEngine::TopicIndex::TopicIndex(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<TopicEntry*>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+static size_t indexHome(uint64_t hash, size_t mask) {
+    return (size_t)((hash * 11400714819323198485ull) >> 32) & mask;
+}
+
+PubSubEngine::TopicEntry* PubSubEngine::lookupTopic(const char* topic) const {
+    uint64_t h = TopicTable<TopicEntry*>::hashKey(topic);
     
-    while (topics[index].occupied) {
-        if (strcmp(topics[index].topic, topic) == 0) {
-            return index;
+    // Entries are never freed while running; the guard only keeps the index alive
+    RcuReadGuard guard;
+    const TopicIndex* index = topicIndex.load();
+    for (size_t i = indexHome(h, index->mask); ; i = (i + 1) & index->mask) {
+        TopicEntry* entry = index->slots[i].load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        if (entry->hash == h && strcmp(entry->topic, topic) == 0) {
+            return entry;
         }
-        index = (index + 1) % MAX_TOPICS;
-        if (index == originalIndex) {
-            break;  // Pun krug, nije pronadjen
+    }
+}
+
+void PubSubEngine::indexTopic(TopicEntry* entry) {
+    const TopicIndex* index = topicIndex.load();
+    size_t capacity = index->mask + 1;
+    
+    // Keep the index at most half full so misses stop early
+    const TopicIndex* target = index;
+    if (topics.size() * 2 > capacity) {
+        TopicIndex* grown = new TopicIndex(capacity * 2);
+        for (size_t i = 0; i < capacity; i++) {
+            TopicEntry* existing = index->slots[i].load(std::memory_order_relaxed);
+            if (existing != nullptr) {
+                size_t j = indexHome(existing->hash, grown->mask);
+                while (grown->slots[j].load(std::memory_order_relaxed) != nullptr) {
+                    j = (j + 1) & grown->mask;
+                }
+                grown->slots[j].store(existing, std::memory_order_relaxed);
+            }
         }
+        target = grown;
     }
     
-    return -1;  // Nije pronadjen
+    size_t i = indexHome(entry->hash, target->mask);
+    while (target->slots[i].load(std::memory_order_relaxed) != nullptr) {
+        i = (i + 1) & target->mask;
+    }
+    target->slots[i].store(entry, std::memory_order_release);
+    
+    if (target != index) {
+        topicIndex.publish(target);
+    }
 }
 
 PubSubEngine::TopicEntry* PubSubEngine::getOrCreateTopic(const char* topic) {
-    int index = findTopicIndex(topic);
+    TopicEntry* entry = findTopic(topic);
+    
+    if (entry != nullptr) {
+        return entry;
+    }
+    
+    // Kreiranje novog topic-a (tabela raste inkrementalno, bez zaustavljanja)
+    entry = new TopicEntry(retentionFor(topic));
+    strncpy(entry->topic, topic, Message::MAX_TOPIC_LEN);
+    entry->topic[Message::MAX_TOPIC_LEN] = '\0';
+    entry->hash = TopicTable<TopicEntry*>::hashKey(entry->topic);
     
-    if (index != -1) {
-        return &topics[index];
+    // Continue the topic's numbering and last value from the log
+    if (messageLog != nullptr) {
+        Message last;
+        uint64_t lastSeq = messageLog->readLastMessage(topic, last);
+        if (lastSeq > 0) {
+            entry->history.setNextSeq(lastSeq + 1);
+            entry->lastValue.store(last);
+        }
+    }
+    {
+        std::unique_lock<std::shared_mutex> tableLock(topicsMutex);
+        topics.insert(topic, entry);
     }
+    indexTopic(entry);
     
-    // Kreiranje novog topic-a
-    if (numTopics >= MAX_TOPICS) {
-        std::cout << "[PubSubEngine] GRESKA: Dostignut maksimalan broj topic-a!" << std::endl;
-        return nullptr;
+    // Wildcard subscribers already cover the new topic
+    if (wildcardCount.load() > 0) {
+        rebuildSnapshot(entry);
     }
     
-    index = hashTopic(topic);
-    int originalIndex = index;
+    LOG_INFO("[PubSubEngine] Kreiran novi topic: ", topic);
     
-    // Linear probing da pronadje prazan slot
-    while (topics[index].occupied) {
-        index = (index + 1) % MAX_TOPICS;
-        if (index == originalIndex) {
-            std::cout << "[PubSubEngine] GRESKA: Tabela topic-a je puna!" << std::endl;
-            return nullptr;
+    return entry;
+}
+
+PubSubEngine::TopicEntry* PubSubEngine::getPublishedTopic(const char* topic) {
+    std::lock_guard<std::mutex> lock(engineMutex);
+    return getOrCreateTopic(topic);  // Returns the entry if another thread created it meanwhile
+}
+
+void PubSubEngine::sendLastValue(TopicEntry* entry, const SubscriberAddress& addr) {
+    // Holding the topic's publish lock orders the cached value before any
+    // newer publish on the subscriber's delivery lane
+    std::lock_guard<std::mutex> bufferLock(entry->bufferMutex);
+    
+    Message last;
+    if (!entry->lastValue.load(last)) {
+        return;
+    }
+    
+    LOG_INFO("[PubSubEngine] Slanje poslednje vrednosti za '", entry->topic,
+             "' subscriber-u na portu ", addr.port);
+    dispatchDeliveries(SubscriberSnapshot(1, addr), last, Serialization::encode(last));
+}
+
+void PubSubEngine::collectLastValues(const char* topic, std::vector<Message>& out) {
+    if (!shards.empty()) {
+        if (TopicPattern::hasWildcards(topic)) {
+            for (EngineShard* shard : shards) {
+                shard->collectLastValues(topic, out);
+            }
+        } else {
+            shards[EngineShard::shardOf(topic, (int)shards.size())]->collectLastValues(topic, out);
+        }
+        return;
+    }
+    
+    Message last;
+    
+    if (!TopicPattern::hasWildcards(topic)) {
+        TopicEntry* entry = lookupTopic(topic);
+        if (entry != nullptr && entry->lastValue.load(last)) {
+            out.push_back(last);
+        }
+        return;
+    }
+    
+    std::shared_lock<std::shared_mutex> tableLock(topicsMutex);
+    topics.forEach([&](const char*, TopicEntry*& entry) {
+        if (TopicPattern::matches(topic, entry->topic) && entry->lastValue.load(last)) {
+            out.push_back(last);
+        }
+    });
+}
+
+void PubSubEngine::handleQuery(SOCKET connection, const std::vector<uint8_t>& frame) {
+    char topic[Message::MAX_TOPIC_LEN + 1];
+    if (!EngineShard::readTopic(frame, topic, sizeof(topic))) {
+        return;
+    }
+    
+    std::vector<Message> values;
+    collectLastValues(topic, values);
+    
+    // Reply: [3] [count(2)] { [msg_len(2)] [message] }*, trimmed to one frame
+    std::vector<uint8_t> reply(1, 3);
+    int sent = Serialization::serializeList(values, MAX_FRAME_LENGTH, reply);
+    
+    if (!server.sendTo(connection, reply)) {
+        LOG_WARN("[PubSubEngine] Failed to answer query for '", topic, "'");
+        return;
+    }
+    LOG_INFO("[PubSubEngine] Query '", topic, "': ", sent, " poslednja(ih) vrednost(i)");
+}
+
+bool PubSubEngine::isPeerHost(SOCKET connection, const char* host) {
+    char peer[INET_ADDRSTRLEN];
+    if (!socketAddress(connection, true, peer, sizeof(peer))) {
+        return false;
+    }
+    if (strcmp(host, "localhost") == 0) {
+        return isLoopbackAddress(peer);
+    }
+    return strcmp(host, peer) == 0;
+}
+
+void PubSubEngine::forgetConnection(SOCKET connection) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registrationsByConnection.erase(connection);
+}
+
+void PubSubEngine::handleRegister(SOCKET connection, const std::vector<uint8_t>& frame) {
+    char topic[Message::MAX_TOPIC_LEN];
+    char host[Message::MAX_HOST_LEN];
+    int port = 0;
+    uint32_t id = TopicRegistry::INVALID_ID;
+    
+    if (TopicRegistry::parseRegister(frame, topic, sizeof(topic), host, sizeof(host), port) &&
+        isPeerHost(connection, host)) {
+        std::string publisher = std::string(host) + ":" + std::to_string(port);
+        
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ConnectionRegistrations& budget = registrationsByConnection[connection];
+        if (budget.publisher.empty()) {
+            budget.publisher = publisher;
+        }
+        
+        if (budget.publisher == publisher) {
+            int shard = shards.empty() ? 0 : EngineShard::shardOf(topic, (int)shards.size());
+            bool created;
+            id = topicRegistry.intern(topic, host, port, shard, created,
+                                      budget.created < MAX_IDS_PER_CONNECTION);
+            if (created) {
+                budget.created++;
+            }
+            
+            // Unsharded: resolve the entry now so PUBLISH_ID is a plain index
+            if (created && shards.empty()) {
+                entriesById.push(getPublishedTopic(topic));
+            }
+        }
+    }
+    
+    if (!server.sendTo(connection, TopicRegistry::makeRegisterReply(id))) {
+        LOG_WARN("[PubSubEngine] Failed to answer topic registration");
+        return;
+    }
+    if (id == TopicRegistry::INVALID_ID) {
+        LOG_WARN("[PubSubEngine] Odbijena registracija topic-a");
+    } else {
+        LOG_INFO("[PubSubEngine] Registrovan topic '", topic, "' (", host, ":", port,
+                 ") -> ID ", id);
+    }
+}
+
+void PubSubEngine::countInbound(size_t bytes) {
+    metrics.add(EngineMetrics::FRAMES_IN);
+    metrics.add(EngineMetrics::BYTES_IN, bytes);
+}
+
+void PubSubEngine::handleStats(SOCKET connection, const std::vector<uint8_t>& frame) {
+    // Keyed by connection like replies, so it stays in order with a replay
+    // requested on the same connection
+    int maxTopics = EngineMetrics::parseRequest(frame);
+    replyExecutor.submit((uint64_t)connection, [this, connection, maxTopics]() {
+        EngineMetrics::Snapshot snapshot;
+        getStats(snapshot);
+        std::vector<uint8_t> reply = EngineMetrics::encodeSnapshot(snapshot, maxTopics, MAX_FRAME_LENGTH);
+        if (!server.sendTo(connection, reply)) {
+            LOG_WARN("[PubSubEngine] Failed to answer STATS");
+        }
+    });
+}
+
+void PubSubEngine::getStats(EngineMetrics::Snapshot& out) {
+    out.uptimeMs = metrics.getUptimeMs();
+    metrics.collect(out.counters, out.fanOutLatency);
+    out.topics.clear();
+    out.shards.clear();
+    
+    uint64_t shardQueue = 0;
+    if (!shards.empty()) {
+        for (EngineShard* shard : shards) {
+            EngineMetrics::ShardStats stats;
+            stats.queueDepth = (uint32_t)shard->getQueueDepth();
+            stats.processed = shard->getProcessedCount();
+            shardQueue += stats.queueDepth;
+            out.shards.push_back(stats);
+            shard->collectTopicStats(out.topics);
+        }
+    } else {
+        // Publishes never take engineMutex, so this only holds up (un)subscribes
+        std::lock_guard<std::mutex> lock(engineMutex);
+        topics.forEach([&out](const char*, TopicEntry*& entry) {
+            EngineMetrics::TopicStats stats;
+            stats.topic = entry->topic;
+            stats.messagesIn = entry->messagesIn.load(std::memory_order_relaxed);
+            stats.messagesOut = entry->messagesOut.load(std::memory_order_relaxed);
+            stats.subscribers = (uint32_t)entry->subscribers.size();
+            out.topics.push_back(std::move(stats));
+        });
+    }
+    
+    uint64_t subscriptions = 0;
+    for (const EngineMetrics::TopicStats& t : out.topics) {
+        subscriptions += t.subscribers;
+    }
+    
+    out.gauges.assign(EngineMetrics::GAUGE_COUNT, 0);
+    out.gauges[EngineMetrics::TOPICS] = out.topics.size();
+    out.gauges[EngineMetrics::SUBSCRIPTIONS] = subscriptions;
+    out.gauges[EngineMetrics::DELIVERY_QUEUE] = (uint64_t)std::max(deliveryExecutor.getQueueDepth(), 0);
+    out.gauges[EngineMetrics::DELIVERY_ACTIVE] = (uint64_t)std::max(deliveryExecutor.getActiveWorkers(), 0);
+    out.gauges[EngineMetrics::DELIVERY_WORKERS] = (uint64_t)deliveryExecutor.getWorkerCount();
+    out.gauges[EngineMetrics::SHARD_QUEUE] = shardQueue;
+    out.gauges[EngineMetrics::REGISTERED_IDS] = topicRegistry.size();
+}
+
+void PubSubEngine::rebuildSnapshot(TopicEntry* entry) {
+    SubscriberSnapshot* next = new SubscriberSnapshot();
+    for (auto it = entry->subscribers.begin(); it != entry->subscribers.end(); ++it) {
+        next->push_back(*it);
+    }
+    
+    // Add wildcard subscribers (trie walk, cached per topic), once per subscriber
+    size_t exactCount = next->size();
+    wildcardSubscriptions.match(entry->topic, *next);
+    if (next->size() > exactCount) {
+        SubscriberSnapshot unique;
+        for (const auto& addr : *next) {
+            if (std::find(unique.begin(), unique.end(), addr) == unique.end()) {
+                unique.push_back(addr);
+            }
         }
+        next->swap(unique);
+    }
+    
+    // Publishers still reading the old array keep it until they finish
+    entry->snapshot.publish(next);
+    EpochDomain::instance().reclaim();
+}
+
+void PubSubEngine::rebuildMatchingTopics(const char* pattern) {
+    topics.forEach([this, pattern](const char*, TopicEntry*& entry) {
+        if (TopicPattern::matches(pattern, entry->topic)) {
+            rebuildSnapshot(entry);
+        }
+    });
+}
+
+int PubSubEngine::retentionFor(const char* topic) {
+    std::lock_guard<std::mutex> lock(retentionMutex);
+    auto it = retentionByTopic.find(topic);
+    return it != retentionByTopic.end() ? it->second : defaultRetention;
+}
+
+void PubSubEngine::setDefaultRetention(int depth) {
+    std::lock_guard<std::mutex> lock(retentionMutex);
+    defaultRetention = depth < 1 ? 1 : depth;
+}
+
+void PubSubEngine::setRetention(const char* topic, int depth) {
+    if (depth < 1) {
+        depth = 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(retentionMutex);
+        retentionByTopic[topic] = depth;
+    }
+    
+    if (!shards.empty()) {
+        routeFrame(-1, EngineShard::makeTopicCommand(EngineShard::CMD_SET_RETENTION, depth, topic));
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(engineMutex);
+    TopicEntry* entry = findTopic(topic);
+    if (entry != nullptr) {
+        std::lock_guard<std::mutex> bufferLock(entry->bufferMutex);
+        entry->history.setDepth(depth);
+    }
+}
+
+bool PubSubEngine::handleReplay(int producer, SOCKET connection, const std::vector<uint8_t>& frame) {
+    char topic[Message::MAX_TOPIC_LEN + 1];
+    if (!EngineShard::readTopic(frame, topic, sizeof(topic))) {
+        return true;
     }
     
-    // Inicijalizacija novog topic-a
-    strncpy(topics[index].topic, topic, 63);
-    topics[index].topic[63] = '\0';
-    topics[index].occupied = true;
-    numTopics++;
+    // History is per concrete topic; a pattern gets an empty reply
+    if (TopicPattern::hasWildcards(topic)) {
+        sendReplies(connection, topic, TopicHistory::encodeReplay(std::vector<RetainedMessage>(), MAX_FRAME_LENGTH));
+        return true;
+    }
     
-    std::cout << "[PubSubEngine] Kreiran novi topic: " << topic << std::endl;
+    if (!shards.empty()) {
+        // The shard owning the topic reads its own history and answers
+        return routeFrame(producer, EngineShard::makeReplayCommand((uint64_t)connection, frame));
+    }
     
-    return &topics[index];
+    // Reading and encoding a long history is slow too: do it on the reply pool
+    replyExecutor.submit((uint64_t)connection, [this, connection, frame]() {
+        replayTopic(connection, frame);
+    });
+    return true;
+}
+
+void PubSubEngine::replayTopic(SOCKET connection, const std::vector<uint8_t>& frame) {
+    char topic[Message::MAX_TOPIC_LEN + 1];
+    if (!EngineShard::readTopic(frame, topic, sizeof(topic))) {
+        return;
+    }
+    
+    uint8_t mode = frame[1];
+    uint64_t from = loadLE64(&frame[2]);
+    
+    std::vector<std::vector<uint8_t>> replies;
+    size_t count;
+    if (messageLog != nullptr) {
+        // Straight from the mapped segments, no Message round trip
+        ReplayEncoder encoder(MAX_FRAME_LENGTH);
+        messageLog->scan(topic, mode, from, [&encoder](uint64_t seq, const uint8_t* message, size_t len) {
+            encoder.add(seq, message, len);
+        });
+        count = encoder.getCount();
+        replies = encoder.finish();
+    } else {
+        std::vector<RetainedMessage> retained;
+        TopicEntry* entry = lookupTopic(topic);
+        if (entry != nullptr) {
+            // Copy out under the publish lock, encode and send without it
+            std::lock_guard<std::mutex> bufferLock(entry->bufferMutex);
+            entry->history.collect(mode, from, retained);
+        }
+        count = retained.size();
+        replies = TopicHistory::encodeReplay(retained, MAX_FRAME_LENGTH);
+    }
+    LOG_INFO("[PubSubEngine] Replay '", topic, "': ", count, " poruka u ",
+             replies.size(), " frame-ova");
+    sendReplyFrames(connection, topic, replies);
+}
+
+void PubSubEngine::sendReplies(SOCKET connection, const char* topic, std::vector<std::vector<uint8_t>>&& frames) {
+    replyExecutor.submit((uint64_t)connection, [this, connection, name = std::string(topic), frames = std::move(frames)]() {
+        sendReplyFrames(connection, name.c_str(), frames);
+    });
+}
+
+void PubSubEngine::sendReplyFrames(SOCKET connection, const char* topic, const std::vector<std::vector<uint8_t>>& frames) {
+    for (const auto& frame : frames) {
+        if (!server.sendTo(connection, frame)) {
+            LOG_WARN("[PubSubEngine] Replay for '", topic, "' aborted, connection closed");
+            return;
+        }
+    }
 }
 
 void PubSubEngine::subscribeInternal(const char* topic, int subscriberPort) {
+    if (!shards.empty()) {
+        routeFrame(-1, EngineShard::makeTopicCommand(1, subscriberPort, topic));
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(engineMutex);
     
+    SubscriberAddress addr(subscriberPort);
+    
+    // Wildcard pattern: stored in the segment trie instead of the topic table
+    if (TopicPattern::hasWildcards(topic)) {
+        if (!TopicPattern::isValid(topic)) {
+            LOG_WARN("[PubSubEngine] Neispravan wildcard topic: ", topic);
+            return;
+        }
+        
+        if (wildcardSubscriptions.insert(topic, addr)) {
+            wildcardCount++;
+            rebuildMatchingTopics(topic);
+            LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                     " subscribed to pattern: ", topic);
+        } else {
+            LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                     " already subscribed to pattern: ", topic);
+        }
+        
+        // Warm start: last value of every topic the pattern covers
+        topics.forEach([this, topic, &addr](const char*, TopicEntry*& entry) {
+            if (TopicPattern::matches(topic, entry->topic)) {
+                sendLastValue(entry, addr);
+            }
+        });
+        return;
+    }
+    
     TopicEntry* entry = getOrCreateTopic(topic);
     if (entry == nullptr) {
         return;
     }
     
     // Check if already subscribed
-    SubscriberAddress addr(subscriberPort);
     if (!entry->subscribers.contains(addr)) {
         entry->subscribers.pushBack(addr);
-        std::cout << "[PubSubEngine] Subscriber on port " << subscriberPort 
-                  << " subscribed to topic: " << topic << std::endl;
+        rebuildSnapshot(entry);
+        LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                 " subscribed to topic: ", topic);
     } else {
-        std::cout << "[PubSubEngine] Subscriber on port " << subscriberPort 
-                  << " already subscribed to topic: " << topic << std::endl;
+        LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                 " already subscribed to topic: ", topic);
     }
+    
+    // Warm start: the new subscriber gets the current value right away
+    sendLastValue(entry, addr);
 }
 
 void PubSubEngine::unsubscribeInternal(const char* topic, int subscriberPort) {
+    if (!shards.empty()) {
+        routeFrame(-1, EngineShard::makeTopicCommand(EngineShard::CMD_UNSUBSCRIBE_PORT, subscriberPort, topic));
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(engineMutex);
     
-    int index = findTopicIndex(topic);
-    if (index == -1) {
-        std::cout << "[PubSubEngine] Topic not found: " << topic << std::endl;
+    SubscriberAddress addr(subscriberPort);
+    
+    if (TopicPattern::hasWildcards(topic)) {
+        if (wildcardSubscriptions.remove(topic, addr)) {
+            wildcardCount--;
+            rebuildMatchingTopics(topic);
+            LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                     " unsubscribed from pattern: ", topic);
+        } else {
+            LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                     " was not subscribed to pattern: ", topic);
+        }
         return;
     }
     
-    SubscriberAddress addr(subscriberPort);
-    if (topics[index].subscribers.remove(addr)) {
-        std::cout << "[PubSubEngine] Subscriber on port " << subscriberPort 
-                  << " unsubscribed from topic: " << topic << std::endl;
+    TopicEntry* entry = findTopic(topic);
+    if (entry == nullptr) {
+        LOG_INFO("[PubSubEngine] Topic not found: ", topic);
+        return;
+    }
+    
+    if (entry->subscribers.remove(addr)) {
+        rebuildSnapshot(entry);
+        LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                 " unsubscribed from topic: ", topic);
     } else {
-        std::cout << "[PubSubEngine] Subscriber on port " << subscriberPort 
-                  << " was not subscribed to topic: " << topic << std::endl;
+        LOG_INFO("[PubSubEngine] Subscriber on port ", subscriberPort,
+                 " was not subscribed to topic: ", topic);
     }
 }
 
-void PubSubEngine::deliverToSubscriber(const SubscriberAddress& addr, const Message& msg, const std::vector<uint8_t>& serialized) {
-    // Attempt delivery to a single subscriber in its own thread
-    TcpClient client;
-    if (client.connect("localhost", addr.port)) {
-        if (client.sendMessage(serialized)) {
-            std::cout << "[PubSubEngine:DELIVERY] Message published to topic '" << msg.topic 
-                      << "' -> Subscriber on port " << addr.port << " [SUCCESS]" << std::endl;
-        } else {
-            std::cerr << "[PubSubEngine:DELIVERY] Failed to send to port " << addr.port << std::endl;
-        }
-        client.disconnect();
+void PubSubEngine::deliverToSubscriber(const SubscriberAddress& addr, const Message& msg, const std::vector<uint8_t>& serialized,
+                                       std::chrono::steady_clock::time_point dispatched) {
+    // Reuse the cached connection to this subscriber (reconnects lazily if broken)
+    if (connectionPool.send(addr.port, serialized)) {
+        metrics.add(EngineMetrics::DELIVERIES);
+        metrics.add(EngineMetrics::BYTES_OUT, serialized.size());
+        metrics.recordLatency((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - dispatched).count());
+        LOG_DEBUG("[PubSubEngine:DELIVERY] Message published to topic '", msg.topic,
+                  "' -> Subscriber on port ", addr.port, " [SUCCESS]");
     } else {
-        std::cerr << "[PubSubEngine:DELIVERY] Failed to connect to port " << addr.port << std::endl;
+        metrics.add(EngineMetrics::DELIVERY_FAILURES);
+        LOG_WARN("[PubSubEngine:DELIVERY] Failed to deliver to port ", addr.port);
     }
 }
 
 void PubSubEngine::publish(const Message& msg) {
-    std::lock_guard<std::mutex> lock(engineMutex);
-    
-    int index = findTopicIndex(msg.topic);
-    if (index == -1) {
-        std::cout << "[PubSubEngine] Nema pretplatnika za topic: " << msg.topic << std::endl;
+    if (!shards.empty()) {
+        std::vector<uint8_t> frame(1 + Serialization::encodedSize(msg));
+        frame[0] = 0;
+        Serialization::encode(msg, frame.data() + 1, frame.size() - 1);
+        routeFrame(-1, std::move(frame));
         return;
     }
     
-    TopicEntry& entry = topics[index];
-    
-    // Save message to buffer
-    entry.messageBuffer.push(msg);
-    std::cout << "[PubSubEngine] Message published to topic '" << msg.topic << "'" << std::endl;
-    
-    // Serialize message once
-    std::vector<uint8_t> serialized = Serialization::serialize(msg);
+    publishSerialized(msg, Serialization::encode(msg));
+}
+
+void PubSubEngine::publishSerialized(const Message& msg, std::vector<uint8_t>&& serialized) {
+    TopicEntry* entry = lookupTopic(msg.topic);
+    if (entry == nullptr) {
+        entry = getPublishedTopic(msg.topic);
+    }
     
-    // Get subscriber list snapshot (to avoid holding lock during delivery)
-    std::vector<SubscriberAddress> subscribersCopy;
-    for (auto it = entry.subscribers.begin(); it != entry.subscribers.end(); ++it) {
-        subscribersCopy.push_back(*it);
+    publishToEntry(entry, msg, std::move(serialized));
+}
+
+void PubSubEngine::publishById(const uint8_t* frame, size_t len) {
+    uint32_t id = TopicRegistry::readId(frame, len);
+    const TopicRegistry::Registration* reg = topicRegistry.find(id);
+    TopicEntry* const* entry = entriesById.find(id);
+    if (reg == nullptr || entry == nullptr) {
+        LOG_WARN("[PubSubEngine] Nepoznat ID topic-a: ", id);
+        return;
     }
     
-    int totalSubscribers = subscribersCopy.size();
-    std::cout << "[PubSubEngine] Delivering to " << totalSubscribers << " subscriber(s)..." << std::endl;
+    // Subscribers still get complete messages
+    Message msg;
+    TopicRegistry::decodePublish(frame, *reg, msg);
+    publishToEntry(*entry, msg, Serialization::encode(msg));
+}
+
+void PubSubEngine::publishBatch(const std::vector<uint8_t>& frame) {
+    bool valid = PublishBatcher::forEachEntry(frame.data(), frame.size(), [this](const uint8_t* entry, size_t len) {
+        if (entry[0] == TopicRegistry::CMD_PUBLISH_ID) {
+            publishById(entry, len);
+            return;
+        }
+        MessageView view(entry + 1, len - 1);
+        if (entry[0] == 0 && view.isValid()) {
+            publishSerialized(view.toMessage(), std::vector<uint8_t>(entry + 1, entry + len));
+        }
+    });
+    if (!valid) {
+        LOG_WARN("[PubSubEngine] Neispravan PUBLISH_BATCH frame");
+    }
+}
+
+void PubSubEngine::publishToEntry(TopicEntry* entry, const Message& msg, std::vector<uint8_t>&& serialized) {
+    // Save message to buffer, last-value cache and log (one writer per topic at a time)
+    {
+        std::lock_guard<std::mutex> bufferLock(entry->bufferMutex);
+        uint64_t seq = entry->history.append(msg);
+        entry->lastValue.store(msg);
+        if (messageLog != nullptr && !messageLog->append(msg.topic, seq, serialized.data(), serialized.size())) {
+            LOG_ERROR("[PubSubEngine] Upis u log nije uspeo za topic: ", msg.topic);
+        }
+    }
     
-    // Release lock before spawning delivery threads
-    lock.~lock_guard();
+    // Subscriber list: one atomic load of the current immutable snapshot
+    RcuReadGuard guard;
+    const SubscriberSnapshot* subscribers = entry->snapshot.load();
     
-    // Spawn a thread for each subscriber to deliver in parallel
-    std::vector<std::thread> deliveryThreads;
-    for (const auto& addr : subscribersCopy) {
-        deliveryThreads.emplace_back(&PubSubEngine::deliverToSubscriber, this, addr, msg, serialized);
+    int totalSubscribers = subscribers ? (int)subscribers->size() : 0;
+    metrics.add(EngineMetrics::MESSAGES_IN);
+    entry->messagesIn.fetch_add(1, std::memory_order_relaxed);
+    entry->messagesOut.fetch_add(totalSubscribers, std::memory_order_relaxed);
+    if (totalSubscribers == 0) {
+        metrics.add(EngineMetrics::MESSAGES_NO_SUBSCRIBER);
+        LOG_DEBUG("[PubSubEngine] Nema pretplatnika za topic: ", msg.topic);
+        return;
     }
     
-    // Detach threads to allow publish() to return immediately
-    for (auto& t : deliveryThreads) {
-        if (t.joinable()) {
-            t.detach();
-        }
-    }
+    LOG_DEBUG("[PubSubEngine] Message published to topic '", msg.topic, "'");
+    LOG_DEBUG("[PubSubEngine] Delivering to ", totalSubscribers, " subscriber(s)...");
+    
+    dispatchDeliveries(*subscribers, msg, std::move(serialized));
 }
 
 int PubSubEngine::getSubscriberCount(const char* topic) {
+    if (!shards.empty()) {
+        return shards[EngineShard::shardOf(topic, (int)shards.size())]->getSubscriberCount(topic);
+    }
+    
     std::lock_guard<std::mutex> lock(engineMutex);
     
-    int index = findTopicIndex(topic);
-    if (index == -1) {
+    TopicEntry* entry = findTopic(topic);
+    if (entry == nullptr) {
         return 0;
     }
     
-    return topics[index].subscribers.size();
+    return entry->subscribers.size();
 }
 
 void PubSubEngine::validateSubscribers() {
@@ -277,46 +1059,156 @@ void PubSubEngine::validateSubscribers() {
     while (running && !ConsoleHandler::shouldExit()) {
         std::this_thread::sleep_for(std::chrono::seconds(5));
         
-        std::lock_guard<std::mutex> lock(engineMutex);
+        // Close delivery connections nobody has used for a while
+        int pending = deliveryExecutor.getQueueDepth();
+        if (pending > 0) {
+            LOG_INFO("[PubSubEngine:DELIVERY] Queue depth ", pending, ", active workers ",
+                     deliveryExecutor.getActiveWorkers(), "/",
+                     deliveryExecutor.getWorkerCount());
+        }
         
-        // Check each topic's subscribers
-        for (int i = 0; i < MAX_TOPICS; i++) {
-            if (!topics[i].occupied) continue;
-            
-            std::vector<SubscriberAddress> deadSubscribers;
-            
-            // Test connection to each subscriber
-            for (auto it = topics[i].subscribers.begin(); it != topics[i].subscribers.end(); ++it) {
-                TcpClient testClient;
-                if (!testClient.connect("localhost", it->port)) {
-                    // Subscriber is unreachable
-                    deadSubscribers.push_back(*it);
-                    std::cout << "[PubSubEngine:VALIDATION] Subscriber on port " << it->port 
-                              << " is unreachable for topic '" << topics[i].topic << "'" << std::endl;
-                } else {
-                    testClient.disconnect();
+        int evicted = connectionPool.evictIdle();
+        if (evicted > 0) {
+            LOG_INFO("[PubSubEngine:VALIDATION] Closed ", evicted,
+                     " idle delivery connection(s)");
+        }
+        
+        if (!shards.empty()) {
+            validateShardSubscribers();
+            continue;
+        }
+        
+        // Collect every subscriber port once, then probe without holding the
+        // lock so subscribes are not stalled behind connection attempts
+        std::vector<int> ports;
+        std::vector<std::pair<std::string, SubscriberAddress>> patterns;
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            topics.forEach([&ports](const char*, TopicEntry*& entry) {
+                for (auto it = entry->subscribers.begin(); it != entry->subscribers.end(); ++it) {
+                    ports.push_back(it->port);
                 }
+            });
+            wildcardSubscriptions.getAll(patterns);
+            for (const auto& sub : patterns) {
+                ports.push_back(sub.second.port);
             }
+        }
+        std::sort(ports.begin(), ports.end());
+        ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+        
+        std::vector<int> deadPorts;
+        for (int port : ports) {
+            TcpClient testClient;
+            if (!testClient.connect("localhost", port)) {
+                // Subscriber is unreachable
+                deadPorts.push_back(port);
+                LOG_INFO("[PubSubEngine:VALIDATION] Subscriber on port ", port,
+                         " is unreachable");
+            } else {
+                testClient.disconnect();
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(engineMutex);
+        
+        for (int port : deadPorts) {
+            SubscriberAddress dead(port);
+            connectionPool.remove(port);
             
             // Remove dead subscribers
-            for (const auto& dead : deadSubscribers) {
-                topics[i].subscribers.remove(dead);
-                std::cout << "[PubSubEngine:VALIDATION] Removed unreachable subscriber on port " 
-                          << dead.port << " from topic '" << topics[i].topic << "'" << std::endl;
+            topics.forEach([this, &dead](const char*, TopicEntry*& entry) {
+                if (entry->subscribers.remove(dead)) {
+                    rebuildSnapshot(entry);
+                    LOG_INFO("[PubSubEngine:VALIDATION] Removed unreachable subscriber on port ",
+                             dead.port, " from topic '", entry->topic, "'");
+                }
+            });
+            
+            // Check wildcard subscribers the same way
+            for (const auto& sub : patterns) {
+                if (sub.second == dead && wildcardSubscriptions.remove(sub.first.c_str(), dead)) {
+                    wildcardCount--;
+                    rebuildMatchingTopics(sub.first.c_str());
+                    LOG_INFO("[PubSubEngine:VALIDATION] Removed unreachable subscriber on port ",
+                             dead.port, " from pattern '", sub.first, "'");
+                }
             }
         }
+        
+        // Keep a pending table resize moving in small steps
+        {
+            std::unique_lock<std::shared_mutex> tableLock(topicsMutex);
+            topics.advanceMigration(4096);
+        }
+        
+        // Free subscriber snapshots whose readers have finished
+        EpochDomain::instance().reclaim();
+    }
+}
+
+void PubSubEngine::validateShardSubscribers() {
+    std::vector<int> ports;
+    for (EngineShard* shard : shards) {
+        shard->collectPorts(ports);
+    }
+    std::sort(ports.begin(), ports.end());
+    ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+    
+    for (int port : ports) {
+        TcpClient testClient;
+        if (testClient.connect("localhost", port)) {
+            testClient.disconnect();
+            continue;
+        }
+        
+        LOG_INFO("[PubSubEngine:VALIDATION] Subscriber on port ", port,
+                 " is unreachable");
+        connectionPool.remove(port);
+        
+        // Shards drop the port on their own threads
+        for (EngineShard* shard : shards) {
+            shard->postControl({ EngineShard::CMD_REMOVE_PORT,
+                                 (uint8_t)((port >> 24) & 0xFF), (uint8_t)((port >> 16) & 0xFF),
+                                 (uint8_t)((port >> 8) & 0xFF), (uint8_t)(port & 0xFF) });
+        }
     }
 }
 
 void PubSubEngine::getAllTopics(char topicList[][64], int& count, int maxCount) {
+    if (!shards.empty()) {
+        std::vector<std::string> names;
+        for (EngineShard* shard : shards) {
+            shard->collectTopics(names);
+        }
+        count = 0;
+        for (const std::string& name : names) {
+            if (count >= maxCount) {
+                break;
+            }
+            strncpy(topicList[count], name.c_str(), 63);
+            topicList[count][63] = '\0';
+            count++;
+        }
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(engineMutex);
     
     count = 0;
-    for (int i = 0; i < MAX_TOPICS && count < maxCount; i++) {
-        if (topics[i].occupied) {
-            strncpy(topicList[count], topics[i].topic, 63);
+    topics.forEach([&](const char*, TopicEntry*& entry) {
+        if (count < maxCount) {
+            strncpy(topicList[count], entry->topic, 63);
             topicList[count][63] = '\0';
             count++;
         }
-    }
+    });
+}
+
+int PubSubEngine::getDeliveryQueueDepth() const {
+    return deliveryExecutor.getQueueDepth();
+}
+
+int PubSubEngine::getActiveDeliveryWorkers() const {
+    return deliveryExecutor.getActiveWorkers();
 }
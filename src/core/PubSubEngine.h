@@ -4,70 +4,245 @@
 #include "../Message.h"
 #include "../DataStructures/LinkedList.h"
 #include "../DataStructures/CircularBuffer.h"
+#include "../DataStructures/TopicTrie.h"
+#include "../DataStructures/TopicTable.h"
+#include "../DataStructures/RcuPtr.h"
+#include "../DataStructures/SeqLock.h"
+#include "../DataStructures/StableVector.h"
 #include "../Network.h"
 #include "../Serialization.h"
+#include "SubscriberAddress.h"
+#include "SubscriberConnectionPool.h"
+#include "DeliveryExecutor.h"
+#include "EngineShard.h"
+#include "TopicHistory.h"
+#include "MessageLog.h"
+#include "LogCompactor.h"
+#include "TopicRegistry.h"
+#include "PublishBatcher.h"
+#include "EngineMetrics.h"
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 #include <cstring>
 #include <thread>
+#include <atomic>
+#include <chrono>
 #include <string>
-
-// Structure to hold subscriber network address
-struct SubscriberAddress {
-    int port;
-    
-    SubscriberAddress() : port(0) {}
-    explicit SubscriberAddress(int p) : port(p) {}
-    
-    bool operator==(const SubscriberAddress& other) const {
-        return port == other.port;
-    }
-};
+#include <memory>
+#include <unordered_map>
 
 class PubSubEngine {
 private:
-    // Manual HashMap: topic -> list of subscriber addresses
-    static const int MAX_TOPICS = 100;
-    
     struct TopicEntry {
-        char topic[64];
-        LinkedList<SubscriberAddress> subscribers;  // Store subscriber ports
-        CircularBuffer<Message> messageBuffer;
-        bool occupied;
+        char topic[Message::MAX_TOPIC_LEN + 1];
+        uint64_t hash;                               // TopicTable hash of the topic
+        LinkedList<SubscriberAddress> subscribers;  // Exact subscribers (guarded by engineMutex)
+        RcuPtr<SubscriberSnapshot> snapshot;         // Read by publish without locking
+        std::mutex bufferMutex;                      // Serializes publishes to this topic
+        TopicHistory history;                        // Retained messages with sequence numbers
+        SeqLock<Message> lastValue;                  // Last published message, lock-free reads
+        std::atomic<uint64_t> messagesIn;            // Messages published to the topic
+        std::atomic<uint64_t> messagesOut;           // Deliveries dispatched (one per subscriber)
         
-        TopicEntry() : messageBuffer(50), occupied(false) {
+        explicit TopicEntry(int retention) : hash(0), history(retention), messagesIn(0), messagesOut(0) {
             topic[0] = '\0';
         }
     };
     
-    TopicEntry* topics;
-    int numTopics;
-    std::mutex engineMutex;  // Mutex for thread-safe operations
+    // Growable Robin Hood table: topic -> entry (entries are heap allocated,
+    // so pointers stay valid while the table resizes)
+    TopicTable<TopicEntry*> topics;
+    
+    // Insert-only copy of the table for publish: slots only ever go from
+    // empty to an entry, so a lookup is one epoch enter, one load and a
+    // probe. Growing builds a twice larger index and swaps it in.
+    struct TopicIndex {
+        size_t mask;
+        std::unique_ptr<std::atomic<TopicEntry*>[]> slots;
+        
+        explicit TopicIndex(size_t capacity);
+    };
+    RcuPtr<TopicIndex> topicIndex;
+    TopicTrie<SubscriberAddress> wildcardSubscriptions;  // '+' / '#' patterns
+    std::atomic<int> wildcardCount;                      // Patterns registered
+    
+    // engineMutex serializes writers (subscribe, unsubscribe, validation).
+    // topicsMutex only protects the table structure for readers outside
+    // engineMutex that walk it; writers take it exclusively to insert or
+    // migrate. Publish and replay look topics up in topicIndex instead.
+    std::mutex engineMutex;
+    std::shared_mutex topicsMutex;
     TcpServer server;        // TCP server for receiving connections
+    SubscriberConnectionPool connectionPool; // Persistent connections for delivery
+    DeliveryExecutor deliveryExecutor;       // Bounded pool running deliveries
+    DeliveryExecutor replyExecutor;          // Streams REPLAY frames, keyed by connection
+    static const int REPLY_THREADS = 2;
     std::thread acceptThread; // Thread to accept connections
     std::thread validationThread; // Thread for subscriber health checks
     std::atomic<bool> running;
     
-    // Hash function for topic names
-    int hashTopic(const char* topic) const;
+    // Sharded mode (numShards > 0): topics are owned by shard workers and
+    // every ingest thread routes frames to them through SPSC rings
+    int numShards;
+    std::vector<EngineShard*> shards;
+    
+    // Retention depth per topic (overrides) and for every other topic
+    std::mutex retentionMutex;
+    int defaultRetention;
+    std::unordered_map<std::string, int> retentionByTopic;
+    
+    // Retention depth for a topic about to be created
+    int retentionFor(const char* topic);
+    
+    // Optional write-ahead log (nullptr when disabled); replay reads it
+    // instead of the in-memory history
+    MessageLog* messageLog;
+    LogCompactor* logCompactor;     // Runs while the engine does (nullptr if disabled)
+    
+    // Topic IDs handed out by REGISTER_TOPIC. Unsharded mode resolves an ID
+    // to its entry by index; registryMutex keeps both arrays in step.
+    std::mutex registryMutex;
+    TopicRegistry topicRegistry;
+    StableVector<TopicEntry*> entriesById;
     
-    // Find topic entry index
-    int findTopicIndex(const char* topic) const;
+    // IDs are never freed, so each connection gets a budget: it registers
+    // as the one publisher (host:port) it first claimed, the host must be
+    // the address it connects from, and it creates at most
+    // MAX_IDS_PER_CONNECTION new IDs. Dropped when the connection closes.
+    struct ConnectionRegistrations {
+        std::string publisher;      // "host:port" of the first registration
+        int created;                // New IDs this connection caused
+        
+        ConnectionRegistrations() : created(0) {}
+    };
+    std::unordered_map<SOCKET, ConnectionRegistrations> registrationsByConnection;  // registryMutex
+    static const int MAX_IDS_PER_CONNECTION = 4096;
+    
+    // Per-thread counters and fan-out latency, read by STATS
+    EngineMetrics metrics;
+    
+    // Find topic entry (nullptr if the topic does not exist)
+    TopicEntry* findTopic(const char* topic) const;
     
-    // Get or create topic entry
+    // Same, without any lock: reads topicIndex
+    TopicEntry* lookupTopic(const char* topic) const;
+    
+    // Add a new entry to topicIndex (engineMutex held)
+    void indexTopic(TopicEntry* entry);
+    
+    // Get or create topic entry (engineMutex held)
     TopicEntry* getOrCreateTopic(const char* topic);
     
+    // Entry for a topic seen for the first time on publish, so its last
+    // value is cached even before anyone subscribes
+    TopicEntry* getPublishedTopic(const char* topic);
+    
+    // Send the topic's cached last value (if any) to one subscriber
+    void sendLastValue(TopicEntry* entry, const SubscriberAddress& addr);
+    
+    // Cached last values of a topic or of every topic matching a pattern
+    void collectLastValues(const char* topic, std::vector<Message>& out);
+    
+    // Publish a message together with its serialized form (either protocol
+    // version), which is logged and delivered as is
+    void publishSerialized(const Message& msg, std::vector<uint8_t>&& serialized);
+    
+    // Retain, log and deliver a message to a topic already looked up
+    void publishToEntry(TopicEntry* entry, const Message& msg, std::vector<uint8_t>&& serialized);
+    
+    // PUBLISH_ID: topic comes from the registry, no string lookup
+    void publishById(const uint8_t* frame, size_t len);
+    
+    // PUBLISH_BATCH: publish every entry straight out of the batch frame
+    void publishBatch(const std::vector<uint8_t>& frame);
+    
+    // REGISTER_TOPIC: intern the topic and answer with its ID
+    void handleRegister(SOCKET connection, const std::vector<uint8_t>& frame);
+    
+    // Whether host names the address the connection comes from
+    static bool isPeerHost(SOCKET connection, const char* host);
+    
+    // A client connection closed: forget its registration budget
+    void forgetConnection(SOCKET connection);
+    
+    // QUERY_LAST: reply with the cached last values over the asking connection
+    void handleQuery(SOCKET connection, const std::vector<uint8_t>& frame);
+    
+    // STATS: reply with a binary metrics snapshot. Collecting it walks every
+    // topic under the table locks, so it runs on replyExecutor, off the ingest path.
+    void handleStats(SOCKET connection, const std::vector<uint8_t>& frame);
+    
+    // Count a frame of `bytes` received from a client (any ingest thread)
+    void countInbound(size_t bytes);
+    
+    // Sharded mode: take a frame on reactor ingest thread `ingestIndex`.
+    // False when an owning shard's ring is full; the frame is left intact.
+    bool ingestFrame(int ingestIndex, SOCKET connection, std::vector<uint8_t>&& frame);
+    
+    // REPLAY: stream retained messages back in batched frames
+    // (sharded mode forwards the request to the owning shard; false as for routeFrame)
+    bool handleReplay(int producer, SOCKET connection, const std::vector<uint8_t>& frame);
+    
+    // Stream reply frames to a client from replyExecutor, in order per
+    // connection, so a slow reader holds up neither an ingest thread, a shard
+    // nor subscriber deliveries
+    void sendReplies(SOCKET connection, const char* topic, std::vector<std::vector<uint8_t>>&& frames);
+    
+    // Unsharded REPLAY body, run on replyExecutor: read, encode and send
+    void replayTopic(SOCKET connection, const std::vector<uint8_t>& frame);
+    
+    // Send frames in order; stops (and logs) if the connection is gone
+    void sendReplyFrames(SOCKET connection, const char* topic, const std::vector<std::vector<uint8_t>>& frames);
+    
+    // Build and publish a new subscriber snapshot for the topic (engineMutex held)
+    void rebuildSnapshot(TopicEntry* entry);
+    
+    // Rebuild snapshots of every topic the pattern matches (engineMutex held)
+    void rebuildMatchingTopics(const char* pattern);
+    
     // Accept and handle incoming connections
     void acceptConnections();
     
-    // Deliver message to a single subscriber in a separate thread
-    void deliverToSubscriber(const SubscriberAddress& addr, const Message& msg, const std::vector<uint8_t>& serialized);
+    // Deliver message to a single subscriber over its pooled connection
+    // and record how long it took since the publish was dispatched
+    void deliverToSubscriber(const SubscriberAddress& addr, const Message& msg, const std::vector<uint8_t>& serialized,
+                             std::chrono::steady_clock::time_point dispatched);
     
     // Validate subscriber health (check if reachable)
     void validateSubscribers();
     
+    // Sharded mode: probe the ports every shard knows, tell shards to drop dead ones
+    void validateShardSubscribers();
+    
+    // Sharded mode: hand a frame to the shard(s) owning its topic.
+    // producer is the ingest thread index, or -1 for any other thread.
+    // An ingest thread gets false, with nothing posted and the frame left
+    // intact, when an owning shard's ring is full; other callers wait.
+    bool routeFrame(int producer, std::vector<uint8_t>&& frame);
+    
+    // Sharded mode: forward a PUBLISH_BATCH whole when one shard owns all of
+    // it, otherwise regrouped into one batch per owning shard
+    bool routeBatch(int producer, std::vector<uint8_t>&& frame);
+    
+    // Whether every shard in `owners` (-1 entries ignored) can take a frame
+    // from `producer` now (always true for producer -1)
+    bool shardsHaveRoom(int producer, const std::vector<int>& owners);
+    
+    // Queue a frame on a shard from ingest thread `producer` (-1: control ring)
+    void postToShard(int producer, EngineShard* shard, std::vector<uint8_t>&& frame);
+    
+    // Shard owning a single PUBLISH / PUBLISH_ID frame, -1 if it is malformed
+    int shardOfPublish(const uint8_t* frame, size_t len) const;
+    
+    // Queue one delivery per subscriber on the delivery pool
+    void dispatchDeliveries(const SubscriberSnapshot& subscribers, const Message& msg, std::vector<uint8_t>&& serialized);
+    
 public:
     // Constructor
-    PubSubEngine();
+    // deliveryThreads <= 0 sizes the delivery pool from hardware_concurrency
+    // shards > 0 enables sharded mode with that many topic-owning workers
+    explicit PubSubEngine(int deliveryThreads = 0, int shards = 0);
     
     // Destructor
     ~PubSubEngine();
@@ -79,6 +254,7 @@ public:
     void stop();
     
     // Internal subscribe method (called by network handler)
+    // Topics containing '+' or '#' are registered as wildcard patterns
     void subscribeInternal(const char* topic, int subscriberPort);
     
     // Internal unsubscribe method
@@ -90,8 +266,31 @@ public:
     // Get number of subscribers for a topic
     int getSubscriberCount(const char* topic);
     
+    // Retention depth for topics without their own setting (default 50).
+    // Applies to topics created afterwards.
+    void setDefaultRetention(int depth);
+    
+    // Retention depth for one topic; resizes the buffer if the topic exists
+    void setRetention(const char* topic, int depth);
+    
+    // Persist every published message to a write-ahead log in the given
+    // directory and recover what is already there. Call before start().
+    // With compactBytesPerSecond > 0, old segments are compacted in the
+    // background down to the newest message per topic.
+    bool enableMessageLog(const MessageLog::Options& options, uint64_t compactBytesPerSecond = 0);
+    
     // Get all topics
     void getAllTopics(char topics[][64], int& count, int maxCount);
+    
+    // Deliveries queued but not started yet
+    int getDeliveryQueueDepth() const;
+    
+    // Delivery workers currently sending
+    int getActiveDeliveryWorkers() const;
+    
+    // Counters, gauges, fan-out latency and per-topic statistics
+    // (what STATS returns, with every topic)
+    void getStats(EngineMetrics::Snapshot& out);
 };
 
 #endif // PUBSUB_ENGINE_H
@@ -0,0 +1,107 @@
+#include "PublishBatcher.h"
+
+const uint8_t PublishBatcher::CMD_PUBLISH_BATCH;
+const size_t PublishBatcher::HEADER_BYTES;
+
+PublishBatcher::PublishBatcher(TcpClient& engineClient, size_t max_messages, int lingerMs)
+    : client(engineClient), maxMessages(std::min<size_t>(std::max<size_t>(max_messages, 1), 0xFFFF)),
+      linger(std::max(lingerMs, 0)), count(0), running(false), batchesSent(0), messagesSent(0) {
+    header[0] = CMD_PUBLISH_BATCH;
+    body.reserve(4096);
+}
+
+PublishBatcher::~PublishBatcher() {
+    stop();
+}
+
+void PublishBatcher::start() {
+    if (linger.count() == 0 || running.exchange(true)) {
+        return;
+    }
+    timer = std::thread(&PublishBatcher::run, this);
+}
+
+void PublishBatcher::stop() {
+    if (running.exchange(false)) {
+        pendingCv.notify_all();
+        if (timer.joinable()) {
+            timer.join();
+        }
+    }
+    flush();
+}
+
+bool PublishBatcher::add(const uint8_t* frame, size_t len) {
+    if (len == 0 || len > 0xFFFF) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool ok = true;
+
+    // Start a new batch rather than outgrow the largest frame the engine reads
+    if (count > 0 && HEADER_BYTES + body.size() + 2 + len > MAX_FRAME_LENGTH) {
+        ok = flushLocked();
+    }
+
+    if (count == 0) {
+        oldest = std::chrono::steady_clock::now();
+    }
+    body.push_back((uint8_t)(len & 0xFF));
+    body.push_back((uint8_t)(len >> 8));
+    body.insert(body.end(), frame, frame + len);
+    count++;
+
+    if (count >= maxMessages) {
+        ok = flushLocked() && ok;
+    } else if (count == 1) {
+        pendingCv.notify_one();   // Timer starts counting the linger time
+    }
+    return ok;
+}
+
+bool PublishBatcher::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return flushLocked();
+}
+
+bool PublishBatcher::sendNow(const std::vector<uint8_t>& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool ok = flushLocked();
+    return client.sendMessage(frame) && ok;
+}
+
+bool PublishBatcher::flushLocked() {
+    if (count == 0) {
+        return true;
+    }
+
+    header[1] = (uint8_t)(count & 0xFF);
+    header[2] = (uint8_t)(count >> 8);
+    bool ok = client.sendMessage(header, HEADER_BYTES, body.data(), body.size());
+
+    batchesSent.fetch_add(1, std::memory_order_relaxed);
+    messagesSent.fetch_add(count, std::memory_order_relaxed);
+    body.clear();
+    count = 0;
+    return ok;
+}
+
+void PublishBatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (count == 0) {
+            pendingCv.wait(lock, [this] { return count > 0 || !running; });
+            continue;
+        }
+
+        // Flush once the oldest message has lingered long enough, unless a
+        // size-triggered flush emptied the batch meanwhile
+        auto deadline = oldest + linger;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            flushLocked();
+        } else {
+            pendingCv.wait_until(lock, deadline);
+        }
+    }
+}
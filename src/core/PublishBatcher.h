@@ -0,0 +1,99 @@
+#ifndef PUBLISH_BATCHER_H
+#define PUBLISH_BATCHER_H
+
+#include "../Network.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Client-side batching of publishes into PUBLISH_BATCH frames.
+//
+// PUBLISH_BATCH: [7] [count(2, LE)] { [len(2, LE)] [PUBLISH or PUBLISH_ID frame] }*
+//
+// Publish frames are appended to the pending batch, which goes out as one
+// frame (length prefix, header and body in a single gather write) once it
+// holds maxMessages, would outgrow MAX_FRAME_LENGTH, or the oldest message
+// has waited lingerMs. With lingerMs = 0 only the size limits apply and the
+// caller flushes.
+class PublishBatcher {
+public:
+    static const uint8_t CMD_PUBLISH_BATCH = 7;
+    static const size_t HEADER_BYTES = 3;     // [7][count(2)]
+
+    PublishBatcher(TcpClient& engineClient, size_t maxMessages, int lingerMs);
+    ~PublishBatcher();
+
+    PublishBatcher(const PublishBatcher&) = delete;
+    PublishBatcher& operator=(const PublishBatcher&) = delete;
+
+    // Start the linger timer thread (no-op when lingerMs is 0)
+    void start();
+
+    // Flush what is pending and stop the timer thread
+    void stop();
+
+    // Queue one PUBLISH / PUBLISH_ID frame; false if a send failed
+    bool add(const uint8_t* frame, size_t len);
+
+    // Send the pending batch now
+    bool flush();
+
+    // Flush, then send a frame that is not a publish (e.g. REGISTER_TOPIC)
+    // so it cannot interleave with a batch on the connection
+    bool sendNow(const std::vector<uint8_t>& frame);
+
+    uint64_t getBatchesSent() const { return batchesSent.load(std::memory_order_relaxed); }
+    uint64_t getMessagesSent() const { return messagesSent.load(std::memory_order_relaxed); }
+
+    // Call fn(frame, len) for every publish frame in a PUBLISH_BATCH payload
+    // (the frame includes its command byte). False if the batch is malformed;
+    // entries before the bad one have been visited.
+    template<typename Fn>
+    static bool forEachEntry(const uint8_t* batch, size_t len, Fn fn) {
+        if (len < HEADER_BYTES || batch[0] != CMD_PUBLISH_BATCH) {
+            return false;
+        }
+        size_t count = batch[1] | ((size_t)batch[2] << 8);
+        size_t pos = HEADER_BYTES;
+        for (size_t i = 0; i < count; i++) {
+            if (pos + 2 > len) {
+                return false;
+            }
+            size_t entryLen = batch[pos] | ((size_t)batch[pos + 1] << 8);
+            pos += 2;
+            if (entryLen == 0 || pos + entryLen > len) {
+                return false;
+            }
+            fn(batch + pos, entryLen);
+            pos += entryLen;
+        }
+        return true;
+    }
+
+private:
+    TcpClient& client;
+    size_t maxMessages;
+    std::chrono::milliseconds linger;
+
+    std::mutex mutex;
+    std::condition_variable pendingCv;
+    uint8_t header[HEADER_BYTES];
+    std::vector<uint8_t> body;                       // Entries of the pending batch
+    size_t count;
+    std::chrono::steady_clock::time_point oldest;    // When the first pending entry was added
+
+    std::thread timer;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> batchesSent;
+    std::atomic<uint64_t> messagesSent;
+
+    bool flushLocked();
+    void run();
+};
+
+#endif // PUBLISH_BATCHER_H
@@ -0,0 +1,139 @@
+#include "PublishOutbox.h"
+#include <chrono>
+
+const int PublishOutbox::DRAIN_BATCH;
+const int PublishOutbox::IDLE_SPINS;
+
+PublishOutbox::PublishOutbox(size_t capacity, OverflowPolicy overflowPolicy, SendFn sendFn, FlushFn flushFn)
+    : ring(capacity), policy(overflowPolicy), send(std::move(sendFn)), flush(std::move(flushFn)),
+      running(false), sleeping(false), enqueued(0), sent(0), dropped(0) {
+}
+
+PublishOutbox::~PublishOutbox() {
+    stop();
+}
+
+bool PublishOutbox::parsePolicy(const std::string& name, OverflowPolicy& out) {
+    if (name == "block") {
+        out = OverflowPolicy::BLOCK;
+    } else if (name == "drop-oldest") {
+        out = OverflowPolicy::DROP_OLDEST;
+    } else if (name == "fail") {
+        out = OverflowPolicy::FAIL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void PublishOutbox::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    ioThread = std::thread(&PublishOutbox::run, this);
+}
+
+void PublishOutbox::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    wakeIoThread();
+    if (ioThread.joinable()) {
+        ioThread.join();
+    }
+
+    // Whatever was accepted still goes out
+    while (drain()) {
+    }
+    flush();
+}
+
+bool PublishOutbox::enqueue(uint32_t topicId, const Message& msg) {
+    if (!running.load(std::memory_order_relaxed)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Entry entry;
+    entry.topicId = topicId;
+    entry.msg = msg;
+
+    while (!ring.push(entry)) {
+        if (policy == OverflowPolicy::FAIL || !running.load(std::memory_order_relaxed)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (policy == OverflowPolicy::DROP_OLDEST) {
+            Entry oldest;
+            if (ring.pop(oldest)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        // BLOCK: make sure the I/O thread is draining, then back off
+        wakeIoThread();
+        std::this_thread::yield();
+    }
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in run(): either we see the I/O thread asleep or it sees our entry
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        wakeIoThread();
+    }
+    return true;
+}
+
+void PublishOutbox::wakeIoThread() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    workAvailable.notify_one();
+}
+
+bool PublishOutbox::drain() {
+    Entry entry;
+    int count = 0;
+    while (count < DRAIN_BATCH && ring.pop(entry)) {
+        if (send(entry)) {
+            sent.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        count++;
+    }
+    return count > 0;
+}
+
+void PublishOutbox::run() {
+    int idle = 0;
+    bool unflushed = false;
+
+    while (running) {
+        if (drain()) {
+            idle = 0;
+            unflushed = true;
+            continue;
+        }
+
+        // Ring ran empty: push out the partial batch before waiting
+        if (unflushed) {
+            flush();
+            unflushed = false;
+        }
+
+        if (++idle < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        workAvailable.wait_for(lock, std::chrono::milliseconds(100), [this] {
+            return !ring.isEmpty() || !running;
+        });
+        sleeping.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
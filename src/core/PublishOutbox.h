@@ -0,0 +1,88 @@
+#ifndef PUBLISH_OUTBOX_H
+#define PUBLISH_OUTBOX_H
+
+#include "../Message.h"
+#include "../DataStructures/MpmcRing.h"
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// What publishAsync does when the outbox is full
+enum class OverflowPolicy {
+    BLOCK,          // Wait until the I/O thread frees a slot
+    DROP_OLDEST,    // Evict the oldest queued message to make room
+    FAIL            // Reject the new message
+};
+
+// Bounded queue between publishing threads and one background I/O thread.
+//
+// enqueue() copies the message into a preallocated lock-free ring and
+// returns; it never touches the socket. The I/O thread drains the ring,
+// hands every message to sendFn (which encodes and batches it) and calls
+// flushFn whenever the ring runs empty, so a burst leaves in as few frames
+// as the batcher allows.
+class PublishOutbox {
+public:
+    struct Entry {
+        uint32_t topicId;   // Registered topic ID, or TopicRegistry::INVALID_ID
+        Message msg;
+
+        Entry() : topicId(0) {}
+    };
+
+    using SendFn = std::function<bool(const Entry&)>;
+    using FlushFn = std::function<void()>;
+
+    PublishOutbox(size_t capacity, OverflowPolicy overflowPolicy, SendFn sendFn, FlushFn flushFn);
+    ~PublishOutbox();
+
+    PublishOutbox(const PublishOutbox&) = delete;
+    PublishOutbox& operator=(const PublishOutbox&) = delete;
+
+    void start();
+
+    // Stop the I/O thread; messages still queued are sent from the caller
+    void stop();
+
+    // Any thread. False if the message was rejected (FAIL policy, or the
+    // outbox is stopped).
+    bool enqueue(uint32_t topicId, const Message& msg);
+
+    uint64_t getEnqueuedCount() const { return enqueued.load(std::memory_order_relaxed); }
+    uint64_t getSentCount() const { return sent.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    size_t getDepth() const { return ring.size(); }
+
+    // "block", "drop-oldest" or "fail"
+    static bool parsePolicy(const std::string& name, OverflowPolicy& out);
+
+private:
+    static const int DRAIN_BATCH = 256;     // Messages sent before checking for stop
+    static const int IDLE_SPINS = 100;      // Empty polls before the I/O thread sleeps
+
+    MpmcRing<Entry> ring;
+    OverflowPolicy policy;
+    SendFn send;
+    FlushFn flush;
+
+    std::thread ioThread;
+    std::atomic<bool> running;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::atomic<bool> sleeping;
+
+    std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> sent;
+    std::atomic<uint64_t> dropped;      // Evicted, rejected, or failed to send
+
+    void run();
+    bool drain();
+    void wakeIoThread();
+};
+
+#endif // PUBLISH_OUTBOX_H
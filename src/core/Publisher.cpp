@@ -1,13 +1,14 @@
 #include "Publisher.h"
 #include "../utils/MessageValidator.h"
 #include "../utils/MessageFormatter.h"
-#include <iostream>
+#include "../utils/Logger.h"
 #include <cstring>
 #include <chrono>
 #include <ctime>
 
 Publisher::Publisher(int publisherId, const std::string& engine_host, int engine_port, int port)
-    : id(publisherId), engineHost(engine_host), enginePort(engine_port), running(false) {
+    : id(publisherId), engineHost(engine_host), enginePort(engine_port), running(false), batcher(nullptr),
+      outbox(nullptr), verbose(true) {
     if (port > 0) {
         myPort = port;  // Use provided port
     } else {
@@ -17,19 +18,62 @@ Publisher::Publisher(int publisherId, const std::string& engine_host, int engine
 
 Publisher::~Publisher() {
     stop();
+    delete outbox;
+    delete batcher;
+}
+
+void Publisher::enableBatching(size_t maxMessages, int lingerMs) {
+    if (running) {
+        return;
+    }
+    delete batcher;
+    batcher = maxMessages > 1 ? new PublishBatcher(engineClient, maxMessages, lingerMs) : nullptr;
+}
+
+void Publisher::enableAsync(size_t capacity, OverflowPolicy policy) {
+    if (running) {
+        return;
+    }
+    
+    // The I/O thread flushes whenever the outbox runs empty, so no linger timer is needed
+    if (batcher == nullptr) {
+        batcher = new PublishBatcher(engineClient, 64, 0);
+    }
+    delete outbox;
+    outbox = new PublishOutbox(capacity, policy,
+        [this](const PublishOutbox::Entry& entry) {
+            return encodeAndSend(entry.topicId, entry.msg, asyncBuffer);
+        },
+        [this]() {
+            batcher->flush();
+        });
+}
+
+bool Publisher::open() {
+    if (running) {
+        return true;
+    }
+    
+    // Connect to engine
+    if (!engineClient.connect(engineHost, enginePort)) {
+        LOG_ERROR("[localhost:", myPort, "] Greska: Neuspjesna konekcija na engine");
+        return false;
+    }
+    
+    LOG_INFO("[localhost:", myPort, "] Povezan na engine, sluza na portu ", myPort);
+    
+    running = true;
+    if (batcher != nullptr) {
+        batcher->start();
+    }
+    if (outbox != nullptr) {
+        outbox->start();
+    }
+    return true;
 }
 
 void Publisher::start() {
-    if (!running) {
-        // Connect to engine
-        if (!engineClient.connect(engineHost, enginePort)) {
-            std::cerr << "[localhost:" << myPort << "] Greska: Neuspjesna konekcija na engine" << std::endl;
-            return;
-        }
-        
-        std::cout << "[localhost:" << myPort << "] Povezan na engine, sluza na portu " << myPort << std::endl;
-        
-        running = true;
+    if (!running && open()) {
         workerThread = std::thread(&Publisher::publishLoop, this);
     }
 }
@@ -40,36 +84,114 @@ void Publisher::stop() {
         if (workerThread.joinable()) {
             workerThread.join();
         }
+        if (outbox != nullptr) {
+            outbox->stop();
+            LOG_INFO("[localhost:", myPort, "] Outbox: ", outbox->getEnqueuedCount(), " primljeno, ",
+                     outbox->getSentCount(), " poslato, ", outbox->getDroppedCount(), " odbaceno");
+        }
+        if (batcher != nullptr) {
+            batcher->stop();   // Sends what is still pending
+        }
     }
 }
 
+bool Publisher::sendPublish(const std::vector<uint8_t>& frame) {
+    if (batcher != nullptr) {
+        return batcher->add(frame.data(), frame.size());
+    }
+    return engineClient.sendMessage(frame);
+}
 
 
-void Publisher::publish(const Message& msg) {
+bool Publisher::encodeAndSend(uint32_t topicId, const Message& msg, std::vector<uint8_t>& frame) {
     std::string errorMsg;
     if (!MessageValidator::validate(msg, errorMsg)) {
-        std::cout << "[localhost:" << myPort << "] Validacija poruke nije uspela: " << errorMsg << std::endl;
-        return;
+        LOG_WARN("[localhost:", myPort, "] Validacija poruke nije uspela: ", errorMsg);
+        return false;
     }
     
-    // Serialize message and add command prefix
-    std::vector<uint8_t> message;
-    message.push_back(0); // PUBLISH command
-    
-    std::vector<uint8_t> serialized = Serialization::serialize(msg);
-    message.insert(message.end(), serialized.begin(), serialized.end());
+    if (topicId != TopicRegistry::INVALID_ID) {
+        frame.resize(TopicRegistry::PUBLISH_ID_BYTES);
+        TopicRegistry::encodePublish(topicId, msg, frame.data());
+    } else {
+        // Command prefix + version 2 message, encoded in place
+        frame.resize(1 + Serialization::encodedSize(msg));
+        frame[0] = 0; // PUBLISH command
+        Serialization::encode(msg, frame.data() + 1, frame.size() - 1);
+    }
     
-    if (!engineClient.sendMessage(message)) {
-        std::cerr << "[localhost:" << myPort << "] Failed to send message to engine" << std::endl;
-        return;
+    if (!sendPublish(frame)) {
+        LOG_WARN("[localhost:", myPort, "] Failed to send message to engine");
+        return false;
     }
     
     // Use MessageFormatter for consistent message display
-    std::cout << "[localhost:" << myPort << "] " << MessageFormatter::formatAsString(msg) << std::endl;
+    if (verbose) {
+        LOG_DEBUG("[localhost:", myPort, "] ", MessageFormatter::formatAsString(msg));
+    }
+    return true;
+}
+
+void Publisher::publish(const Message& msg) {
+    encodeAndSend(TopicRegistry::INVALID_ID, msg, sendBuffer);
+}
+
+uint32_t Publisher::registerTopic(const char* topic) {
+    // The engine only takes a host naming the address it sees us connect from
+    std::string host = engineClient.getLocalAddress();
+    if (host.empty() || isLoopbackAddress(host.c_str())) {
+        host = "localhost";
+    }
+    std::vector<uint8_t> request = TopicRegistry::makeRegisterRequest(topic, host.c_str(), myPort);
+    bool sent = batcher != nullptr ? batcher->sendNow(request) : engineClient.sendMessage(request);
+    if (!sent) {
+        return TopicRegistry::INVALID_ID;
+    }
+    
+    // Reply: [5] [id(4)]
+    return TopicRegistry::parseRegisterReply(engineClient.receiveMessage());
+}
+
+void Publisher::publish(uint32_t topicId, const Message& msg) {
+    encodeAndSend(topicId, msg, sendBuffer);
+}
+
+bool Publisher::publishAsync(const Message& msg) {
+    return publishAsync(TopicRegistry::INVALID_ID, msg);
+}
+
+bool Publisher::publishAsync(uint32_t topicId, const Message& msg) {
+    if (outbox == nullptr) {
+        return encodeAndSend(topicId, msg, sendBuffer);
+    }
+    return outbox->enqueue(topicId, msg);
+}
+
+uint64_t Publisher::getEnqueuedCount() const {
+    return outbox != nullptr ? outbox->getEnqueuedCount() : 0;
+}
+
+uint64_t Publisher::getSentCount() const {
+    return outbox != nullptr ? outbox->getSentCount() : 0;
+}
+
+uint64_t Publisher::getDroppedCount() const {
+    return outbox != nullptr ? outbox->getDroppedCount() : 0;
 }
 
 void Publisher::publishLoop() {
-    std::cout << "[localhost:" << myPort << "] Pokrenut thread za objavljivanje" << std::endl;
+    LOG_INFO("[localhost:", myPort, "] Pokrenut thread za objavljivanje");
+    
+    // Register the topics once; frames then carry IDs instead of topic strings
+    const char* topicNames[3] = { "Analog/MER/220", "Status/SWG/1", "Status/CRB/1" };
+    uint32_t topicIds[3];
+    for (int i = 0; i < 3; i++) {
+        topicIds[i] = registerTopic(topicNames[i]);
+        if (topicIds[i] == TopicRegistry::INVALID_ID) {
+            LOG_WARN("[localhost:", myPort, "] Registracija topic-a '", topicNames[i],
+                     "' nije uspela, salje se pun topic");
+        }
+    }
     
     int counter = 0;
     while (running && !ConsoleHandler::shouldExit()) {
@@ -86,31 +208,36 @@ void Publisher::publishLoop() {
         
         if (counter % 3 == 0) {
             // Objavljivanje analog merenja
-            strncpy(msg.topic, "Analog/MER/220", 63);
+            strncpy(msg.topic, topicNames[0], 63);
             msg.type = MessageType::ANALOG;
             msg.topicType = TopicType::MER;
             msg.data.analogValue = 220.5f + (counter % 10) * 0.5f;  // Simulirani napon
         }
         else if (counter % 3 == 1) {
             // Objavljivanje switchgear status-a
-            strncpy(msg.topic, "Status/SWG/1", 63);
+            strncpy(msg.topic, topicNames[1], 63);
             msg.type = MessageType::STATUS;
             msg.topicType = TopicType::SWG;
             msg.data.statusValue = (counter % 2 == 0) ? StatusValue::SWG_CLOSED : StatusValue::SWG_OPEN;
         }
         else {
             // Objavljivanje circuit breaker status-a
-            strncpy(msg.topic, "Status/CRB/1", 63);
+            strncpy(msg.topic, topicNames[2], 63);
             msg.type = MessageType::STATUS;
             msg.topicType = TopicType::CRB;
             msg.data.statusValue = (counter % 2 == 0) ? StatusValue::CRB_CLOSED : StatusValue::CRB_OPEN;
         }
         
-        publish(msg);
+        // Falls back to a full PUBLISH for a topic that failed to register
+        publishAsync(topicIds[counter % 3], msg);
         counter++;
     }
     
-    std::cout << "[localhost:" << myPort << "] Zaustavljen thread za objavljivanje" << std::endl;
+    LOG_INFO("[localhost:", myPort, "] Zaustavljen thread za objavljivanje");
+}
+
+void Publisher::setVerbose(bool enabled) {
+    verbose = enabled;
 }
 
 int Publisher::getId() const {
@@ -4,9 +4,13 @@
 #include "../Message.h"
 #include "../Network.h"
 #include "../Serialization.h"
+#include "TopicRegistry.h"
+#include "PublishBatcher.h"
+#include "PublishOutbox.h"
 #include <thread>
 #include <atomic>
 #include <string>
+#include <vector>
 
 class Publisher {
 private:
@@ -17,10 +21,22 @@ private:
     TcpClient engineClient;           // Client connection to engine
     std::thread workerThread;         // Thread for publishing
     std::atomic<bool> running;        // Flag to control thread
+    std::vector<uint8_t> sendBuffer;  // PUBLISH frame, reused between messages
+    PublishBatcher* batcher;          // Groups publishes into PUBLISH_BATCH frames (nullptr = off)
+    PublishOutbox* outbox;            // Queue drained by a background I/O thread (nullptr = off)
+    std::vector<uint8_t> asyncBuffer; // Frame buffer of the outbox I/O thread
+    bool verbose;                     // Print every sent message
     
     // Worker function that publishes messages
     void publishLoop();
     
+    // Send a publish frame directly or through the batcher
+    bool sendPublish(const std::vector<uint8_t>& frame);
+    
+    // Validate, encode into frame (PUBLISH_ID for a registered topic,
+    // otherwise a full PUBLISH), send and print
+    bool encodeAndSend(uint32_t topicId, const Message& msg, std::vector<uint8_t>& frame);
+    
 public:
     // Constructor
     // If port is 0 or negative, auto-assign from PortPool
@@ -29,15 +45,50 @@ public:
     // Destructor
     ~Publisher();
     
-    // Start publisher thread
+    // Connect and start batching / outbox threads, without the demo
+    // publish loop (for callers that publish themselves)
+    bool open();
+    
+    // Connect and start the demo publish loop
     void start();
     
     // Stop publisher thread
     void stop();
     
+    // Send publishes in PUBLISH_BATCH frames of up to maxMessages, each
+    // going out at most lingerMs after its first message. Call before start().
+    void enableBatching(size_t maxMessages, int lingerMs);
+    
+    // Route publishAsync through an outbox of `capacity` messages drained
+    // by a background I/O thread; batching is turned on for it if it is
+    // not already. Call before start().
+    void enableAsync(size_t capacity, OverflowPolicy policy);
+    
     // Publish a message
     void publish(const Message& msg);
     
+    // Register a topic published from this publisher's host:port and get its
+    // ID (TopicRegistry::INVALID_ID if the engine refused or did not answer)
+    uint32_t registerTopic(const char* topic);
+    
+    // Publish through a registered ID: only the ID and the changing fields
+    // go on the wire (msg.topic is used for validation and display only)
+    void publish(uint32_t topicId, const Message& msg);
+    
+    // Queue a message for the I/O thread and return at once (no socket
+    // call, no output). Returns false if the full-queue policy rejected it.
+    // Without enableAsync() this is the same as publish().
+    bool publishAsync(const Message& msg);
+    bool publishAsync(uint32_t topicId, const Message& msg);
+    
+    // Outbox counters (all 0 without enableAsync())
+    uint64_t getEnqueuedCount() const;
+    uint64_t getSentCount() const;
+    uint64_t getDroppedCount() const;
+    
+    // Print every sent message (default on)
+    void setVerbose(bool enabled);
+    
     // Get publisher ID
     int getId() const;
 };
@@ -1,26 +1,38 @@
 #include "Subscriber.h"
 #include "../utils/MessageValidator.h"
 #include "../utils/MessageFormatter.h"
-#include <iostream>
+#include "../DataStructures/TopicTrie.h"
+#include "../DataStructures/TopicTable.h"
+#include "../DataStructures/SpscRing.h"
+#include "../utils/Logger.h"
 #include <chrono>
 #include <iomanip>
-#include <sstream>
-#include <mutex>
+#include <ostream>
+#include <algorithm>
+#include <cstring>
 
-static std::mutex coutMutex;
+// Wall-clock time printed as HH:MM:SS; logged by value and formatted on the
+// logger's sink thread
+struct LocalTime {
+    std::time_t ts;
+};
 
-static std::string formatTime(std::time_t ts)
+const size_t Subscriber::QUEUE_CAPACITY;
+const size_t Subscriber::MAX_BATCH;
+
+static std::ostream& operator<<(std::ostream& out, LocalTime time)
 {
-    std::stringstream ss;
-    std::tm* tm = std::localtime(&ts);
-    ss << std::put_time(tm, "%H:%M:%S");
-    return ss.str();
+    std::tm* tm = std::localtime(&time.ts);
+    return out << std::put_time(tm, "%H:%M:%S");
 }
 
 Subscriber::Subscriber(int subscriberId, const std::vector<std::string>& sub_topics,
                        const std::string& engine_host, int engine_port, int port) 
     : id(subscriberId), engineHost(engine_host), enginePort(engine_port),
-      topics(sub_topics), messageQueue(50), running(false), messageCount(0) {
+      topics(sub_topics), queueCapacity(QUEUE_CAPACITY), queuePolicy(QueuePolicy::BLOCK),
+      messageQueue(new MpmcRing<Message>(QUEUE_CAPACITY)), consumerWaiting(false), producerWaiting(false), running(false),
+      busyPoll(false), opened(false), workerCount(0), messageCount(0),
+      conflatedGeneration(1), hasConflated(false), droppedTotal(0) {
     if (port > 0) {
         myPort = port;  // Use provided port
     } else {
@@ -32,52 +44,286 @@ Subscriber::~Subscriber() {
     stop();
 }
 
-void Subscriber::start() {
-    if (!running) {
-        // Start own server to receive messages
-        if (!ownServer.start(myPort)) {
-            std::cerr << "[Subscriber " << id << "] Failed to start server on port " << myPort << std::endl;
-            return;
+void Subscriber::setBusyPoll(bool enabled) {
+    busyPoll = enabled;
+}
+
+void Subscriber::setQueueCapacity(size_t capacity) {
+    if (running || opened || capacity == 0) {
+        return;
+    }
+    queueCapacity = capacity;
+    messageQueue.reset(new MpmcRing<Message>(capacity));
+}
+
+void Subscriber::setQueuePolicy(QueuePolicy policy) {
+    if (!running && !opened) {
+        queuePolicy = policy;
+    }
+}
+
+bool Subscriber::parsePolicy(const std::string& name, QueuePolicy& out) {
+    for (QueuePolicy policy : { QueuePolicy::BLOCK, QueuePolicy::DROP_OLDEST,
+                                QueuePolicy::DROP_NEWEST, QueuePolicy::CONFLATE }) {
+        if (name == policyName(policy)) {
+            out = policy;
+            return true;
         }
+    }
+    return false;
+}
+
+const char* Subscriber::policyName(QueuePolicy policy) {
+    switch (policy) {
+        case QueuePolicy::BLOCK: return "block";
+        case QueuePolicy::DROP_OLDEST: return "drop-oldest";
+        case QueuePolicy::DROP_NEWEST: return "drop-newest";
+        case QueuePolicy::CONFLATE: return "conflate";
+    }
+    return "?";
+}
+
+void Subscriber::getDropStats(std::vector<TopicDrops>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    dropCounts.forEach([&out](const char* topic, uint64_t& dropped) {
+        TopicDrops entry;
+        entry.topic = topic;
+        entry.dropped = dropped;
+        out.push_back(entry);
+    });
+    std::sort(out.begin(), out.end(), [](const TopicDrops& a, const TopicDrops& b) {
+        return a.dropped > b.dropped;
+    });
+}
+
+uint64_t Subscriber::getDroppedCount() const {
+    return droppedTotal.load(std::memory_order_relaxed);
+}
+
+void Subscriber::setWorkers(int count) {
+    workerCount = count > 0 ? count : 0;
+}
+
+void Subscriber::pinTopic(const std::string& topic, int worker) {
+    pinnedTopics.emplace_back(topic, worker);
+    if (workerPool) {
+        workerPool->pin(topicKey(topic.data(), topic.size()), worker);
+    }
+}
+
+void Subscriber::getWorkerStats(std::vector<DeliveryExecutor::WorkerStats>& out) {
+    if (workerPool) {
+        workerPool->getWorkerStats(out);
+    } else {
+        out.clear();
+    }
+}
+
+uint64_t Subscriber::topicKey(const char* topic, size_t len) {
+    return TopicTable<int>::hashKey(topic, len);
+}
+
+void Subscriber::startWorkers() {
+    if (workerCount == 0 || workerPool) {
+        return;
+    }
+    workerPool.reset(new DeliveryExecutor(workerCount));
+    workerPool->start();
+    for (const auto& pinned : pinnedTopics) {
+        workerPool->pin(topicKey(pinned.first.data(), pinned.first.size()), pinned.second);
+    }
+}
+
+void Subscriber::stopWorkers() {
+    if (workerPool) {
+        workerPool->stop();
+        workerPool.reset();
+    }
+}
+
+void Subscriber::waitForWorkerCapacity() {
+    // A full pool holds the processing thread back, so the receive queue
+    // fills and its policy applies
+    if (!busyPoll) {
+        workerPool->waitForQueueBelow((int)queueCapacity);
+        return;
+    }
+    while (workerPool->getQueueDepth() >= (int)queueCapacity && opened) {
+        cpuRelax();
+    }
+}
+
+bool Subscriber::open() {
+    if (opened) {
+        return true;
+    }
+    
+    // Start own server to receive messages. Under BLOCK its queue is bounded
+    // too, so a full subscriber stops reading and TCP throttles the engine.
+    ownServer.setMaxQueuedFrames(queuePolicy == QueuePolicy::BLOCK ? (int)queueCapacity : 0);
+    if (!ownServer.start(myPort)) {
+        LOG_ERROR("[Subscriber ", id, "] Failed to start server on port ", myPort);
+        return false;
+    }
+    
+    // Give the server a moment to be fully ready for incoming connections
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    
+    // Connect to engine
+    if (!engineClient.connect(engineHost, enginePort)) {
+        LOG_ERROR("[Subscriber ", id, "] Failed to connect to engine at ",
+                  engineHost, ":", enginePort);
+        ownServer.stop();
+        return false;
+    }
+    
+    // Subscribe to topics by sending subscription messages to engine
+    for (const auto& topic : topics) {
+        sendSubscribe(topic);
+    }
+    
+    opened = true;
+    startWorkers();
+    return true;
+}
+
+void Subscriber::close() {
+    if (!opened) {
+        return;
+    }
+    opened = false;
+    
+    // Unsubscribe from all topics
+    for (const auto& topic : topics) {
+        std::vector<uint8_t> unsubMsg;
+        unsubMsg.push_back(2); // UNSUBSCRIBE command
         
-        // Give the server a moment to be fully ready for incoming connections
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        
-        // Connect to engine
-        if (!engineClient.connect(engineHost, enginePort)) {
-            std::cerr << "[Subscriber " << id << "] Failed to connect to engine at " 
-                      << engineHost << ":" << enginePort << std::endl;
-            return;
+        // Topic
+        unsubMsg.push_back(topic.length());
+        for (char c : topic) {
+            unsubMsg.push_back(c);
         }
         
-        // Subscribe to topics by sending subscription messages to engine
-        for (const auto& topic : topics) {
-            // Create a simple subscription message format: [command_type(1)] [port(4)] [topic_len(1)] [topic]
-            std::vector<uint8_t> subMsg;
-            subMsg.push_back(1); // SUBSCRIBE command
-            
-            // Port in big-endian
-            uint32_t port_val = myPort;
-            subMsg.push_back((port_val >> 24) & 0xFF);
-            subMsg.push_back((port_val >> 16) & 0xFF);
-            subMsg.push_back((port_val >> 8) & 0xFF);
-            subMsg.push_back(port_val & 0xFF);
-            
-            // Topic
-            subMsg.push_back(topic.length());
-            for (char c : topic) {
-                subMsg.push_back(c);
+        engineClient.sendMessage(unsubMsg);
+    }
+    
+    engineClient.disconnect();
+    ownServer.stop();
+    stopWorkers();
+}
+
+bool Subscriber::sendSubscribe(const std::string& topic) {
+    // Create a simple subscription message format: [command_type(1)] [port(4)] [topic_len(1)] [topic]
+    std::vector<uint8_t> subMsg;
+    subMsg.push_back(1); // SUBSCRIBE command
+    
+    // Port in big-endian
+    uint32_t port_val = myPort;
+    subMsg.push_back((port_val >> 24) & 0xFF);
+    subMsg.push_back((port_val >> 16) & 0xFF);
+    subMsg.push_back((port_val >> 8) & 0xFF);
+    subMsg.push_back(port_val & 0xFF);
+    
+    // Topic
+    subMsg.push_back(topic.length());
+    for (char c : topic) {
+        subMsg.push_back(c);
+    }
+    
+    if (!engineClient.sendMessage(subMsg)) {
+        LOG_WARN("[Subscriber ", id, "] Failed to subscribe to topic: ", topic);
+        return false;
+    }
+    return true;
+}
+
+void Subscriber::onMessage(const std::string& topic, MessageHandler handler) {
+    handlers.emplace_back(topic, std::move(handler));
+    
+    if (std::find(topics.begin(), topics.end(), topic) == topics.end()) {
+        topics.push_back(topic);
+        if (opened) {
+            sendSubscribe(topic);
+        }
+    }
+}
+
+void Subscriber::onBatch(BatchHandler handler) {
+    batchHandler = std::move(handler);
+}
+
+int Subscriber::poll(int timeoutMs) {
+    if (!opened) {
+        return -1;
+    }
+    
+    // Take what has already arrived, waiting only for the first frame
+    batchFrames.clear();
+    std::vector<uint8_t> frame = timeoutMs > 0 ? ownServer.receiveMessage(timeoutMs) : ownServer.pollMessage();
+    while (!frame.empty()) {
+        batchFrames.push_back(std::move(frame));
+        if (batchFrames.size() >= MAX_BATCH) {
+            break;
+        }
+        frame = ownServer.pollMessage();
+    }
+    
+    // Views read the fields straight out of the received frames
+    batchViews.clear();
+    for (const auto& received : batchFrames) {
+        MessageView view(received.data(), received.size());
+        if (!view.isValid()) {
+            LOG_WARN("[Subscriber ", id, "] Neispravan frame (", received.size(), " B) odbacen");
+            continue;
+        }
+        batchViews.push_back(view);
+    }
+    if (batchViews.empty()) {
+        return 0;
+    }
+    
+    if (batchHandler) {
+        batchHandler(batchViews.data(), batchViews.size());
+    }
+    if (!handlers.empty()) {
+        if (workerPool) {
+            // Hand each frame to its topic's worker; the task owns the frame
+            for (auto& received : batchFrames) {
+                MessageView view(received.data(), received.size());
+                if (!view.isValid()) {
+                    continue;
+                }
+                waitForWorkerCapacity();
+                std::string_view topic = view.topic();
+                workerPool->submit(topicKey(topic.data(), topic.size()), [this, frame = std::move(received)]() {
+                    dispatchView(MessageView(frame.data(), frame.size()));
+                });
             }
-            
-            if (!engineClient.sendMessage(subMsg)) {
-                std::cerr << "[Subscriber " << id << "] Failed to subscribe to topic: " << topic << std::endl;
+        } else {
+            for (const MessageView& view : batchViews) {
+                dispatchView(view);
             }
         }
-        
-        {
-            std::lock_guard<std::mutex> lock(coutMutex);
-            std::cout << "[Subscriber " << id << "] STARTED on port " << myPort << "\n";
+    }
+    
+    messageCount += (int)batchViews.size();
+    return (int)batchViews.size();
+}
+
+void Subscriber::dispatchView(const MessageView& view) {
+    std::string_view topic = view.topic();
+    for (const auto& entry : handlers) {
+        if (entry.first == topic || TopicPattern::matches(entry.first.c_str(), topic)) {
+            entry.second(view);
         }
+    }
+}
+
+void Subscriber::start() {
+    if (!running && open()) {
+        LOG_INFO("[Subscriber ", id, "] STARTED on port ", myPort, " | red ", queueCapacity,
+                 " poruka, politika ", policyName(queuePolicy));
         
         running = true;
         receivingThread = std::thread(&Subscriber::receiveLoop, this);
@@ -88,25 +334,13 @@ void Subscriber::start() {
 void Subscriber::stop() {
     if (running) {
         running = false;
-        queueCV.notify_all();
-        
-        // Unsubscribe from all topics
-        for (const auto& topic : topics) {
-            std::vector<uint8_t> unsubMsg;
-            unsubMsg.push_back(2); // UNSUBSCRIBE command
-            
-            // Topic
-            unsubMsg.push_back(topic.length());
-            for (char c : topic) {
-                unsubMsg.push_back(c);
-            }
-            
-            engineClient.sendMessage(unsubMsg);
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
         }
+        queueCV.notify_all();
+        spaceCV.notify_all();
         
-        engineClient.disconnect();
-        ownServer.stop();
-
+        // Both threads notice !running within one receive timeout
         if (receivingThread.joinable()) {
             receivingThread.join();
         }
@@ -115,109 +349,301 @@ void Subscriber::stop() {
             processingThread.join();
         }
 
-        std::lock_guard<std::mutex> lock(coutMutex);
-        std::cout << "[Subscriber " << id << "] STOPPED | ukupno poruka: "
-                  << messageCount << "\n";
+        logWorkerStats();
+        logDropStats();
+        close();
+        LOG_INFO("[Subscriber ", id, "] STOPPED | ukupno poruka: ", messageCount.load(),
+                 " | odbaceno: ", droppedTotal.load());
+    } else {
+        close();
+    }
+}
+
+int Subscriber::queryLastValues(const std::string& topic, std::vector<Message>& out) {
+    // Query message format: [command_type(1)] [topic_len(1)] [topic]
+    std::vector<uint8_t> query;
+    query.push_back(3); // QUERY_LAST command
+    query.push_back(topic.length());
+    for (char c : topic) {
+        query.push_back(c);
+    }
+    
+    if (!engineClient.sendMessage(query)) {
+        return -1;
+    }
+    
+    // Reply: [3] [count(2)] { [msg_len(2)] [message] }*
+    std::vector<uint8_t> reply = engineClient.receiveMessage();
+    if (reply.empty() || reply[0] != 3) {
+        return -1;
+    }
+    
+    size_t before = out.size();
+    if (!Serialization::deserializeList(reply.data() + 1, reply.size() - 1, out)) {
+        return -1;
+    }
+    return (int)(out.size() - before);
+}
+
+int Subscriber::replayHistory(const std::string& topic, uint8_t mode, uint64_t from, std::vector<RetainedMessage>& out) {
+    if (!engineClient.sendMessage(TopicHistory::makeRequest(topic.c_str(), mode, from))) {
+        return -1;
+    }
+    
+    // Large histories arrive in several frames; the last one is flagged
+    size_t before = out.size();
+    bool last = false;
+    while (!last) {
+        std::vector<uint8_t> reply = engineClient.receiveMessage();
+        if (reply.empty() || !TopicHistory::decodeReplay(reply, out, last)) {
+            return -1;
+        }
     }
+    return (int)(out.size() - before);
 }
 
 void Subscriber::receiveLoop() {
     while (running && !ConsoleHandler::shouldExit()) {
-        std::vector<uint8_t> serialized = ownServer.receiveMessage();
+        // receiveMessage() already blocks until a frame arrives (or 100 ms pass)
+        std::vector<uint8_t> serialized = busyPoll ? ownServer.pollMessage() : ownServer.receiveMessage();
         
         if (serialized.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (busyPoll) {
+                cpuRelax();
+            }
             continue;
         }
         
         // Deserialize message
         Message msg = Serialization::deserialize(serialized.data(), serialized.size());
+        if (!enqueue(msg)) {
+            return;
+        }
         
-        // Push to queue
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            messageQueue.push(msg);
+        // Pairs with the fence in waitForMessage(): either the consumer sees
+        // the message before parking or we see it waiting and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            queueCV.notify_one();
         }
-        queueCV.notify_one();
     }
 }
 
-void Subscriber::processMessages() {
+bool Subscriber::enqueue(const Message& msg) {
+    // Once something is parked, newer messages of every topic go behind it
+    // so each topic stays in order
+    if (queuePolicy == QueuePolicy::CONFLATE && hasConflated.load(std::memory_order_acquire)) {
+        conflate(msg);
+        return true;
+    }
+    
+    while (!messageQueue->push(msg)) {
+        switch (queuePolicy) {
+            case QueuePolicy::DROP_NEWEST:
+                countDrop(msg.topic);
+                return true;
+            
+            case QueuePolicy::DROP_OLDEST: {
+                Message oldest;
+                if (messageQueue->pop(oldest)) {
+                    countDrop(oldest.topic);
+                }
+                continue;
+            }
+            
+            case QueuePolicy::CONFLATE:
+                conflate(msg);
+                return true;
+            
+            case QueuePolicy::BLOCK:
+                break;
+        }
+        
+        // BLOCK: the socket's queue fills behind us and TCP pushes back on the engine
+        if (!running || ConsoleHandler::shouldExit()) {
+            return false;
+        }
+        if (busyPoll) {
+            cpuRelax();
+        } else {
+            waitForSpace();
+        }
+    }
+    return true;
+}
 
-    while (running && !ConsoleHandler::shouldExit()) {
+void Subscriber::conflate(const Message& msg) {
+    {
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        
+        ConflatedSlot fresh = { conflatedGeneration, conflated.size() };
+        bool inserted = false;
+        ConflatedSlot* slot = conflatedIndex.insert(msg.topic, fresh, &inserted);
+        if (inserted || slot->generation != conflatedGeneration) {
+            *slot = fresh;
+            conflated.push_back(msg);
+            hasConflated.store(true, std::memory_order_release);
+            return;
+        }
+        
+        // Its topic's previous value has not been processed yet: replace it
+        conflated[slot->index] = msg;
+    }
+    countDrop(msg.topic);
+}
 
-        Message msg;
-        bool hasMessage = false;
+bool Subscriber::takeConflated(std::vector<Message>& out) {
+    out.clear();
+    if (!hasConflated.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    out.swap(conflated);
+    conflatedGeneration++;  // Invalidates every slot in conflatedIndex
+    hasConflated.store(false, std::memory_order_release);
+    return !out.empty();
+}
 
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCV.wait_for(lock,
-                std::chrono::milliseconds(100),
-                [this] {
-                    return !messageQueue.isEmpty() || !running;
-                });
+void Subscriber::countDrop(const char* topic) {
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    uint64_t* dropped = dropCounts.insert(topic, 0);
+    (*dropped)++;
+    droppedTotal.fetch_add(1, std::memory_order_relaxed);
+}
 
-            if (!running || ConsoleHandler::shouldExit()) break;
+void Subscriber::waitForMessage() {
+    std::unique_lock<std::mutex> lock(waitMutex);
+    consumerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    queueCV.wait_for(lock, std::chrono::milliseconds(100), [this] {
+        return !messageQueue->isEmpty() || hasConflated.load(std::memory_order_acquire) || !running;
+    });
+    consumerWaiting.store(false, std::memory_order_relaxed);
+}
 
-            hasMessage = messageQueue.pop(msg);
-        }
+void Subscriber::waitForSpace() {
+    std::unique_lock<std::mutex> lock(waitMutex);
+    producerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    spaceCV.wait_for(lock, std::chrono::milliseconds(100), [this] {
+        return messageQueue->size() < messageQueue->getCapacity() || !running;
+    });
+    producerWaiting.store(false, std::memory_order_relaxed);
+}
 
-        if (!hasMessage)
-            continue;
+void Subscriber::processMessages() {
+    std::vector<Message> parked;
 
-        std::string errorMsg;
-        if (!MessageValidator::validate(msg, errorMsg)) {
+    while (running && !ConsoleHandler::shouldExit()) {
 
-            std::lock_guard<std::mutex> lock(coutMutex);
-            std::cout << "[Subscriber " << id
-                      << "] VALIDACIJA NIJE USPESNA: " << errorMsg << "\n";
+        Message msg;
+        if (!messageQueue->pop(msg)) {
+            // Conflated messages arrived after everything that was queued
+            if (takeConflated(parked)) {
+                for (const Message& latest : parked) {
+                    processMessage(latest);
+                }
+                continue;
+            }
+            if (busyPoll) {
+                cpuRelax();
+            } else {
+                waitForMessage();
+            }
             continue;
         }
 
-        // Check if message topic is in subscribed topics
-        bool topicMatch = false;
-        for (const auto& topic : topics) {
-            if (topic == msg.topic) {
-                topicMatch = true;
-                break;
-            }
-        }
-        
-        if (!topicMatch) {
-            // Skip messages not matching subscribed topics
-            continue;
+        // Pairs with the fence in waitForSpace(): either the receiver sees
+        // the room before parking or we see it waiting and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            spaceCV.notify_one();
         }
 
-        messageCount++;
+        processMessage(msg);
+    }
+}
 
-        std::lock_guard<std::mutex> lock(coutMutex);
+void Subscriber::processMessage(const Message& msg) {
+    if (!workerPool) {
+        handleMessage(msg);
+        return;
+    }
+    // Messages of one topic stay in order on their worker
+    waitForWorkerCapacity();
+    workerPool->submit(topicKey(msg.topic, strnlen(msg.topic, Message::MAX_TOPIC_LEN)), [this, msg]() {
+        handleMessage(msg);
+    });
+}
 
-        std::cout << "\n--------------------------------------\n";
-        std::cout << "PUBLISHER: " << msg.publisher_host
-                  << ":" << msg.publisher_port
-                  << " | PORUKA #" << messageCount
-                  << " | " << formatTime(msg.timestamp) << "\n";
+void Subscriber::handleMessage(const Message& msg) {
+    std::string errorMsg;
+    if (!MessageValidator::validate(msg, errorMsg)) {
+        LOG_WARN("[Subscriber ", id, "] VALIDACIJA NIJE USPESNA: ", errorMsg);
+        return;
+    }
 
-        std::cout << "Topic: " << msg.topic << "\n";
+    // Check if message topic is in subscribed topics (patterns may use '+' / '#')
+    bool topicMatch = false;
+    for (const auto& topic : topics) {
+        if (topic == msg.topic || TopicPattern::matches(topic.c_str(), msg.topic)) {
+            topicMatch = true;
+            break;
+        }
+    }
+    
+    if (!topicMatch) {
+        // Skip messages not matching subscribed topics
+        return;
+    }
 
-        if (msg.type == MessageType::ANALOG) {
+    int number = messageCount.fetch_add(1) + 1;
 
-            std::cout << "Tip: ANALOG\n";
-            std::cout << "Vrednost: "
-                      << msg.data.analogValue << "\n";
-        }
-        else {
+    // One record per message so lines from other threads cannot interleave
+    if (msg.type == MessageType::ANALOG) {
+        LOG_INFO("\n--------------------------------------\n",
+                 "PUBLISHER: ", msg.publisher_host, ":", msg.publisher_port,
+                 " | PORUKA #", number, " | ", LocalTime{ msg.timestamp }, "\n",
+                 "Topic: ", msg.topic, "\n",
+                 "Tip: ANALOG\n",
+                 "Vrednost: ", msg.data.analogValue, "\n",
+                 "--------------------------------------");
+    }
+    else {
 
-            const char* statusStr =
-                (msg.data.statusValue == StatusValue::SWG_OPEN ||
-                 msg.data.statusValue == StatusValue::CRB_OPEN)
-                ? "OPEN" : "CLOSED";
+        const char* statusStr =
+            (msg.data.statusValue == StatusValue::SWG_OPEN ||
+             msg.data.statusValue == StatusValue::CRB_OPEN)
+            ? "OPEN" : "CLOSED";
 
-            std::cout << "Tip: STATUS\n";
-            std::cout << "Stanje: " << statusStr << "\n";
-        }
+        LOG_INFO("\n--------------------------------------\n",
+                 "PUBLISHER: ", msg.publisher_host, ":", msg.publisher_port,
+                 " | PORUKA #", number, " | ", LocalTime{ msg.timestamp }, "\n",
+                 "Topic: ", msg.topic, "\n",
+                 "Tip: STATUS\n",
+                 "Stanje: ", statusStr, "\n",
+                 "--------------------------------------");
+    }
+}
+
+void Subscriber::logWorkerStats() {
+    std::vector<DeliveryExecutor::WorkerStats> stats;
+    getWorkerStats(stats);
+    for (size_t i = 0; i < stats.size(); i++) {
+        LOG_INFO("[Subscriber ", id, "] Worker ", i, ": ", stats[i].tasksRun, " poruka, ",
+                 stats[i].lanesStolen, " preuzetih topic-a, lag ", stats[i].lastLagUs,
+                 " us (max ", stats[i].maxLagUs, " us)");
+    }
+}
 
-        std::cout << "--------------------------------------\n";
+void Subscriber::logDropStats() {
+    std::vector<TopicDrops> drops;
+    getDropStats(drops);
+    for (const TopicDrops& entry : drops) {
+        LOG_WARN("[Subscriber ", id, "] Topic ", entry.topic, ": ", entry.dropped,
+                 " poruka odbaceno (", policyName(queuePolicy), ")");
     }
 }
 
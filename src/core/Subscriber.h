@@ -2,17 +2,65 @@
 #define SUBSCRIBER_H
 
 #include "../Message.h"
-#include "../DataStructures/CircularBuffer.h"
+#include "../DataStructures/MpmcRing.h"
+#include "../DataStructures/TopicTable.h"
 #include "../Network.h"
 #include "../Serialization.h"
+#include "../MessageView.h"
+#include "TopicHistory.h"
+#include "DeliveryExecutor.h"
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <vector>
 #include <string>
+#include <utility>
+#include <functional>
+#include <memory>
 
+// Receives the messages of its topics from the engine.
+//
+// Two ways to consume them:
+//  - start()/stop(): a receive and a processing thread validate and print
+//    every message (the --subscriber console mode).
+//  - Embedded: register callbacks with onMessage()/onBatch(), call open(),
+//    then drive poll() from the application's own loop. Callbacks run on
+//    the thread calling poll() and get MessageViews over the received
+//    frames, so nothing is deserialized, queued or formatted on the way.
+// Use one or the other on a given instance.
+//
+// With setWorkers(n) either mode processes messages on a pool of n threads
+// instead: messages are keyed by topic, so one topic's messages run in
+// order on one worker while other topics proceed in parallel, and a slow
+// handler only holds up its own topic.
+//
+// When processing falls behind, the queue policy decides what gives: the
+// receiver waits (and the engine with it, through TCP), or messages are
+// dropped or conflated and counted per topic.
 class Subscriber {
+public:
+    static const size_t QUEUE_CAPACITY = 1024;  // Default received messages waiting for processing
+    static const size_t MAX_BATCH = 64;         // Messages dispatched per poll()
+    
+    // What receiving does when the queue is full
+    enum class QueuePolicy {
+        BLOCK,          // Wait for room; the engine is throttled by TCP flow control
+        DROP_OLDEST,    // Discard the oldest queued message to make room
+        DROP_NEWEST,    // Discard the message just received
+        CONFLATE        // Keep only the latest message of each topic until processing catches up
+    };
+    
+    struct TopicDrops {
+        std::string topic;
+        uint64_t dropped = 0;           // Discarded, or replaced by a newer value (CONFLATE)
+    };
+    
+    // The view (and the buffer under it) is only valid during the call
+    using MessageHandler = std::function<void(const MessageView& msg)>;
+    // Every message of one poll(), in arrival order
+    using BatchHandler = std::function<void(const MessageView* msgs, size_t count)>;
+    
 private:
     int id;                                    // Subscriber ID
     int myPort;                                // Assigned port for this subscriber
@@ -20,17 +68,47 @@ private:
     int enginePort;                            // Engine port
     std::vector<std::string> topics;           // Topics to subscribe to
     
-    CircularBuffer<Message> messageQueue;      // Queue for received messages
+    size_t queueCapacity;                      // See setQueueCapacity
+    QueuePolicy queuePolicy;
+    // receiveLoop -> processMessages; multi-consumer so the receiver can evict (DROP_OLDEST)
+    std::unique_ptr<MpmcRing<Message>> messageQueue;
     TcpClient engineClient;                    // Client to connect to engine
     TcpServer ownServer;                       // Server to receive messages from engine
     
     std::thread processingThread;              // Thread for processing messages
     std::thread receivingThread;               // Thread for receiving messages
-    std::mutex queueMutex;                     // Mutex for queue access
-    std::condition_variable queueCV;           // Condition variable for queue
+    std::mutex waitMutex;                      // Only taken to park / wake the processing thread
+    std::condition_variable queueCV;           // Signalled when a message arrives for a parked consumer
+    std::atomic<bool> consumerWaiting;         // Processing thread is (about to be) parked on queueCV
+    std::condition_variable spaceCV;           // Signalled when a message is taken for a parked receiver
+    std::atomic<bool> producerWaiting;         // Receive thread is (about to be) parked on spaceCV (BLOCK)
     std::atomic<bool> running;                 // Flag to control threads
+    bool busyPoll;                             // Spin instead of blocking (see setBusyPoll)
+    bool opened;                               // Server started, connected and subscribed
+    
+    std::vector<std::pair<std::string, MessageHandler>> handlers;  // Topic or pattern -> callback
+    BatchHandler batchHandler;
+    std::vector<std::vector<uint8_t>> batchFrames;  // Frames of the current poll()
+    std::vector<MessageView> batchViews;            // Views over batchFrames
+    
+    int workerCount;                                // 0 = no pool (see setWorkers)
+    std::unique_ptr<DeliveryExecutor> workerPool;   // Keyed by topic hash while open
+    std::vector<std::pair<std::string, int>> pinnedTopics;
 
-    int messageCount;
+    std::atomic<int> messageCount;
+    
+    // Overflow bookkeeping, only touched once the queue has been full
+    struct ConflatedSlot {
+        uint64_t generation;        // Valid if equal to conflatedGeneration
+        size_t index;               // Into conflated
+    };
+    std::mutex overflowMutex;
+    TopicTable<uint64_t> dropCounts;           // Topic -> dropped messages
+    TopicTable<ConflatedSlot> conflatedIndex;  // Topic -> its message waiting in conflated
+    std::vector<Message> conflated;            // Latest message per topic, behind the queue
+    uint64_t conflatedGeneration;              // Bumped whenever conflated is taken
+    std::atomic<bool> hasConflated;            // conflated is not empty
+    std::atomic<uint64_t> droppedTotal;
     
     // Worker function that processes messages
     void processMessages();
@@ -38,6 +116,42 @@ private:
     // Worker function that receives messages from engine
     void receiveLoop();
     
+    // Park the processing thread until a message is queued (or ~100 ms pass)
+    void waitForMessage();
+    
+    // BLOCK: park the receive thread until the queue has room (or ~100 ms pass)
+    void waitForSpace();
+    
+    // Queue one received message as the policy says. False once stopping.
+    bool enqueue(const Message& msg);
+    
+    // CONFLATE: park msg behind the queue, replacing its topic's older value
+    void conflate(const Message& msg);
+    
+    // Take the messages parked by conflate(), in the order their topics arrived
+    bool takeConflated(std::vector<Message>& out);
+    
+    void countDrop(const char* topic);
+    void logDropStats();
+    
+    // Send SUB for one topic or pattern
+    bool sendSubscribe(const std::string& topic);
+    
+    // Handle a dequeued message here, or hand it to its topic's worker
+    void processMessage(const Message& msg);
+    
+    // Validate, filter and print one message (console mode)
+    void handleMessage(const Message& msg);
+    
+    // Run the callbacks registered for the view's topic
+    void dispatchView(const MessageView& view);
+    
+    static uint64_t topicKey(const char* topic, size_t len);
+    void startWorkers();
+    void stopWorkers();
+    void waitForWorkerCapacity();
+    void logWorkerStats();
+    
 public:
     // Constructor
     // If port is 0 or negative, auto-assign from PortPool
@@ -47,6 +161,44 @@ public:
     // Destructor
     ~Subscriber();
     
+    // Busy-poll mode (call before start): both threads spin on their queues
+    // with a pause hint instead of blocking, which cuts wake-up latency to
+    // microseconds at the cost of two fully busy cores. Default: blocking.
+    void setBusyPoll(bool enabled);
+    
+    // Messages queued between receiving and processing (call before start;
+    // default QUEUE_CAPACITY). With BLOCK the socket's queue is held to the
+    // same size, which also applies to open()/poll().
+    void setQueueCapacity(size_t capacity);
+    
+    // Full queue policy (call before start; default BLOCK). The drop and
+    // conflate policies apply to start()/stop() mode; poll() reads the
+    // socket's queue directly.
+    void setQueuePolicy(QueuePolicy policy);
+    
+    // Messages dropped or conflated per topic so far (topics without drops
+    // are left out), and their total
+    void getDropStats(std::vector<TopicDrops>& out);
+    uint64_t getDroppedCount() const;
+    
+    // "block", "drop-oldest", "drop-newest" or "conflate"
+    static bool parsePolicy(const std::string& name, QueuePolicy& out);
+    static const char* policyName(QueuePolicy policy);
+    
+    // Process messages on `count` worker threads keyed by topic (call before
+    // start()/open(); 0 = one processing thread, or poll()'s caller). With
+    // workers, onMessage callbacks run on the workers; onBatch still runs
+    // in poll().
+    void setWorkers(int count);
+    
+    // Run an exact topic only on worker `worker`. Topics that are not pinned
+    // start on the worker their hash selects, and idle workers may steal them.
+    void pinTopic(const std::string& topic, int worker);
+    
+    // Per-worker processed count, steals, queued topics and queue lag.
+    // Empty without workers. Also restarts each worker's max-lag window.
+    void getWorkerStats(std::vector<DeliveryExecutor::WorkerStats>& out);
+    
     // Start subscriber threads
     void start();
     
@@ -55,6 +207,37 @@ public:
     
     // Get subscriber ID
     int getId() const;
+    
+    // Call handler for every message on `topic` (exact name or '+'/'#'
+    // pattern). The topic is subscribed as well: on open(), or right away
+    // if already open. Register before polling; not thread-safe with poll().
+    void onMessage(const std::string& topic, MessageHandler handler);
+    
+    // Call handler once per poll() with all messages it received
+    void onBatch(BatchHandler handler);
+    
+    // Start the receive server, connect and subscribe without starting any
+    // threads (embedded use). True if already open.
+    bool open();
+    
+    // One dispatch step: wait up to timeoutMs for a message (0 = return at
+    // once), take everything already received up to MAX_BATCH and run the
+    // callbacks. Returns the number of messages dispatched, or -1 when not open.
+    int poll(int timeoutMs = 0);
+    
+    // Unsubscribe, disconnect and stop receiving (stop() does this too)
+    void close();
+    
+    // Ask the engine for the cached last values of a topic or wildcard
+    // pattern (QUERY_LAST). Call after start(). Returns the number of
+    // values received, or -1 if the query failed.
+    int queryLastValues(const std::string& topic, std::vector<Message>& out);
+    
+    // Ask the engine for a topic's retained history (REPLAY), starting at
+    // a sequence number (TopicHistory::FROM_SEQUENCE) or a timestamp in
+    // seconds (TopicHistory::FROM_TIMESTAMP). Call after start(). Returns
+    // the number of messages received, or -1 if the request failed.
+    int replayHistory(const std::string& topic, uint8_t mode, uint64_t from, std::vector<RetainedMessage>& out);
 };
 
 #endif // SUBSCRIBER_H
@@ -0,0 +1,22 @@
+#ifndef SUBSCRIBER_ADDRESS_H
+#define SUBSCRIBER_ADDRESS_H
+
+#include <vector>
+
+// Structure to hold subscriber network address
+struct SubscriberAddress {
+    int port;
+    
+    SubscriberAddress() : port(0) {}
+    explicit SubscriberAddress(int p) : port(p) {}
+    
+    bool operator==(const SubscriberAddress& other) const {
+        return port == other.port;
+    }
+};
+
+// Immutable list of everyone a publish on one topic is delivered to
+// (exact subscribers plus matching wildcard subscribers, no duplicates)
+typedef std::vector<SubscriberAddress> SubscriberSnapshot;
+
+#endif // SUBSCRIBER_ADDRESS_H
@@ -0,0 +1,106 @@
+#include "SubscriberConnectionPool.h"
+
+SubscriberConnectionPool::SubscriberConnectionPool(const std::string& subscriber_host, int idle_timeout_seconds)
+    : host(subscriber_host), idleTimeout(idle_timeout_seconds) {
+}
+
+std::shared_ptr<SubscriberConnectionPool::Entry> SubscriberConnectionPool::getEntry(int port) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    std::shared_ptr<Entry>& entry = entries[port];
+    if (!entry) {
+        entry = std::make_shared<Entry>();
+    }
+    return entry;
+}
+
+bool SubscriberConnectionPool::send(int port, const std::vector<uint8_t>& frame) {
+    std::shared_ptr<Entry> entry = getEntry(port);
+    std::lock_guard<std::mutex> lock(entry->mutex);
+
+    entry->lastUsed = std::chrono::steady_clock::now();
+
+    // Reuse the cached connection if the subscriber has not dropped it
+    if (entry->client.isConnected()) {
+        if (entry->client.isAlive() && entry->client.sendMessage(frame)) {
+            return true;
+        }
+        entry->client.disconnect();
+    }
+
+    // (Re)connect lazily
+    if (!entry->client.connect(host, port)) {
+        return false;
+    }
+
+    if (!entry->client.sendMessage(frame)) {
+        entry->client.disconnect();
+        return false;
+    }
+
+    return true;
+}
+
+void SubscriberConnectionPool::remove(int port) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto it = entries.find(port);
+        if (it == entries.end()) {
+            return;
+        }
+        entry = it->second;
+        entries.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    entry->client.disconnect();
+}
+
+int SubscriberConnectionPool::evictIdle() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Entry>> evicted;
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (auto it = entries.begin(); it != entries.end(); ) {
+            std::shared_ptr<Entry>& entry = it->second;
+
+            // Skip entries that are in use right now
+            std::unique_lock<std::mutex> entryLock(entry->mutex, std::try_to_lock);
+            if (entryLock.owns_lock() && now - entry->lastUsed > idleTimeout) {
+                entryLock.unlock();
+                evicted.push_back(entry);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Close sockets outside of the pool lock
+    for (auto& entry : evicted) {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        entry->client.disconnect();
+    }
+
+    return (int)evicted.size();
+}
+
+void SubscriberConnectionPool::clear() {
+    std::unordered_map<int, std::shared_ptr<Entry>> old;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        old.swap(entries);
+    }
+
+    for (auto& kv : old) {
+        std::lock_guard<std::mutex> lock(kv.second->mutex);
+        kv.second->client.disconnect();
+    }
+}
+
+int SubscriberConnectionPool::size() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return (int)entries.size();
+}
@@ -0,0 +1,55 @@
+#ifndef SUBSCRIBER_CONNECTION_POOL_H
+#define SUBSCRIBER_CONNECTION_POOL_H
+
+#include "../Network.h"
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Cache of persistent engine -> subscriber connections.
+// A connection is opened on first delivery to a subscriber port and reused
+// for every following message, so a delivery costs one send instead of a
+// full TCP handshake + teardown. Broken connections are re-established
+// lazily on the next delivery and idle ones are evicted periodically.
+class SubscriberConnectionPool {
+private:
+    struct Entry {
+        std::mutex mutex;                                // Serializes frames to one subscriber
+        TcpClient client;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    std::string host;
+    std::chrono::seconds idleTimeout;
+    std::mutex poolMutex;                                // Guards the entries map only
+    std::unordered_map<int, std::shared_ptr<Entry>> entries;
+
+    std::shared_ptr<Entry> getEntry(int port);
+
+public:
+    // Connections unused for longer than idle_timeout_seconds are closed by evictIdle()
+    explicit SubscriberConnectionPool(const std::string& subscriber_host = "localhost",
+                                      int idle_timeout_seconds = 30);
+
+    // Send one frame to the subscriber on the given port.
+    // Reuses the cached connection and reconnects once if it turned out to be broken.
+    bool send(int port, const std::vector<uint8_t>& frame);
+
+    // Close and forget the connection to a subscriber (e.g. after it was removed)
+    void remove(int port);
+
+    // Close connections that have not been used within the idle timeout
+    // Returns number of evicted connections
+    int evictIdle();
+
+    // Close every cached connection
+    void clear();
+
+    // Number of cached connections
+    int size();
+};
+
+#endif // SUBSCRIBER_CONNECTION_POOL_H
@@ -0,0 +1,156 @@
+#include "TopicHistory.h"
+#include "../Serialization.h"
+#include <cstring>
+
+const int TopicHistory::DEFAULT_DEPTH;
+const uint8_t TopicHistory::FROM_SEQUENCE;
+const uint8_t TopicHistory::FROM_TIMESTAMP;
+const uint8_t TopicHistory::CMD_REPLAY;
+
+TopicHistory::TopicHistory(int depth)
+    : buffer(depth < 1 ? 1 : depth), nextSeq(1) {
+}
+
+uint64_t TopicHistory::append(const Message& msg) {
+    RetainedMessage retained;
+    retained.seq = nextSeq++;
+    retained.msg = msg;
+    buffer.push(retained);
+    return retained.seq;
+}
+
+void TopicHistory::setDepth(int depth) {
+    if (depth != buffer.getCapacity()) {
+        buffer.resize(depth);
+    }
+}
+
+int TopicHistory::getDepth() const {
+    return buffer.getCapacity();
+}
+
+uint64_t TopicHistory::getNextSeq() const {
+    return nextSeq;
+}
+
+void TopicHistory::setNextSeq(uint64_t seq) {
+    nextSeq = seq;
+}
+
+void TopicHistory::collect(uint8_t mode, uint64_t from, std::vector<RetainedMessage>& out) const {
+    int count = buffer.size();
+    RetainedMessage retained;
+
+    // Sequence numbers are contiguous, so the first index is computed directly
+    int first = 0;
+    if (mode == FROM_SEQUENCE && count > 0) {
+        buffer.getAt(0, retained);
+        if (from > retained.seq) {
+            uint64_t skip = from - retained.seq;
+            first = skip >= (uint64_t)count ? count : (int)skip;
+        }
+    }
+
+    for (int i = first; i < count; i++) {
+        buffer.getAt(i, retained);
+        if (mode == FROM_TIMESTAMP && (uint64_t)retained.msg.timestamp < from) {
+            continue;
+        }
+        out.push_back(retained);
+    }
+}
+
+ReplayEncoder::ReplayEncoder(size_t maxFrameBytes)
+    : maxBytes(maxFrameBytes), count(0), total(0) {
+    beginFrame();
+}
+
+void ReplayEncoder::beginFrame() {
+    frame.clear();
+    frame.push_back(TopicHistory::CMD_REPLAY);
+    frame.push_back(0);      // last flag
+    frame.push_back(0);      // count (2)
+    frame.push_back(0);
+    count = 0;
+}
+
+void ReplayEncoder::finishFrame() {
+    storeLE16(&frame[2], (uint16_t)count);
+    frames.push_back(std::move(frame));
+}
+
+void ReplayEncoder::add(uint64_t seq, const uint8_t* message, size_t len) {
+    size_t entryBytes = 8 + 2 + len;
+    if (count > 0 && (frame.size() + entryBytes > maxBytes || count == 0xFFFF)) {
+        finishFrame();
+        beginFrame();
+    }
+
+    size_t pos = frame.size();
+    frame.resize(pos + 10);
+    storeLE64(&frame[pos], seq);
+    storeLE16(&frame[pos + 8], (uint16_t)len);
+    frame.insert(frame.end(), message, message + len);
+    count++;
+    total++;
+}
+
+std::vector<std::vector<uint8_t>> ReplayEncoder::finish() {
+    frame[1] = 1;
+    finishFrame();
+    return std::move(frames);
+}
+
+std::vector<std::vector<uint8_t>> TopicHistory::encodeReplay(const std::vector<RetainedMessage>& messages,
+                                                             size_t maxFrameBytes) {
+    ReplayEncoder encoder(maxFrameBytes);
+    std::vector<uint8_t> buffer;
+    for (const RetainedMessage& retained : messages) {
+        buffer.resize(Serialization::encodedSize(retained.msg));
+        Serialization::encode(retained.msg, buffer.data(), buffer.size());
+        encoder.add(retained.seq, buffer.data(), buffer.size());
+    }
+    return encoder.finish();
+}
+
+bool TopicHistory::decodeReplay(const std::vector<uint8_t>& frame, std::vector<RetainedMessage>& out, bool& last) {
+    if (frame.size() < 4 || frame[0] != CMD_REPLAY) {
+        return false;
+    }
+
+    last = frame[1] != 0;
+    int count = loadLE16(&frame[2]);
+    size_t pos = 4;
+
+    for (int i = 0; i < count; i++) {
+        if (pos + 10 > frame.size()) {
+            return false;
+        }
+        RetainedMessage retained;
+        retained.seq = loadLE64(&frame[pos]);
+        size_t msgLen = loadLE16(&frame[pos + 8]);
+        pos += 10;
+        if (pos + msgLen > frame.size()) {
+            return false;
+        }
+        retained.msg = Serialization::deserialize(&frame[pos], msgLen);
+        pos += msgLen;
+        out.push_back(retained);
+    }
+    return true;
+}
+
+std::vector<uint8_t> TopicHistory::makeRequest(const char* topic, uint8_t mode, uint64_t from) {
+    size_t len = strlen(topic);
+    if (len > 255) {
+        len = 255;
+    }
+
+    std::vector<uint8_t> request(10);
+    request[0] = CMD_REPLAY;
+    request[1] = mode;
+    storeLE64(&request[2], from);
+    request.push_back((uint8_t)len);
+    request.insert(request.end(), topic, topic + len);
+    return request;
+}
@@ -0,0 +1,98 @@
+#ifndef TOPIC_HISTORY_H
+#define TOPIC_HISTORY_H
+
+#include "../Message.h"
+#include "../DataStructures/CircularBuffer.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+
+// Message kept in a topic's retention buffer with its per-topic sequence number
+struct RetainedMessage {
+    uint64_t seq;
+    Message msg;
+
+    RetainedMessage() : seq(0) {}
+};
+
+// Builds REPLAY reply frames from serialized messages, starting a new frame
+// whenever the next message would not fit in maxFrameBytes. Used by
+// TopicHistory::encodeReplay and to replay straight from the message log.
+class ReplayEncoder {
+public:
+    explicit ReplayEncoder(size_t maxFrameBytes);
+
+    void add(uint64_t seq, const uint8_t* message, size_t len);
+
+    // Flag the final frame and hand over all frames (at least one); call once
+    std::vector<std::vector<uint8_t>> finish();
+
+    size_t getCount() const { return total; }
+
+private:
+    size_t maxBytes;
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint8_t> frame;
+    int count;
+    size_t total;
+
+    void beginFrame();
+    void finishFrame();
+};
+
+// Per-topic retention: the last `depth` messages, numbered 1, 2, 3, ... in
+// publish order, and the REPLAY wire format built on top of them.
+//
+// Not thread-safe; the owner serializes access (topic publish lock in the
+// unsharded engine, the shard worker in sharded mode).
+class TopicHistory {
+public:
+    static const int DEFAULT_DEPTH = 50;
+
+    // REPLAY start modes
+    static const uint8_t FROM_SEQUENCE = 0;
+    static const uint8_t FROM_TIMESTAMP = 1;
+
+    // REPLAY request: [4] [mode(1)] [from(8)] [topic_len(1)] [topic...]
+    // Multi-byte fields of requests and replies are little-endian, like
+    // protocol version 2 and the other newer commands.
+    static const uint8_t CMD_REPLAY = 4;
+
+    explicit TopicHistory(int depth = DEFAULT_DEPTH);
+
+    // Retain a message; returns its sequence number
+    uint64_t append(const Message& msg);
+
+    // Change how many messages are retained (keeps the newest)
+    void setDepth(int depth);
+    int getDepth() const;
+
+    // Sequence number the next message will get
+    uint64_t getNextSeq() const;
+
+    // Continue numbering after messages recovered from the message log
+    void setNextSeq(uint64_t seq);
+
+    // Retained messages with seq >= from (FROM_SEQUENCE) or
+    // timestamp >= from (FROM_TIMESTAMP), oldest first
+    void collect(uint8_t mode, uint64_t from, std::vector<RetainedMessage>& out) const;
+
+    // Encode retained messages as reply frames of at most maxFrameBytes each:
+    // [4] [last(1)] [count(2)] { [seq(8)] [msg_len(2)] [message] }*
+    // Always produces at least one frame; only the final one has last = 1.
+    static std::vector<std::vector<uint8_t>> encodeReplay(const std::vector<RetainedMessage>& messages,
+                                                          size_t maxFrameBytes);
+
+    // Decode one reply frame, appending to out. Sets last for the final frame.
+    static bool decodeReplay(const std::vector<uint8_t>& frame, std::vector<RetainedMessage>& out, bool& last);
+
+    // Build a REPLAY request
+    static std::vector<uint8_t> makeRequest(const char* topic, uint8_t mode, uint64_t from);
+
+private:
+    CircularBuffer<RetainedMessage> buffer;
+    uint64_t nextSeq;
+};
+
+#endif // TOPIC_HISTORY_H
@@ -0,0 +1,125 @@
+#include "TopicRegistry.h"
+#include "../MessageView.h"
+#include "../DataStructures/TopicTrie.h"
+#include <cstring>
+#include <algorithm>
+
+const uint8_t TopicRegistry::CMD_REGISTER_TOPIC;
+const uint8_t TopicRegistry::CMD_PUBLISH_ID;
+const uint32_t TopicRegistry::INVALID_ID;
+const size_t TopicRegistry::PUBLISH_ID_BYTES;
+
+uint32_t TopicRegistry::intern(const char* topic, const char* host, int port, int shard, bool& created,
+                               bool allowCreate) {
+    std::string key = std::string(host) + ":" + std::to_string(port) + "|" + topic;
+    created = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = idByKey.find(key);
+    if (it != idByKey.end()) {
+        return it->second;
+    }
+    if (!allowCreate || registrations.size() >= registrations.capacity() || registrations.size() >= INVALID_ID) {
+        return INVALID_ID;
+    }
+
+    Registration reg;
+    strncpy(reg.header.topic, topic, Message::MAX_TOPIC_LEN - 1);
+    reg.header.topic[Message::MAX_TOPIC_LEN - 1] = '\0';
+    strncpy(reg.header.publisher_host, host, Message::MAX_HOST_LEN - 1);
+    reg.header.publisher_host[Message::MAX_HOST_LEN - 1] = '\0';
+    reg.header.publisher_port = port;
+    reg.shard = shard;
+
+    uint32_t id = (uint32_t)registrations.push(std::move(reg));
+    idByKey.emplace(std::move(key), id);
+    created = true;
+    return id;
+}
+
+bool TopicRegistry::parseRegister(const std::vector<uint8_t>& frame, char* topic, size_t topicSize,
+                                  char* host, size_t hostSize, int& port) {
+    // [5][port(4)][host_len][host...][topic_len][topic...]
+    if (frame.size() < 7 || frame[0] != CMD_REGISTER_TOPIC) {
+        return false;
+    }
+    port = (int)(((uint32_t)frame[1] << 24) | ((uint32_t)frame[2] << 16) |
+                 ((uint32_t)frame[3] << 8) | (uint32_t)frame[4]);
+
+    size_t hostLen = frame[5];
+    size_t topicPos = 6 + hostLen;
+    if (hostLen >= hostSize || frame.size() <= topicPos) {
+        return false;
+    }
+    size_t topicLen = frame[topicPos];
+    if (topicLen == 0 || topicLen >= topicSize || frame.size() < topicPos + 1 + topicLen) {
+        return false;
+    }
+
+    memcpy(host, &frame[6], hostLen);
+    host[hostLen] = '\0';
+    memcpy(topic, &frame[topicPos + 1], topicLen);
+    topic[topicLen] = '\0';
+
+    // An ID names one concrete topic
+    return !TopicPattern::hasWildcards(topic);
+}
+
+std::vector<uint8_t> TopicRegistry::makeRegisterRequest(const char* topic, const char* host, int port) {
+    size_t hostLen = std::min(strlen(host), (size_t)255);
+    size_t topicLen = std::min(strlen(topic), (size_t)255);
+
+    std::vector<uint8_t> frame = {
+        CMD_REGISTER_TOPIC,
+        (uint8_t)((port >> 24) & 0xFF),
+        (uint8_t)((port >> 16) & 0xFF),
+        (uint8_t)((port >> 8) & 0xFF),
+        (uint8_t)(port & 0xFF),
+        (uint8_t)hostLen
+    };
+    frame.insert(frame.end(), host, host + hostLen);
+    frame.push_back((uint8_t)topicLen);
+    frame.insert(frame.end(), topic, topic + topicLen);
+    return frame;
+}
+
+std::vector<uint8_t> TopicRegistry::makeRegisterReply(uint32_t id) {
+    std::vector<uint8_t> frame(5);
+    frame[0] = CMD_REGISTER_TOPIC;
+    storeLE32(&frame[1], id);
+    return frame;
+}
+
+uint32_t TopicRegistry::parseRegisterReply(const std::vector<uint8_t>& frame) {
+    if (frame.size() < 5 || frame[0] != CMD_REGISTER_TOPIC) {
+        return INVALID_ID;
+    }
+    return loadLE32(&frame[1]);
+}
+
+void TopicRegistry::encodePublish(uint32_t id, const Message& msg, uint8_t* out) {
+    out[0] = CMD_PUBLISH_ID;
+    storeLE32(out + 1, id);
+    out[5] = (uint8_t)msg.type;
+    out[6] = (uint8_t)msg.topicType;
+    uint32_t bits;
+    memcpy(&bits, &msg.data, sizeof(bits));
+    storeLE32(out + 7, bits);
+    storeLE64(out + 11, (uint64_t)(int64_t)msg.timestamp);
+}
+
+uint32_t TopicRegistry::readId(const uint8_t* frame, size_t len) {
+    if (len < PUBLISH_ID_BYTES || frame[0] != CMD_PUBLISH_ID) {
+        return INVALID_ID;
+    }
+    return loadLE32(frame + 1);
+}
+
+void TopicRegistry::decodePublish(const uint8_t* frame, const Registration& reg, Message& msg) {
+    msg = reg.header;
+    msg.type = static_cast<MessageType>(frame[5]);
+    msg.topicType = static_cast<TopicType>(frame[6]);
+    uint32_t bits = loadLE32(frame + 7);
+    memcpy(&msg.data, &bits, sizeof(bits));
+    msg.timestamp = (std::time_t)(int64_t)loadLE64(frame + 11);
+}
@@ -0,0 +1,95 @@
+#ifndef TOPIC_REGISTRY_H
+#define TOPIC_REGISTRY_H
+
+#include "../Message.h"
+#include "../DataStructures/StableVector.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Topic interning for the REGISTER_TOPIC / PUBLISH_ID commands.
+//
+// A publisher registers each (topic, host, port) it publishes once and gets
+// a 32-bit ID back; afterwards its PUBLISH_ID frames carry only the ID and
+// the changing fields. The engine turns an ID back into the topic entry by
+// indexing an array, so no string is hashed or compared per message.
+// IDs are engine-wide and never reused, so they stay valid across
+// reconnects of the same publisher.
+// Because they are never freed, the engine bounds what one connection may
+// register (see PubSubEngine::handleRegister).
+//
+// Wire format:
+//   REGISTER_TOPIC: [5] [port(4, BE)] [host_len(1)] [host...] [topic_len(1)] [topic...]
+//   reply:          [5] [id(4, LE)]               (INVALID_ID if rejected)
+//   PUBLISH_ID:     [6] [id(4)] [type(1)] [topicType(1)] [data(4)] [timestamp(8)]
+//                   (fixed 19 bytes, little-endian like protocol version 2)
+//
+// intern() serializes writers internally; find() is lock-free.
+class TopicRegistry {
+public:
+    static const uint8_t CMD_REGISTER_TOPIC = 5;
+    static const uint8_t CMD_PUBLISH_ID = 6;
+    static const uint32_t INVALID_ID = 0xFFFFFFFF;
+    static const size_t PUBLISH_ID_BYTES = 19;
+
+    // What an ID stands for: the message fields that never change between
+    // publishes, and the shard owning the topic (0 when not sharded)
+    struct Registration {
+        Message header;
+        int shard;
+
+        Registration() : shard(0) {}
+    };
+
+    TopicRegistry() = default;
+
+    TopicRegistry(const TopicRegistry&) = delete;
+    TopicRegistry& operator=(const TopicRegistry&) = delete;
+
+    // ID for a topic published by host:port, assigning the next one the
+    // first time unless allowCreate is false. created is set when the ID is
+    // new. INVALID_ID if the registry is full or creating was not allowed.
+    uint32_t intern(const char* topic, const char* host, int port, int shard, bool& created,
+                    bool allowCreate = true);
+
+    // Registration behind an ID, nullptr for IDs never handed out
+    const Registration* find(uint32_t id) const {
+        return registrations.find(id);
+    }
+
+    // Registered IDs (any thread)
+    size_t size() const {
+        return registrations.size();
+    }
+
+    // Parse a REGISTER_TOPIC request. Rejects malformed frames, empty or
+    // wildcard topics and strings that do not fit the given buffers.
+    static bool parseRegister(const std::vector<uint8_t>& frame, char* topic, size_t topicSize,
+                              char* host, size_t hostSize, int& port);
+
+    static std::vector<uint8_t> makeRegisterRequest(const char* topic, const char* host, int port);
+    static std::vector<uint8_t> makeRegisterReply(uint32_t id);
+
+    // ID from a REGISTER_TOPIC reply, INVALID_ID if it is not one
+    static uint32_t parseRegisterReply(const std::vector<uint8_t>& frame);
+
+    // Write a PUBLISH_ID frame (PUBLISH_ID_BYTES) for msg's changing fields
+    static void encodePublish(uint32_t id, const Message& msg, uint8_t* out);
+
+    // ID a PUBLISH_ID frame refers to, INVALID_ID if the frame is malformed
+    static uint32_t readId(const uint8_t* frame, size_t len);
+
+    // Rebuild the full message of a PUBLISH_ID frame from its registration
+    // (frame already checked by readId)
+    static void decodePublish(const uint8_t* frame, const Registration& reg, Message& msg);
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> idByKey;   // "host:port|topic" -> ID
+    StableVector<Registration> registrations;             // Indexed by ID
+};
+
+#endif // TOPIC_REGISTRY_H
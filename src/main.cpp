@@ -1,28 +1,56 @@
 #include "core/PubSubEngine.h"
 #include "core/Publisher.h"
 #include "core/Subscriber.h"
+#include "core/LoadGenerator.h"
 #include "Network.h"
 #include "utils/CommandLineParser.h"
+#include "utils/Logger.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <chrono>
+#include <algorithm>
 
 void printUsage() {
     std::cout << "\n=== PubSub Distributed System ===" << std::endl;
     std::cout << "Usage:" << std::endl;
-    std::cout << "  ./pubsub.exe --engine" << std::endl;
+    std::cout << "  ./pubsub.exe --engine [--delivery-threads <n>] [--shards <n>] [--retention <n>] [--retention-topic <topic>=<n>] ..." << std::endl;
+    std::cout << "                     [--wal <dir> [--wal-segment-mb <n>] [--wal-sync-ms <n>] [--wal-compact-mbps <n>]]" << std::endl;
     std::cout << "    Start the PubSub Engine on port 5000" << std::endl;
+    std::cout << "    Delivery pool defaults to one thread per hardware thread" << std::endl;
+    std::cout << "    --shards hashes topics over n worker threads (default: unsharded)" << std::endl;
+    std::cout << "    --retention keeps the last n messages per topic for REPLAY (default: 50)" << std::endl;
+    std::cout << "    --wal writes every message to a durable log in <dir> and recovers it on restart" << std::endl;
+    std::cout << "    --wal-compact-mbps bounds background compaction to n MB/s (default: 4, 0 = off)" << std::endl;
     std::cout << std::endl;
-    std::cout << "  ./pubsub.exe --publisher [--port <port>] [--engine-host <host>] [--engine-port <port>]" << std::endl;
+    std::cout << "  ./pubsub.exe --publisher [--port <port>] [--engine-host <host>] [--engine-port <port>] [--batch <n> [--linger-ms <n>]]" << std::endl;
+    std::cout << "                     [--async <n> [--overflow block|drop-oldest|fail]]" << std::endl;
     std::cout << "    Start a Publisher (auto-assigned if --port not specified)" << std::endl;
+    std::cout << "    --batch sends up to n messages per PUBLISH_BATCH frame, --linger-ms caps their wait (default: 5)" << std::endl;
+    std::cout << "    --async queues publishes in an n-message outbox sent by a background thread" << std::endl;
+    std::cout << std::endl;
+    std::cout << "  ./pubsub.exe --publisher --bench [--rate <msg/s>] [--topics <n>] [--values constant|uniform|normal|sine]" << std::endl;
+    std::cout << "                     [--duration <s>] [--threads <n>] [publisher options]" << std::endl;
+    std::cout << "    Publish at a fixed rate and report throughput and send latency percentiles" << std::endl;
+    std::cout << "    Defaults: 10000 msg/s, 100 topics, uniform values, 10 s, 1 thread" << std::endl;
     std::cout << "    Default: localhost:5000" << std::endl;
     std::cout << "    Example: ./pubsub.exe --publisher --port 4101 --engine-host localhost --engine-port 5000" << std::endl;
     std::cout << std::endl;
     std::cout << "  ./pubsub.exe --subscriber --topic <topic1> [--topic <topic2>] ... [--port <port>] [--engine-host <host>] [--engine-port <port>]" << std::endl;
+    std::cout << "                     [--busy-poll] [--workers <n>] [--queue <n>] [--overflow block|drop-oldest|drop-newest|conflate]" << std::endl;
     std::cout << "    Start a Subscriber (auto-assigned if --port not specified)" << std::endl;
+    std::cout << "    --busy-poll spins on the receive queues for microsecond wake-ups (keeps two cores busy)" << std::endl;
+    std::cout << "    --workers processes topics in parallel on n threads, in order within each topic" << std::endl;
+    std::cout << "    --queue holds up to n received messages (default: 1024); --overflow says what happens when it is full:" << std::endl;
+    std::cout << "      block (default) throttles the engine over TCP, drop-* discard, conflate keeps the latest per topic" << std::endl;
     std::cout << "    Example: ./pubsub.exe --subscriber --topic \"Analog/MER/220\" --port 4201 --engine-host localhost --engine-port 5000" << std::endl;
     std::cout << std::endl;
+    std::cout << "  ./pubsub.exe --stats [--engine-host <host>] [--engine-port <port>] [--topics <n>]" << std::endl;
+    std::cout << "    Print the engine's counters, queue depths, fan-out latency and the n busiest topics (default: 100)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "  Any mode: [--log-level debug|info|warn|error|off]" << std::endl;
+    std::cout << "    debug (default) also prints every published and delivered message; info keeps lifecycle events only" << std::endl;
+    std::cout << std::endl;
     std::cout << "In any service, type 'exit' to gracefully shutdown." << std::endl;
     std::cout << "=================================\n" << std::endl;
 }
@@ -38,13 +66,41 @@ int main(int argc, char* argv[]) {
     
     std::string mode = argv[1];
     
+    // Log level applies to every mode
+    std::string logLevelName = CommandLineParser::parseCommonArgs(argc, argv, 2).logLevel;
+    LogLevel logLevel = LogLevel::DEBUG;
+    if (!Logger::parseLevel(logLevelName, logLevel)) {
+        std::cerr << "Unknown --log-level: " << logLevelName << std::endl;
+        return 1;
+    }
+    Logger::setLevel(logLevel);
+    
     // ========================= ENGINE MODE =========================
     if (mode == "--engine") {
+        auto args = CommandLineParser::parseCommonArgs(argc, argv, 2);
+        
         std::cout << "\n=== Starting PubSub Engine ===" << std::endl;
         std::cout << "Listening for publishers and subscribers..." << std::endl;
         std::cout << "Type 'exit' to shutdown." << std::endl;
         
-        PubSubEngine engine;
+        PubSubEngine engine(args.deliveryThreads, args.shards);
+        if (args.retention > 0) {
+            engine.setDefaultRetention(args.retention);
+        }
+        for (const auto& override : args.topicRetention) {
+            engine.setRetention(override.first.c_str(), override.second);
+        }
+        if (!args.walDirectory.empty()) {
+            MessageLog::Options logOptions;
+            logOptions.directory = args.walDirectory;
+            logOptions.segmentBytes = (uint32_t)std::min(std::max(args.walSegmentMb, 1), 1024) * 1024 * 1024;
+            logOptions.syncIntervalMs = args.walSyncMs;
+            uint64_t compactBytesPerSecond = (uint64_t)std::max(args.walCompactMbps, 0) * 1024 * 1024;
+            if (!engine.enableMessageLog(logOptions, compactBytesPerSecond)) {
+                std::cerr << "Failed to open message log in " << args.walDirectory << std::endl;
+                return 1;
+            }
+        }
         engine.start();
         
         // Keep running until user types 'exit'
@@ -53,6 +109,7 @@ int main(int argc, char* argv[]) {
         }
         
         engine.stop();
+        Logger::flush();
         std::cout << "Engine shutdown complete." << std::endl;
         std::cout << "\nMain thread exiting..." << std::endl;
         std::cout.flush();
@@ -64,12 +121,50 @@ int main(int argc, char* argv[]) {
     else if (mode == "--publisher") {
         auto args = CommandLineParser::parseCommonArgs(argc, argv, 2);
         
+        OverflowPolicy policy = OverflowPolicy::BLOCK;
+        if (args.asyncQueue > 0 && !PublishOutbox::parsePolicy(args.overflowPolicy, policy)) {
+            std::cerr << "Unknown --overflow policy: " << args.overflowPolicy << std::endl;
+            return 1;
+        }
+        
+        if (CommandLineParser::hasFlag(argc, argv, "--bench")) {
+            LoadGenerator::Options options;
+            options.engineHost = args.engineHost;
+            options.enginePort = args.enginePort;
+            options.basePort = args.port;
+            options.rate = args.benchRate;
+            options.topics = args.benchTopics;
+            options.durationSec = args.benchDuration;
+            options.threads = args.benchThreads;
+            options.batchSize = args.batchSize;
+            options.lingerMs = args.lingerMs;
+            options.asyncQueue = args.asyncQueue;
+            options.overflow = policy;
+            if (!LoadGenerator::parseDistribution(args.benchValues, options.values)) {
+                std::cerr << "Unknown --values distribution: " << args.benchValues << std::endl;
+                return 1;
+            }
+            
+            std::cout << "\n=== Starting Publisher Bench ===" << std::endl;
+            LoadGenerator generator(options);
+            LoadGenerator::Report report = generator.run();
+            Logger::flush();
+            LoadGenerator::printReport(options, report);
+            return 0;
+        }
+        
         std::cout << "\n=== Starting Publisher ===" << std::endl;
         std::cout << "Connecting to engine at " << args.engineHost << ":" << args.enginePort << std::endl;
         std::cout << "Publishing messages every 2 seconds..." << std::endl;
         std::cout << "Type 'exit' to shutdown." << std::endl;
         
         Publisher pub(1, args.engineHost, args.enginePort, args.port);
+        if (args.batchSize > 1) {
+            pub.enableBatching(args.batchSize, args.lingerMs);
+        }
+        if (args.asyncQueue > 0) {
+            pub.enableAsync(args.asyncQueue, policy);
+        }
         pub.start();
         
         while (!ConsoleHandler::shouldExit()) {
@@ -77,6 +172,7 @@ int main(int argc, char* argv[]) {
         }
         
         pub.stop();
+        Logger::flush();
         std::cout << "Publisher shutdown complete." << std::endl;
         std::cout << "\nMain thread exiting..." << std::endl;
         std::cout.flush();
@@ -95,6 +191,12 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
+        Subscriber::QueuePolicy queuePolicy = Subscriber::QueuePolicy::BLOCK;
+        if (!Subscriber::parsePolicy(args.overflowPolicy, queuePolicy)) {
+            std::cerr << "Unknown --overflow policy: " << args.overflowPolicy << std::endl;
+            return 1;
+        }
+        
         std::cout << "\n=== Starting Subscriber ===" << std::endl;
         std::cout << "Connecting to engine at " << args.engineHost << ":" << args.enginePort << std::endl;
         std::cout << "Subscribed to " << topics.size() << " topic(s):" << std::endl;
@@ -104,6 +206,14 @@ int main(int argc, char* argv[]) {
         std::cout << "Type 'exit' to shutdown." << std::endl;
         
         Subscriber sub(1, topics, args.engineHost, args.enginePort, args.port);
+        if (CommandLineParser::hasFlag(argc, argv, "--busy-poll")) {
+            sub.setBusyPoll(true);
+        }
+        sub.setWorkers(args.workers);
+        if (args.queueCapacity > 0) {
+            sub.setQueueCapacity((size_t)args.queueCapacity);
+        }
+        sub.setQueuePolicy(queuePolicy);
         sub.start();
         
         while (!ConsoleHandler::shouldExit()) {
@@ -111,6 +221,7 @@ int main(int argc, char* argv[]) {
         }
         
         sub.stop();
+        Logger::flush();
         std::cout << "Subscriber shutdown complete." << std::endl;
         std::cout << "\nMain thread exiting..." << std::endl;
         std::cout.flush();
@@ -118,6 +229,27 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    // ========================= STATS MODE =========================
+    else if (mode == "--stats") {
+        auto args = CommandLineParser::parseCommonArgs(argc, argv, 2);
+        
+        TcpClient client;
+        if (!client.connect(args.engineHost, args.enginePort)) {
+            std::cerr << "Failed to connect to engine at " << args.engineHost << ":" << args.enginePort << std::endl;
+            return 1;
+        }
+        
+        EngineMetrics::Snapshot snapshot;
+        if (!client.sendMessage(EngineMetrics::makeRequest(args.benchTopics)) ||
+            !EngineMetrics::decodeSnapshot(client.receiveMessage(), snapshot)) {
+            std::cerr << "Engine did not answer STATS" << std::endl;
+            return 1;
+        }
+        EngineMetrics::printSnapshot(snapshot);
+        client.disconnect();
+        return 0;
+    }
+    
     // ========================= INVALID MODE =========================
     else {
         std::cerr << "Unknown mode: " << mode << std::endl;
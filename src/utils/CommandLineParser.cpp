@@ -15,6 +15,71 @@ CommandLineArgs CommandLineParser::parseCommonArgs(int argc, char* argv[], int s
         } else if (arg == "--port") {
             args.port = std::stoi(argv[i + 1]);
             i++;
+        } else if (arg == "--delivery-threads") {
+            args.deliveryThreads = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--shards") {
+            args.shards = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--retention") {
+            args.retention = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--wal") {
+            args.walDirectory = argv[i + 1];
+            i++;
+        } else if (arg == "--wal-segment-mb") {
+            args.walSegmentMb = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--wal-compact-mbps") {
+            args.walCompactMbps = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--wal-sync-ms") {
+            args.walSyncMs = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--batch") {
+            args.batchSize = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--linger-ms") {
+            args.lingerMs = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--async") {
+            args.asyncQueue = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--overflow") {
+            args.overflowPolicy = argv[i + 1];
+            i++;
+        } else if (arg == "--rate") {
+            args.benchRate = std::stod(argv[i + 1]);
+            i++;
+        } else if (arg == "--topics") {
+            args.benchTopics = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--values") {
+            args.benchValues = argv[i + 1];
+            i++;
+        } else if (arg == "--duration") {
+            args.benchDuration = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--threads") {
+            args.benchThreads = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--workers") {
+            args.workers = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--queue") {
+            args.queueCapacity = std::stoi(argv[i + 1]);
+            i++;
+        } else if (arg == "--log-level") {
+            args.logLevel = argv[i + 1];
+            i++;
+        } else if (arg == "--retention-topic") {
+            // <topic>=<n>; split on the last '=' since topics may contain one
+            std::string value = argv[i + 1];
+            size_t eq = value.rfind('=');
+            if (eq != std::string::npos && eq > 0) {
+                args.topicRetention.push_back({value.substr(0, eq), std::stoi(value.substr(eq + 1))});
+            }
+            i++;
         }
     }
     
@@ -36,3 +101,12 @@ std::vector<std::string> CommandLineParser::parseTopics(int argc, char* argv[])
     
     return topics;
 }
+
+bool CommandLineParser::hasFlag(int argc, char* argv[], const std::string& flag) {
+    for (int i = 2; i < argc; i++) {
+        if (flag == argv[i]) {
+            return true;
+        }
+    }
+    return false;
+}
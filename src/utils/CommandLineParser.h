@@ -3,17 +3,40 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 
 struct CommandLineArgs {
     std::string engineHost = "localhost";
     int enginePort = 5000;
     int port = 0;
+    int deliveryThreads = 0;    // Engine delivery pool size (0 = hardware_concurrency)
+    int shards = 0;             // Engine topic shards (0 = unsharded)
+    int retention = 0;          // Messages retained per topic (0 = engine default)
+    std::vector<std::pair<std::string, int>> topicRetention;   // --retention-topic overrides
+    std::string walDirectory;   // Message log directory (empty = no log)
+    int walSegmentMb = 16;      // Message log segment size
+    int walSyncMs = 10;         // Message log group commit interval
+    int walCompactMbps = 4;     // Message log compaction bandwidth (0 = no compaction)
+    int batchSize = 0;          // Publisher: messages per PUBLISH_BATCH frame (0/1 = no batching)
+    int lingerMs = 5;           // Publisher: longest wait before a partial batch is sent
+    int asyncQueue = 0;         // Publisher: outbox capacity for publishAsync (0 = synchronous)
+    std::string overflowPolicy = "block";   // Full queue policy: publisher outbox (block, drop-oldest, fail) or
+                                            // subscriber receive queue (block, drop-oldest, drop-newest, conflate)
+    double benchRate = 10000;   // Publisher --bench: messages per second over all threads
+    int benchTopics = 100;      // Publisher --bench: number of topics
+    std::string benchValues = "uniform";    // Publisher --bench: constant, uniform, normal or sine
+    int benchDuration = 10;     // Publisher --bench: seconds
+    int benchThreads = 1;       // Publisher --bench: concurrent publishers
+    int workers = 0;            // Subscriber: processing workers keyed by topic (0 = one thread)
+    int queueCapacity = 0;      // Subscriber: received messages queued for processing (0 = default)
+    std::string logLevel = "debug";     // Lowest log level printed (debug, info, warn, error, off)
 };
 
 class CommandLineParser {
 public:
     static CommandLineArgs parseCommonArgs(int argc, char* argv[], int startIdx);
     static std::vector<std::string> parseTopics(int argc, char* argv[]);
+    static bool hasFlag(int argc, char* argv[], const std::string& flag);
 };
 
 #endif
@@ -0,0 +1,271 @@
+#include "Logger.h"
+#include "../DataStructures/SpscRing.h"
+#include "../DataStructures/StableVector.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+const size_t LogRecord::PAYLOAD_BYTES;
+const size_t Logger::RING_CAPACITY;
+
+std::atomic<int> Logger::threshold((int)LogLevel::DEBUG);
+
+namespace {
+
+const size_t MAX_CHANNELS = 4096;
+const std::chrono::milliseconds IDLE_WAIT(10);
+const std::chrono::milliseconds FLUSH_TIMEOUT(1000);
+
+// One producer thread's records. A channel outlives its thread: when the
+// thread exits the channel is released and handed to the next new thread,
+// so short-lived threads do not pile up rings.
+struct Channel {
+    SpscRing<LogRecord> ring;
+    std::atomic<bool> inUse;
+    std::atomic<uint64_t> dropped;
+
+    Channel() : ring(Logger::RING_CAPACITY), inUse(true), dropped(0) {}
+};
+
+struct Sink {
+    std::mutex channelsMutex;                   // Serializes channel registration
+    StableVector<Channel*, 64, 64> channels;
+
+    std::thread thread;
+    std::atomic<bool> started;
+    std::atomic<bool> running;
+
+    std::mutex waitMutex;
+    std::condition_variable wake;               // Sink: flush requested / stopping
+    std::condition_variable roundDone;          // flush(): a drain round finished
+    uint64_t rounds;                            // Completed rounds (under waitMutex)
+    bool flushRequested;
+
+    uint64_t reportedDrops;
+
+    Sink() : started(false), running(false), rounds(0), flushRequested(false), reportedDrops(0) {}
+};
+
+// Never destroyed: producer threads may still log while the process exits
+Sink& sink() {
+    static Sink* instance = new Sink();
+    return *instance;
+}
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "debug";
+        case LogLevel::INFO: return "info";
+        case LogLevel::WARN: return "warn";
+        case LogLevel::ERROR: return "error";
+        case LogLevel::OFF: return "off";
+    }
+    return "?";
+}
+
+uint64_t totalDropped(Sink& s) {
+    uint64_t total = 0;
+    size_t count = s.channels.size();
+    for (size_t i = 0; i < count; i++) {
+        total += (*s.channels.find(i))->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// Move everything queued so far into `batch`, write it in time order.
+// Returns the number of lines written.
+size_t drainOnce(Sink& s, std::vector<LogRecord>& batch) {
+    batch.clear();
+    size_t count = s.channels.size();
+    for (size_t i = 0; i < count; i++) {
+        Channel* channel = *s.channels.find(i);
+        // Bounded by the current size so a busy producer cannot starve the rest
+        size_t pending = channel->ring.size();
+        LogRecord record;
+        while (pending-- > 0 && channel->ring.pop(record)) {
+            batch.push_back(std::move(record));
+        }
+    }
+
+    if (!batch.empty()) {
+        std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) {
+            return a.timeNs < b.timeNs;
+        });
+
+        std::ostream* current = nullptr;
+        for (const LogRecord& record : batch) {
+            std::ostream& out = record.level >= LogLevel::WARN ? std::cerr : std::cout;
+            if (current != nullptr && current != &out) {
+                current->flush();
+            }
+            current = &out;
+            record.format(out, record.payload, record.size);
+            if (record.truncated) {
+                out << "...";
+            }
+            out << '\n';
+        }
+        current->flush();
+    }
+
+    uint64_t dropped = totalDropped(s);
+    if (dropped != s.reportedDrops) {
+        std::cerr << "[Logger] " << (dropped - s.reportedDrops)
+                  << " log lines dropped (per-thread ring full)" << std::endl;
+        s.reportedDrops = dropped;
+    }
+    return batch.size();
+}
+
+void sinkLoop(Sink& s) {
+    std::vector<LogRecord> batch;
+    batch.reserve(Logger::RING_CAPACITY);
+
+    while (true) {
+        bool stopping = !s.running.load(std::memory_order_acquire);
+        size_t written = drainOnce(s, batch);
+
+        {
+            std::unique_lock<std::mutex> lock(s.waitMutex);
+            s.rounds++;
+            s.roundDone.notify_all();
+
+            if (stopping) {
+                break;
+            }
+            if (written == 0 && !s.flushRequested) {
+                s.wake.wait_for(lock, IDLE_WAIT, [&s] {
+                    return s.flushRequested || !s.running.load(std::memory_order_acquire);
+                });
+            }
+            s.flushRequested = false;
+        }
+    }
+}
+
+// Registered with atexit: write what is left before the process ends
+void stopSink() {
+    Sink& s = sink();
+    {
+        std::lock_guard<std::mutex> lock(s.waitMutex);
+        s.running.store(false, std::memory_order_release);
+    }
+    s.wake.notify_all();
+    if (s.thread.joinable()) {
+        s.thread.join();
+    }
+}
+
+Channel* acquireChannel() {
+    Sink& s = sink();
+    std::lock_guard<std::mutex> lock(s.channelsMutex);
+
+    if (!s.started.load(std::memory_order_relaxed)) {
+        s.running.store(true, std::memory_order_release);
+        s.thread = std::thread(sinkLoop, std::ref(s));
+        s.started.store(true, std::memory_order_release);
+        std::atexit(stopSink);
+    }
+
+    size_t count = s.channels.size();
+    for (size_t i = 0; i < count; i++) {
+        Channel* channel = *s.channels.find(i);
+        bool expected = false;
+        if (channel->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return channel;
+        }
+    }
+
+    if (count >= MAX_CHANNELS) {
+        return nullptr;
+    }
+    Channel* channel = new Channel();
+    s.channels.push(channel);
+    return channel;
+}
+
+// Releases the thread's channel when the thread exits
+struct ChannelHolder {
+    Channel* channel;
+    bool acquired;
+
+    ChannelHolder() : channel(nullptr), acquired(false) {}
+
+    ~ChannelHolder() {
+        if (channel != nullptr) {
+            channel->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ChannelHolder holder;
+
+}
+
+void Logger::setLevel(LogLevel level) {
+    threshold.store((int)level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() {
+    return (LogLevel)threshold.load(std::memory_order_relaxed);
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& out) {
+    for (int i = (int)LogLevel::DEBUG; i <= (int)LogLevel::OFF; i++) {
+        if (name == levelName((LogLevel)i)) {
+            out = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t Logger::now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Logger::submit(LogRecord&& record) {
+    if (!holder.acquired) {
+        holder.channel = acquireChannel();
+        holder.acquired = true;
+    }
+    Channel* channel = holder.channel;
+    if (channel == nullptr) {
+        return;
+    }
+    if (!channel->ring.push(std::move(record))) {
+        channel->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::flush() {
+    Sink& s = sink();
+    if (!s.started.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(s.waitMutex);
+    if (!s.running.load(std::memory_order_acquire)) {
+        return;
+    }
+    // The round in progress may have passed our records already; wait for
+    // the one after it
+    uint64_t target = s.rounds + 2;
+    s.flushRequested = true;
+    s.wake.notify_all();
+    s.roundDone.wait_for(lock, FLUSH_TIMEOUT, [&s, target] {
+        return s.rounds >= target || !s.running.load(std::memory_order_acquire);
+    });
+}
+
+uint64_t Logger::getDroppedCount() {
+    Sink& s = sink();
+    std::lock_guard<std::mutex> lock(s.channelsMutex);
+    return totalDropped(s);
+}
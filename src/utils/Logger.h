@@ -0,0 +1,237 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <ostream>
+#include <type_traits>
+#include <initializer_list>
+
+// Log levels, lowest first. Per-message traces are DEBUG, lifecycle events
+// INFO, recoverable problems WARN, failures ERROR.
+enum class LogLevel : uint8_t {
+    DEBUG = 0,
+    INFO = 1,
+    WARN = 2,
+    ERROR = 3,
+    OFF = 4
+};
+
+// One log line with its arguments still unformatted: the call site copies
+// the raw values (numbers by value, strings by content) and a pointer to a
+// function that knows how to print them; the sink thread does the
+// formatting. Fixed size so records live in a preallocated ring.
+struct LogRecord {
+    static const size_t PAYLOAD_BYTES = 360;
+    using FormatFn = void (*)(std::ostream& out, const uint8_t* payload, size_t size);
+
+    FormatFn format;
+    uint64_t timeNs;                // Steady clock, orders lines from different threads
+    uint16_t size;                  // Payload bytes used
+    LogLevel level;
+    bool truncated;                 // Arguments did not all fit
+    uint8_t payload[PAYLOAD_BYTES];
+
+    LogRecord() : format(nullptr), timeNs(0), size(0), level(LogLevel::INFO), truncated(false) {}
+};
+
+namespace logdetail {
+
+struct Writer {
+    uint8_t* p;
+    size_t left;
+    bool truncated;
+};
+
+struct Reader {
+    const uint8_t* p;
+    size_t left;
+};
+
+// Strings: [len(2)] [bytes], cut to what fits
+inline void putString(Writer& w, const char* s, size_t len) {
+    if (w.left < 2) {
+        w.truncated = true;
+        w.left = 0;
+        return;
+    }
+    size_t n = len < w.left - 2 ? len : w.left - 2;
+    n = n < 0xFFFF ? n : 0xFFFF;
+    w.p[0] = n & 0xFF;
+    w.p[1] = (n >> 8) & 0xFF;
+    memcpy(w.p + 2, s, n);
+    w.p += 2 + n;
+    w.left -= 2 + n;
+    if (n < len) {
+        w.truncated = true;
+    }
+}
+
+inline bool printString(std::ostream& out, Reader& r) {
+    if (r.left < 2) {
+        return false;
+    }
+    size_t n = r.p[0] | (r.p[1] << 8);
+    if (r.left < 2 + n) {
+        return false;
+    }
+    out.write((const char*)r.p + 2, n);
+    r.p += 2 + n;
+    r.left -= 2 + n;
+    return true;
+}
+
+// Any other argument is copied bit for bit and printed with operator<<
+template<typename T, typename Enable = void>
+struct Codec {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "log arguments must be strings or trivially copyable values with operator<<");
+
+    static void put(Writer& w, const T& v) {
+        if (w.left < sizeof(T)) {
+            w.truncated = true;
+            w.left = 0;
+            return;
+        }
+        memcpy(w.p, &v, sizeof(T));
+        w.p += sizeof(T);
+        w.left -= sizeof(T);
+    }
+
+    static bool print(std::ostream& out, Reader& r) {
+        if (r.left < sizeof(T)) {
+            return false;
+        }
+        T v;
+        memcpy(&v, r.p, sizeof(T));
+        r.p += sizeof(T);
+        r.left -= sizeof(T);
+        out << v;
+        return true;
+    }
+};
+
+// uint8_t / int8_t would otherwise print as characters
+template<typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == 1 && !std::is_same<T, char>::value>::type> {
+    static void put(Writer& w, const T& v) {
+        Codec<int>::put(w, (int)v);
+    }
+    static bool print(std::ostream& out, Reader& r) {
+        return Codec<int>::print(out, r);
+    }
+};
+
+template<>
+struct Codec<const char*> {
+    static void put(Writer& w, const char* s) {
+        putString(w, s ? s : "(null)", s ? strlen(s) : 6);
+    }
+    static bool print(std::ostream& out, Reader& r) {
+        return printString(out, r);
+    }
+};
+
+template<>
+struct Codec<char*> : Codec<const char*> {};
+
+// Fixed char arrays (string literals, Message::topic, ...) stop at the first NUL
+template<size_t N>
+struct Codec<char[N]> {
+    static void put(Writer& w, const char (&s)[N]) {
+        putString(w, s, strnlen(s, N));
+    }
+    static bool print(std::ostream& out, Reader& r) {
+        return printString(out, r);
+    }
+};
+
+template<>
+struct Codec<std::string> {
+    static void put(Writer& w, const std::string& s) {
+        putString(w, s.data(), s.size());
+    }
+    static bool print(std::ostream& out, Reader& r) {
+        return printString(out, r);
+    }
+};
+
+template<typename... Args>
+void formatRecord(std::ostream& out, const uint8_t* payload, size_t size) {
+    Reader r = { payload, size };
+    bool ok = true;
+    (void)std::initializer_list<int>{ (ok = ok && Codec<Args>::print(out, r), 0)... };
+}
+
+}
+
+// Asynchronous logger.
+//
+// Each thread that logs gets its own lock-free SPSC ring of records on
+// first use; the call site only copies its arguments into the next slot.
+// One background sink thread drains all rings, puts the lines in time
+// order, formats them and writes them to stdout (DEBUG, INFO) or stderr
+// (WARN, ERROR) with a single flush per round. A full ring drops the line
+// rather than block the caller; drops are reported by the sink.
+//
+// Use the LOG_* macros: below the current level they cost one relaxed
+// load and a compare, and their arguments are not evaluated.
+class Logger {
+public:
+    static const size_t RING_CAPACITY = 1024;     // Records per thread
+
+    static bool isEnabled(LogLevel level) {
+        return (int)level >= threshold.load(std::memory_order_relaxed);
+    }
+
+    // Lines below `level` are discarded at the call site (default DEBUG)
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+
+    // "debug", "info", "warn", "error" or "off"
+    static bool parseLevel(const std::string& name, LogLevel& out);
+
+    // Queue one line made of the arguments printed back to back
+    template<typename... Args>
+    static void log(LogLevel level, const Args&... args) {
+        LogRecord record;
+        record.level = level;
+        record.timeNs = now();
+        record.format = &logdetail::formatRecord<Args...>;
+        logdetail::Writer w = { record.payload, LogRecord::PAYLOAD_BYTES, false };
+        (void)std::initializer_list<int>{ (logdetail::Codec<Args>::put(w, args), 0)... };
+        record.size = (uint16_t)(LogRecord::PAYLOAD_BYTES - w.left);
+        record.truncated = w.truncated;
+        submit(std::move(record));
+    }
+
+    // Wait until lines logged before the call have been written (bounded
+    // to about a second)
+    static void flush();
+
+    // Lines dropped because a thread's ring was full
+    static uint64_t getDroppedCount();
+
+private:
+    static std::atomic<int> threshold;
+
+    static uint64_t now();
+    static void submit(LogRecord&& record);
+};
+
+#define PUBSUB_LOG(level, ...) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            Logger::log(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) PUBSUB_LOG(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) PUBSUB_LOG(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) PUBSUB_LOG(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) PUBSUB_LOG(LogLevel::ERROR, __VA_ARGS__)
+
+#endif // LOGGER_H